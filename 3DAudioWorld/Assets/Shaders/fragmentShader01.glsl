@@ -1,9 +1,11 @@
 // Fragment shader
-#version 420
+#version 430
 
 in vec4 colour;
 in vec4 vertexWorldPos;			// vertex in "world space"
 in vec4 vertexWorldNormal;	
+flat in vec4 manualColourRGBA;		// This mesh's, from its entry in the vertex shader's Instances
+flat in vec4 objectFlags;			// x = do not light (passes the colour through), y = use manualColourRGBA
 
 out vec4 outputColour;		// To the frame buffer (aka screen)
 
@@ -12,20 +14,23 @@ out vec4 outputColour;		// To the frame buffer (aka screen)
 //uniform vec4 directionalLight_Direction_power;
 // xyz is the normalized direction, w = power (between 0 and 1)
 
-// If true, then passes the colour without calculating lighting
-uniform bool bDoNotLight;		// Really a float (0.0 or not zero)
-
-uniform vec4 eyeLocation;
-
-uniform bool bUseManualColour;	// if this is true, then use manualColourRGBA for the colour
-uniform vec4 manualColourRGBA;		
+// std140 block, filled by the engine (see sShaderBlocks.h). Same as in the vertex shader.
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec4 eyeLocation;
+	vec4 clusterDepthParams;	// x = near plane, y = slices / log(far / near)
+	vec4 clusterTileSize;		// xy = pixels per tile
+	ivec4 clusterCounts;		// xyz = clusters across, up, deep
+};
 
 struct sLight
 {
 	vec4 position;			
 	vec4 diffuse;	// Colour of the light (used for diffuse)
 	vec4 specular;	// rgb = highlight colour, w = power
-	vec4 atten;		// x = constant, y = linear, z = quadratic, w = DistanceCutOff
+	vec4 atten;		// x = constant, y = linear, z = quadratic, w = radius (cLight::radius)
 	vec4 direction;	// Spot, directional lights
 	vec4 param1;	// x = lightType, y = inner angle, z = outer angle, w = TBD
 	                // 0 = pointlight
@@ -38,13 +43,23 @@ const int POINT_LIGHT_TYPE = 0;
 const int SPOT_LIGHT_TYPE = 1;
 const int DIRECTIONAL_LIGHT_TYPE = 2;
 
-const int NUMBEROFLIGHTS = 15;
-uniform sLight theLights[NUMBEROFLIGHTS];  	// 70 uniforms
-//... is really:
-//uniform vec4 theLights[0].position;
-//uniform vec4 theLights[1].position;
-//uniform vec4 theLights[2].position;
-// etc...
+// Only the lights that are on, as many as the scene has (cLightManager::UpdateLightBuffer)
+layout(std430, binding = 0) readonly buffer Lights
+{
+	ivec4 lightCount;		// x = number of lights in theLights
+	sLight theLights[];
+};
+
+// The lights that can reach each cluster of the view frustum (cLightClusterGrid)
+layout(std430, binding = 1) readonly buffer LightClusters
+{
+	uvec2 clusters[];		// x = first entry in clusterLightIndices, y = number of lights
+};
+
+layout(std430, binding = 2) readonly buffer LightClusterIndices
+{
+	uint clusterLightIndices[];		// Into theLights
+};
 
 
 vec4 calculateLightContrib( vec3 vertexMaterialColour, vec3 vertexNormal, 
@@ -57,12 +72,12 @@ void main()
 
 	vec4 vertexRGBA = colour;
 	
-	if ( bUseManualColour )
+	if ( objectFlags.y != 0.0f )
 	{	
 		vertexRGBA = manualColourRGBA;
 	}
 	
-	if ( bDoNotLight )
+	if ( objectFlags.x != 0.0f )
 	{
 		outputColour = vertexRGBA;
 		return;
@@ -95,14 +110,17 @@ vec4 calculateLightContrib( vec3 vertexMaterialColour, vec3 vertexNormal,
 	
 	vec4 finalObjectColour = vec4( 0.0f, 0.0f, 0.0f, 1.0f );
 	
-	for ( int index = 0; index < NUMBEROFLIGHTS; index++ )
+	// Which cluster this fragment is in
+	float viewDepth = -(matView * vec4(vertexWorldPos, 1.0f)).z;
+	int clusterSlice = clamp( int( log( viewDepth / clusterDepthParams.x ) * clusterDepthParams.y ), 0, clusterCounts.z - 1 );
+	ivec2 clusterTile = clamp( ivec2( gl_FragCoord.xy / clusterTileSize.xy ), ivec2(0), clusterCounts.xy - 1 );
+	
+	uvec2 cluster = clusters[ clusterTile.x + clusterCounts.x * ( clusterTile.y + clusterCounts.y * clusterSlice ) ];
+	
+	// Only the lights (that are on) that reach this cluster
+	for ( uint clusterLight = 0; clusterLight < cluster.y; clusterLight++ )
 	{	
-		// ********************************************************
-		// is light "on"
-		if ( theLights[index].param2.x == 0.0f )
-		{	// it's off
-			continue;
-		}
+		int index = int( clusterLightIndices[ cluster.x + clusterLight ] );
 		
 		// Cast to an int (note with c'tor)
 		int intLightType = int(theLights[index].param1.x);
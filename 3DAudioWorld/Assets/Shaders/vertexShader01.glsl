@@ -1,25 +1,55 @@
 // Vertex shader
-#version 420
+#version 430
 
 //uniform mat4 MVP;
-uniform mat4 matView;
-uniform mat4 matProjection;
-uniform mat4 matModel;			// Later...
-uniform mat4 matModel_IT;		// Inverse transpose of the model matrix
+
+// std140 block, filled by the engine (see sShaderBlocks.h). Same as in the fragment shader.
+layout(std140, binding = 0) uniform PerFrame
+{
+	mat4 matView;
+	mat4 matProjection;
+	vec4 eyeLocation;
+	vec4 clusterDepthParams;	// x = near plane, y = slices / log(far / near)
+	vec4 clusterTileSize;		// xy = pixels per tile
+	ivec4 clusterCounts;		// xyz = clusters across, up, deep
+};
+
+struct sInstance
+{
+	mat4 matModel;
+	mat4 matModel_IT;		// Inverse transpose of the model matrix
+	vec4 manualColourRGBA;
+	vec4 objectFlags;		// x = do not light, y = use manualColourRGBA
+};
+
+// Every mesh drawn this frame, the meshes of one draw next to each other
+layout(std430, binding = 3) readonly buffer Instances
+{
+	sInstance instances[];
+};
+
+// This draw's first mesh in instances (gl_InstanceID starts at 0 every draw)
+uniform int instanceBase;
 
 //uniform vec3 modelScale;
 //uniform vec3 modelOffset;
 
-in vec4 vCol;		// was vec3
-in vec4 vPos;		// was vec3
-in vec4 vNormal;	// NEW for 2023!
+// Matches any of the engine's vertex formats (see cVertexFormat) :
+//	float or half float position, float or 10:10:10:2 normal, float or RGBA8 colour
+in vec4 vCol;
+in vec3 vPos;
+in vec3 vNormal;
 
 out vec4 colour;
 out vec4 vertexWorldPos;	
 out vec4 vertexWorldNormal;
+flat out vec4 manualColourRGBA;
+flat out vec4 objectFlags;
 
 void main()
 {
+	mat4 matModel = instances[instanceBase + gl_InstanceID].matModel;
+	mat4 matModel_IT = instances[instanceBase + gl_InstanceID].matModel_IT;
 	
 //	gl_Position = MVP * vec4(finalPos, 1.0);
 //	gl_Position = MVP * vertModelPosition;
@@ -36,4 +66,6 @@ void main()
 	vertexWorldPos = matModel * vec4( vPos.xyz, 1.0f);
 	
 	colour = vCol;
+	manualColourRGBA = instances[instanceBase + gl_InstanceID].manualColourRGBA;
+	objectFlags = instances[instanceBase + gl_InstanceID].objectFlags;
 }
@@ -14,6 +14,7 @@ struct sAudioModels
 	float modelScale = 0;
 
 	const char* modelName = "";
+	unsigned int modelHandle = ~0u;		// From cControlGameEngine::LoadModelsInto3DSpace
 	const char* audioPath = "";
 
 	FMOD::DSP* reverbDSP;
@@ -76,6 +76,15 @@ bool cJsonReader::ReadScene(const std::string& filePath, std::vector <sModelDeta
 		newModelDetails.modelColorRGB.b = modelDetails["Color"][2].GetFloat();
 		newModelDetails.physicsMeshType = modelDetails["PhysicsMesh"].GetString();
 
+		if (modelDetails.HasMember("LODScreenSizes"))
+		{
+			for (SizeType lodIndex = 0; lodIndex < modelDetails["LODScreenSizes"].Size(); lodIndex++)
+				newModelDetails.lodScreenSizes.push_back(modelDetails["LODScreenSizes"][lodIndex].GetFloat());
+		}
+
+		if (modelDetails.HasMember("Parent"))
+			newModelDetails.parentModelName = modelDetails["Parent"].GetString();
+
 		differentModelDetails.push_back(newModelDetails);
 	}
 
@@ -24,6 +24,12 @@ struct sModelDetailsFromFile
 	glm::vec3 modelPosition;
 	glm::quat modelOrientation;
 	glm::vec3 modelColorRGB;
+
+	// Optional "LODScreenSizes", empty uses the engine's defaults
+	std::vector<float> lodScreenSizes;
+
+	// Optional "Parent" model, empty for none. Position, rotation and scale are then relative to it.
+	std::string parentModelName;
 };
 
 // This struct is created to imitate the physics variables in the json file
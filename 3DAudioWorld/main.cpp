@@ -7,6 +7,9 @@
 
 #include <cControlGameEngine.h>
 
+#include <chrono>
+#include <future>
+
 static void error_callback(int error, const char* description)
 {
     fprintf(stderr, "Error: %s\n", description);
@@ -69,14 +72,14 @@ void updateAudio()
         {
             if (glm::distance(currentCamPosition, currentAudioModel->modelPosition) < offset_value)
             {
-                float modelScale = gameEngine.GetModelScaleValue(modelName);
+                float modelScale = gameEngine.GetModelScaleValue(currentAudioModel->modelHandle);
 
                 if (modelScale <= currentAudioModel->modelScale)
                     modelScale = currentAudioModel->modelScale + 1.f;
 
                 modelScale *= 0.99f;
 
-                gameEngine.ScaleModel(modelName, modelScale);
+                gameEngine.ScaleModel(currentAudioModel->modelHandle, modelScale);
 
                 //----------------------------If Audio is not playing-------------------------------------
 
@@ -150,7 +153,7 @@ void updateAudio()
                 {
                     audioManager.StopAudio(currentAudioModel->channelId);
 
-                    gameEngine.ScaleModel(modelName, currentAudioModel->modelScale);
+                    gameEngine.ScaleModel(currentAudioModel->modelHandle, currentAudioModel->modelScale);
 
                     currentAudioModel->isPlaying = false;
 
@@ -168,6 +171,8 @@ void beginAnimation();
 
 int main()
 {
+    std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+
     //-----------------------------------Initialize Window--------------------------------------
 
     int result = 0;
@@ -177,8 +182,10 @@ int main()
     if (!glfwInit())
         exit(EXIT_FAILURE);
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 2);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    // The shaders are #version 430 (the per object data is a shader storage buffer)
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     window = glfwCreateWindow(800, 600, "Simple example", NULL, NULL);
 
@@ -195,7 +202,16 @@ int main()
     glfwSetCursorPosCallback(window, mouse_callback);
 
     glfwMakeContextCurrent(window);
-    gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress) || !GLAD_GL_VERSION_4_3)
+    {
+        std::cout << "OpenGL 4.3 is needed (shader storage buffers), this context is " << GLVersion.major << "." << GLVersion.minor << std::endl;
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        exit(EXIT_FAILURE);
+    }
+
     glfwSwapInterval(1);
 
     //--------------------------------Initialize Game Engine----------------------------------------
@@ -211,54 +227,86 @@ int main()
 
     audioManager.Initialize();
 
-    for(int index = 0; index < audioPathList.size(); index++)
-        audioManager.Load3DAudio(audioPathList[index].c_str());
+    // Audio loads on its own thread while the scene's models are being read
+    std::future<double> audioLoading = std::async(std::launch::async, [&audioPathList]()
+        {
+            std::chrono::steady_clock::time_point audioStart = std::chrono::steady_clock::now();
+
+            for (std::size_t index = 0; index < audioPathList.size(); index++)
+                audioManager.Load3DAudio(audioPathList[index].c_str());
+
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - audioStart).count();
+        });
 
     //--------------------------------Loading Models, Lights and initial camera position from Json file---------------------------------------------
 
+    std::chrono::steady_clock::time_point sceneReadStart = std::chrono::steady_clock::now();
+
     bool jsonresult = jsonReader.ReadScene("SceneDescription.json", modelDetailsList, physicsDetailsList, lightDetailsList, camDetails);
 
+    double sceneReadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - sceneReadStart).count();
+
     if (jsonresult)
     {
         std::cout << "File read successfully !" << std::endl;
 
+        // Every file is read on the worker threads and uploaded before the models are set up
+        std::vector<std::string> modelFileList;
+
+        for (std::size_t index = 0; index < modelDetailsList.size(); index++)
+            modelFileList.push_back(modelDetailsList[index].modelFilePath);
+
+        sModelLoadTimings modelTimings = gameEngine.PreloadModelFiles(modelFileList);
+
+        // Needed before the walls are added as occlusion polygons
+        double audioLoadTime = audioLoading.get();
+
+        std::chrono::steady_clock::time_point sceneSetupStart = std::chrono::steady_clock::now();
+
         std::string modelName;
-        int lightId;
+        unsigned int modelHandle;
+        unsigned int lightHandle;
 
         // Loading Models
         for (int index = 0; index < modelDetailsList.size(); index++)
         {
             modelName = modelDetailsList[index].modelName;
 
-            gameEngine.LoadModelsInto3DSpace(modelDetailsList[index].modelFilePath, modelName,
+            modelHandle = gameEngine.LoadModelsInto3DSpace(modelDetailsList[index].modelFilePath, modelName,
                 modelDetailsList[index].modelPosition.x, modelDetailsList[index].modelPosition.y, modelDetailsList[index].modelPosition.z);
 
+            if (modelHandle == cControlGameEngine::INVALID_MODEL_HANDLE)
+                continue;
+
             float angleRadians = glm::radians(modelDetailsList[index].modelOrientation.w);
 
-            gameEngine.RotateMeshModel(modelName, angleRadians, modelDetailsList[index].modelOrientation.x,
+            gameEngine.RotateMeshModel(modelHandle, angleRadians, modelDetailsList[index].modelOrientation.x,
                 modelDetailsList[index].modelOrientation.y, modelDetailsList[index].modelOrientation.z);
 
-            gameEngine.ScaleModel(modelName, modelDetailsList[index].modelScaleValue);
+            gameEngine.ScaleModel(modelHandle, modelDetailsList[index].modelScaleValue);
 
             if (modelDetailsList[index].wireframeModeOn)
-                gameEngine.TurnWireframeModeOn(modelName);
+                gameEngine.TurnWireframeModeOn(modelHandle);
 
             if (modelDetailsList[index].meshLightsOn)
-                gameEngine.TurnMeshLightsOn(modelName);
+                gameEngine.TurnMeshLightsOn(modelHandle);
+
+            if (!modelDetailsList[index].lodScreenSizes.empty())
+                gameEngine.ChangeModelLODScreenSizes(modelHandle, modelDetailsList[index].lodScreenSizes);
 
             if (modelDetailsList[index].manualColors)
             {
-                gameEngine.UseManualColors(modelName, true);
-                gameEngine.ChangeColor(modelName, modelDetailsList[index].modelColorRGB.x, modelDetailsList[index].modelColorRGB.y, modelDetailsList[index].modelColorRGB.z);
+                gameEngine.UseManualColors(modelHandle, true);
+                gameEngine.ChangeColor(modelHandle, modelDetailsList[index].modelColorRGB.x, modelDetailsList[index].modelColorRGB.y, modelDetailsList[index].modelColorRGB.z);
             }
             
             //---------------------Adding occlusion to walls--------------------------------
 
             if (modelDetailsList[index].physicsMeshType == "Wall")
             {
-                glm::vec3 modelPos = gameEngine.GetModelPosition(modelName);
+                glm::vec3 modelPos = gameEngine.GetModelPosition(modelHandle);
 
-                audioManager.AddPolygon(gameEngine.GetModelVertices(modelName), modelPos);
+                audioManager.AddPolygon(gameEngine.GetModelVertices(modelHandle), modelPos);
             }
 
             //----------------------------Loading Audio------------------------------------
@@ -268,6 +316,7 @@ int main()
                 sAudioModels newAudioModel;
 
                 newAudioModel.modelName = modelDetailsList[index].modelName.c_str();
+                newAudioModel.modelHandle = modelHandle;
                 newAudioModel.isPlaying = false;
                 newAudioModel.modelPosition = modelDetailsList[index].modelPosition;
                 newAudioModel.modelScale = modelDetailsList[index].modelScaleValue;
@@ -290,30 +339,67 @@ int main()
             }
         }
 
+        // Attaching children (once every model is loaded, so a parent can come after its child)
+        for (std::size_t index = 0; index < modelDetailsList.size(); index++)
+        {
+            if (modelDetailsList[index].parentModelName.empty())
+                continue;
+
+            if (!gameEngine.AttachModelToParent(modelDetailsList[index].modelName, modelDetailsList[index].parentModelName))
+                std::cout << "Cannot attach " << modelDetailsList[index].modelName << " to its parent " << modelDetailsList[index].parentModelName << std::endl;
+        }
+
         // Loading Lights
         for (int index = 0; index < lightDetailsList.size(); index++)
         {
-            lightId = lightDetailsList[index].lightId;
-
-            gameEngine.CreateLight(lightId, lightDetailsList[index].lightPosition.x, lightDetailsList[index].lightPosition.y, lightDetailsList[index].lightPosition.z);
-            gameEngine.ChangeLightType(lightId, lightDetailsList[index].lightType);
-            gameEngine.ChangeLightIntensity(lightId, lightDetailsList[index].linearAttenuation, lightDetailsList[index].quadraticAttenuation);
-            gameEngine.ChangeLightDirection(lightId, lightDetailsList[index].lightDirection.x, lightDetailsList[index].lightDirection.y, lightDetailsList[index].lightDirection.z);
-            gameEngine.ChangeLightColour(lightId, lightDetailsList[index].lightColorRGB.r, lightDetailsList[index].lightColorRGB.g, lightDetailsList[index].lightColorRGB.b);
-            gameEngine.ChangeLightAngle(lightId, lightDetailsList[index].innerAngle, lightDetailsList[index].outerAngle);
+            lightHandle = gameEngine.CreateLight(lightDetailsList[index].lightPosition.x, lightDetailsList[index].lightPosition.y, lightDetailsList[index].lightPosition.z);
+            gameEngine.ChangeLightType(lightHandle, lightDetailsList[index].lightType);
+            gameEngine.ChangeLightIntensity(lightHandle, lightDetailsList[index].linearAttenuation, lightDetailsList[index].quadraticAttenuation);
+            gameEngine.ChangeLightDirection(lightHandle, lightDetailsList[index].lightDirection.x, lightDetailsList[index].lightDirection.y, lightDetailsList[index].lightDirection.z);
+            gameEngine.ChangeLightColour(lightHandle, lightDetailsList[index].lightColorRGB.r, lightDetailsList[index].lightColorRGB.g, lightDetailsList[index].lightColorRGB.b);
+            gameEngine.ChangeLightAngle(lightHandle, lightDetailsList[index].innerAngle, lightDetailsList[index].outerAngle);
 
             if (lightDetailsList[index].lightOn)
-                gameEngine.TurnOffLight(lightId, false);
+                gameEngine.TurnOffLight(lightHandle, false);
             else
-                gameEngine.TurnOffLight(lightId, true);
+                gameEngine.TurnOffLight(lightHandle, true);
         }
 
         // Loading Initial Camera Position
         gameEngine.MoveCameraPosition(camDetails.initialCameraPosition.x, camDetails.initialCameraPosition.y, camDetails.initialCameraPosition.z);
+
+        // The wall polygons are built, the vertex arrays are only on the GPU from here
+        std::size_t geometryBytesFreed = gameEngine.ReleaseModelGeometry();
+
+        //--------------------------------Startup Timings-----------------------------------------
+
+        std::chrono::steady_clock::time_point startupEnd = std::chrono::steady_clock::now();
+
+        double sceneSetupTime = std::chrono::duration<double>(startupEnd - sceneSetupStart).count();
+        double startupTime = std::chrono::duration<double>(startupEnd - startupStart).count();
+
+        printf("Startup : %.1f ms total\n", startupTime * 1000.0);
+        printf("  Scene file     : %.1f ms\n", sceneReadTime * 1000.0);
+        printf("  Model read     : %.1f ms (%u files, %u threads)\n", modelTimings.readTime * 1000.0, modelTimings.numberOfFiles, modelTimings.numberOfThreads);
+        printf("  Model upload   : %.1f ms\n", modelTimings.uploadTime * 1000.0);
+        printf("  Audio (thread) : %.1f ms\n", audioLoadTime * 1000.0);
+        printf("  Scene setup    : %.1f ms\n", sceneSetupTime * 1000.0);
+        printf("  CPU geometry   : %.1f KB released\n", geometryBytesFreed / 1024.0);
+
+        sGeometryArenaStats arenaStats = gameEngine.GetGeometryArenaStats();
+
+        printf("Geometry arena : %u models | vertices %.1f / %.1f KB | indices %.1f / %.1f KB | growths %u\n",
+            arenaStats.numberOfAllocations,
+            arenaStats.vertexBytesUsed / 1024.0, arenaStats.vertexBytesCapacity / 1024.0,
+            arenaStats.indexBytesUsed / 1024.0, arenaStats.indexBytesCapacity / 1024.0,
+            arenaStats.numberOfGrowths);
     }
 
     else
+    {
+        audioLoading.wait();
         return -1;
+    }
 
     //-------------------------------Frame loop---------------------------------------------
 
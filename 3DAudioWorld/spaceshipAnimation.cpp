@@ -26,7 +26,7 @@ void endAnimation(sAudioModels* spaceShipAudioModel)
     spaceShipAudioModel->modelVelocity = glm::vec3(0.0f, 0.0f, -5.0f);
     spaceShipAudioModel->modelAcceleration = glm::vec3(0.0f, 0.0f, -9.8f);
 
-    gameEngine.MoveModel(spaceShipAudioModel->modelName, spaceShipAudioModel->modelPosition.x, spaceShipAudioModel->modelPosition.y, spaceShipAudioModel->modelPosition.z);
+    gameEngine.MoveModel(spaceShipAudioModel->modelHandle, spaceShipAudioModel->modelPosition.x, spaceShipAudioModel->modelPosition.y, spaceShipAudioModel->modelPosition.z);
 
     animationRunning = false;
     animationTime = glfwGetTime();
@@ -41,13 +41,13 @@ void moveSpaceship(sAudioModels* spaceShipAudioModel)
     spaceShipAudioModel->modelVelocity += velocityChange;
 
     glm::vec3 positionChange = spaceShipAudioModel->modelVelocity * (float)gameEngine.deltaTime;
-    glm::vec3 modelPos = gameEngine.GetModelPosition(spaceShipAudioModel->modelName);
+    glm::vec3 modelPos = gameEngine.GetModelPosition(spaceShipAudioModel->modelHandle);
 
     modelPos.x += positionChange.x;
     modelPos.y += positionChange.y;
     modelPos.z += positionChange.z;
 
-    gameEngine.MoveModel(spaceShipAudioModel->modelName, modelPos.x, modelPos.y, modelPos.z);
+    gameEngine.MoveModel(spaceShipAudioModel->modelHandle, modelPos.x, modelPos.y, modelPos.z);
 
     FMOD_VECTOR fmodPos;
     FMOD_VECTOR fmodVel;
@@ -0,0 +1,13 @@
+#ifndef _SSECommon_HG_
+#define _SSECommon_HG_
+
+// ENGINE_USE_SSE is 1 where SSE2 is always there: MSVC x64, Win32 with /arch:SSE2
+//	(the default), or gcc / clang with -msse2. The scalar code is used otherwise.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ENGINE_USE_SSE 1
+	#include <emmintrin.h>
+#else
+	#define ENGINE_USE_SSE 0
+#endif
+
+#endif
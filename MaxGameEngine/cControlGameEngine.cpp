@@ -6,145 +6,234 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
 #include <sstream>
 
 //-------------------------------------------------Private Functions-----------------------------------------------------------------------
 
-cMesh* cControlGameEngine::g_pFindMeshByFriendlyName(std::string friendlyNameToFind)
+cMesh* cControlGameEngine::FindMeshByHandle(unsigned int modelHandle)
 {
-    for (unsigned int index = 0; index != TotalMeshList.size(); index++)
-    {
-        if (TotalMeshList[index]->friendlyName == friendlyNameToFind)
-        {
-            return TotalMeshList[index];
-        }
-    }
-
-    std::cout << "Cannot find mesh model for the name provided : " << friendlyNameToFind << std::endl;
+    sModelSlot* modelSlot = modelTable.Get(modelHandle);
 
-    return NULL;
+    return (modelSlot != NULL) ? modelSlot->pMesh : NULL;
 }
 
-sModelDrawInfo* cControlGameEngine::g_pFindModelInfoByFriendlyName(std::string friendlyNameToFind)
+sPhysicsProperties* cControlGameEngine::FindPhysicalModelByHandle(unsigned int modelHandle)
 {
-    for (unsigned int index = 0; index != MeshDrawInfoList.size(); index++)
-    {
-        if (MeshDrawInfoList[index]->friendlyName == friendlyNameToFind)
-        {
-            return MeshDrawInfoList[index];
-        }
-    }
+    sModelSlot* modelSlot = modelTable.Get(modelHandle);
 
-    std::cout << "Cannot find model info for the name provided : " << friendlyNameToFind << std::endl;
-
-    return NULL;
+    return (modelSlot != NULL) ? modelSlot->pPhysics : NULL;
 }
 
-sPhysicsProperties* cControlGameEngine::FindPhysicalModelByName(std::string modelName)
+void cControlGameEngine::FillObjectBlock(cMesh* pCurrentMesh, sPerObjectBlock& objectBlock)
 {
-    for (unsigned int index = 0; index != PhysicsModelList.size(); index++)
-    {
-        if (PhysicsModelList[index]->modelName == modelName)
-        {
-            return PhysicsModelList[index];
-        }
-    }
+    //-------------------------Per Object Block--------------------------------------------------------
 
-    std::cout << "Cannot find physical mesh model for the name provided : " << modelName << std::endl;
+    // Worked out by transformHierarchy.Update, parents included
+    objectBlock.matModel = pCurrentMesh->getWorldMatrix();
 
-    return NULL;
+    objectBlock.matModel_IT = pCurrentMesh->getWorldNormalMatrix();
+
+    objectBlock.manualColourRGBA = pCurrentMesh->wholeObjectManualColourRGBA;
+
+    objectBlock.objectFlags = glm::vec4((pCurrentMesh->bDoNotLight ? 1.0f : 0.0f), (pCurrentMesh->bUseManualColours ? 1.0f : 0.0f), 0.0f, 0.0f);
+
+    //-------------------------Level of Detail------------------------------------------------------
+
+    if (pCurrentMesh->pModelDrawInfo != NULL)
+        SelectLOD(pCurrentMesh, objectBlock.matModel);
+
+    return;
 }
 
-void cControlGameEngine::DrawObject(cMesh* pCurrentMesh, glm::mat4 matModelParent, GLuint shaderProgramID)
+void cControlGameEngine::BuildInstanceGroups(const glm::mat4& matView)
 {
-    //--------------------------Calculate Matrix Model Transformation--------------------------------
+    drawOrder.clear();
+    instanceGroups.clear();
 
-    glm::mat4 matModel = matModelParent;
+    renderQueue.Clear();
 
-    glm::mat4 matTranslate = glm::translate(glm::mat4(1.0f),
-        glm::vec3(pCurrentMesh->drawPosition.x, pCurrentMesh->drawPosition.y, pCurrentMesh->drawPosition.z));
+    // View depth of the mesh's origin (the model matrix's translation)
+    glm::vec4 viewDepthRow = -glm::vec4(matView[0][2], matView[1][2], matView[2][2], matView[3][2]);
 
-    glm::mat4 matRotation = glm::mat4(pCurrentMesh->get_qOrientation());
+    for (unsigned int index = 0; index != drawList.size(); index++)
+    {
+        // Nothing to draw
+        if (drawList[index]->pModelDrawInfo == NULL)
+            continue;
 
-    glm::mat4 matScale = glm::scale(glm::mat4(1.0f),
-        glm::vec3(pCurrentMesh->drawScale.x, pCurrentMesh->drawScale.y, pCurrentMesh->drawScale.z));
+        float viewDepth = glm::dot(viewDepthRow, objectBlocks[index].matModel[3]);
 
-    matModel = matModel * matTranslate;
+        renderQueue.Add(cRenderQueue::MakeSortKey(shaderProgramID, drawList[index], viewDepth), index);
+    }
 
-    matModel = matModel * matRotation;
+    // Same VAO, polygon mode, model and LOD next to each other, front to back inside those
+    renderQueue.Sort();
 
-    matModel = matModel * matScale;
+    for (unsigned int item = 0; item != renderQueue.getNumberOfItems(); item++)
+        drawOrder.push_back(renderQueue.getItem(item));
 
-    //-------------------------Get Model Info--------------------------------------------------------
+    for (unsigned int instance = 0; instance != drawOrder.size(); instance++)
+    {
+        cMesh* pCurrentMesh = drawList[drawOrder[instance]];
 
-    GLint matModel_UL = glGetUniformLocation(shaderProgramID, "matModel");
-    glUniformMatrix4fv(matModel_UL, 1, GL_FALSE, glm::value_ptr(matModel));
+        if (instancingEnabled && !instanceGroups.empty())
+        {
+            const cMesh* pGroupMesh = instanceGroups.back().pFirstMesh;
 
-    glm::mat4 matModel_InverseTranspose = glm::inverse(glm::transpose(matModel));
+            if (pGroupMesh->pModelDrawInfo == pCurrentMesh->pModelDrawInfo &&
+                pGroupMesh->currentLOD == pCurrentMesh->currentLOD &&
+                pGroupMesh->bIsWireframe == pCurrentMesh->bIsWireframe)
+            {
+                instanceGroups.back().numberOfInstances++;
+                continue;
+            }
+        }
 
-    GLint matModel_IT_UL = glGetUniformLocation(shaderProgramID, "matModel_IT");
-    glUniformMatrix4fv(matModel_IT_UL, 1, GL_FALSE, glm::value_ptr(matModel_InverseTranspose));
+        sInstanceGroup newGroup;
 
-    // ---------------------Check Light and Wireframe-------------------------------------------------
+        newGroup.pFirstMesh = pCurrentMesh;
+        newGroup.firstInstance = instance;
+        newGroup.numberOfInstances = 1;
 
-    GLint bDoNotLight_UL = glGetUniformLocation(shaderProgramID, "bDoNotLight");
+        instanceGroups.push_back(newGroup);
+    }
 
-    if (pCurrentMesh->bIsWireframe)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    else
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    return;
+}
 
-    if (pCurrentMesh->bDoNotLight)
-        glUniform1f(bDoNotLight_UL, (GLfloat)GL_TRUE);
-    else
-        glUniform1f(bDoNotLight_UL, (GLfloat)GL_FALSE);
+void cControlGameEngine::DrawInstances(const sInstanceGroup& instanceGroup)
+{
+    cMesh* pCurrentMesh = instanceGroup.pFirstMesh;
 
-    //-------------------------Get Debug Color from Shader----------------------------------------
+    // ---------------------Check Wireframe-------------------------------------------------
 
-    GLint bUseManualColour_UL = glGetUniformLocation(shaderProgramID, "bUseManualColour");
+    GLenum polygonMode = pCurrentMesh->bIsWireframe ? GL_LINE : GL_FILL;
 
-    if (pCurrentMesh->bUseManualColours)
+    if (polygonMode != boundPolygonMode)
     {
-        glUniform1f(bUseManualColour_UL, (GLfloat)GL_TRUE);
+        glPolygonMode(GL_FRONT_AND_BACK, polygonMode);
 
-        GLint manualColourRGBA_UL = glGetUniformLocation(shaderProgramID, "manualColourRGBA");
-        glUniform4f(manualColourRGBA_UL,
-            pCurrentMesh->wholeObjectManualColourRGBA.r,
-            pCurrentMesh->wholeObjectManualColourRGBA.g,
-            pCurrentMesh->wholeObjectManualColourRGBA.b,
-            pCurrentMesh->wholeObjectManualColourRGBA.a);
+        boundPolygonMode = polygonMode;
+        frameStats.numberOfPolygonModeChanges++;
     }
     else
-        glUniform1f(bUseManualColour_UL, (GLfloat)GL_FALSE);
+        frameStats.numberOfPolygonModeChangesAvoided++;
 
     //-------------------------Find Model Info and Draw----------------------------------------
 
-    sModelDrawInfo modelInfo;
+    sModelDrawInfo* modelInfo = pCurrentMesh->pModelDrawInfo;
 
-    if (mVAOManager->FindDrawInfoByModelName(pCurrentMesh->friendlyName, modelInfo))
+    if (modelInfo != NULL)
     {
-        // Found it!!!
+        GLenum indexType = (modelInfo->indexType == INDEX_TYPE_UINT16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-        glBindVertexArray(modelInfo.VAO_ID);
-        glDrawElements(GL_TRIANGLES,
-            modelInfo.numberOfIndices,
-            GL_UNSIGNED_INT,
-            0);
-        glBindVertexArray(0);
+        // Picked by FillObjectBlock, the same for the whole group
+        unsigned int lodIndex = pCurrentMesh->currentLOD;
 
-    }
+        sMeshLOD lod = modelInfo->getLOD(lodIndex);
 
-    //-------------------------Remove Scaling----------------------------------------
+        // Models in the same geometry arena share the VAO, only bind it when it changes
+        if (modelInfo->VAO_ID != boundVAO)
+        {
+            glBindVertexArray(modelInfo->VAO_ID);
 
-    glm::mat4 matRemoveScaling = glm::scale(glm::mat4(1.0f),
-        glm::vec3(1.0f / pCurrentMesh->drawScale.x, 1.0f / pCurrentMesh->drawScale.y, 1.0f / pCurrentMesh->drawScale.z));
+            boundVAO = modelInfo->VAO_ID;
+            frameStats.numberOfVAOBinds++;
+        }
+        else
+            frameStats.numberOfVAOBindsAvoided++;
 
-    matModel = matModel * matRemoveScaling;
+        // The group's first entry in the Instances array (gl_InstanceID counts from 0)
+        pShaderProgram->setUniform(instanceBaseUniform, (int)instanceGroup.firstInstance);
 
+        // Start indices are where the model sits in the arena's buffers (0 for models with their own)
+        if (modelInfo->vecSubMeshes.empty())
+        {
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                lod.numberOfIndices,
+                indexType,
+                (void*)((size_t)modelInfo->indexSize * (modelInfo->IndexBuffer_Start_Index + lod.firstIndex)),
+                instanceGroup.numberOfInstances,
+                modelInfo->VertexBuffer_Start_Index);
+
+            frameStats.numberOfDrawCalls++;
+        }
+        else
+        {
+            // Big 16 bit meshes, each piece has its own base vertex
+            for (unsigned int index = lod.firstSubMesh; index != lod.firstSubMesh + lod.numberOfSubMeshes; index++)
+            {
+                const sSubMesh& subMesh = modelInfo->vecSubMeshes[index];
+
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES,
+                    subMesh.numberOfIndices,
+                    indexType,
+                    (void*)((size_t)modelInfo->indexSize * (modelInfo->IndexBuffer_Start_Index + subMesh.firstIndex)),
+                    instanceGroup.numberOfInstances,
+                    modelInfo->VertexBuffer_Start_Index + subMesh.baseVertex);
+
+                frameStats.numberOfDrawCalls++;
+            }
+        }
+
+        frameStats.numberOfMeshesDrawn += instanceGroup.numberOfInstances;
+        frameStats.numberOfTriangles += (lod.numberOfIndices / 3) * instanceGroup.numberOfInstances;
+        frameStats.numberOfFullDetailTriangles += modelInfo->numberOfTriangles * instanceGroup.numberOfInstances;
+        frameStats.numberOfMeshesPerLOD[std::min(lodIndex, 3u)] += instanceGroup.numberOfInstances;
+    }
 
     return;
 }
 
+unsigned int cControlGameEngine::SelectLOD(cMesh* pCurrentMesh, const glm::mat4& matModel)
+{
+    sModelDrawInfo* modelInfo = pCurrentMesh->pModelDrawInfo;
+
+    unsigned int numberOfLODs = modelInfo->getNumberOfLODs();
+
+    if (numberOfLODs == 1)
+    {
+        pCurrentMesh->currentLOD = 0;
+        return 0;
+    }
+
+    //---------------Projected size of the bounding sphere----------------------------
+
+    glm::vec3 centre = glm::vec3(matModel * glm::vec4(modelInfo->boundingSphereCentre, 1.0f));
+
+    float largestScale = std::max(glm::length(glm::vec3(matModel[0])), std::max(glm::length(glm::vec3(matModel[1])), glm::length(glm::vec3(matModel[2]))));
+
+    float radius = modelInfo->boundingSphereRadius * largestScale;
+
+    float distance = glm::length(centre - cameraEye);
+
+    // Fraction of the viewport height the sphere covers
+    float screenSize = (distance > radius) ? radius / (distance * tanf(fieldOfView * 0.5f)) : FLT_MAX;
+
+    //---------------Step through the thresholds with hysteresis----------------------
+
+    const std::vector<float>& lodScreenSizes = pCurrentMesh->vecLODScreenSizes.empty() ? defaultLODScreenSizes : pCurrentMesh->vecLODScreenSizes;
+
+    unsigned int lastLOD = std::min(numberOfLODs - 1, (unsigned int)lodScreenSizes.size());
+
+    unsigned int lodIndex = std::min(pCurrentMesh->currentLOD, lastLOD);
+
+    while (lodIndex < lastLOD && screenSize < lodScreenSizes[lodIndex] * (1.0f - lodHysteresis))
+        lodIndex++;
+
+    while (lodIndex > 0 && screenSize > lodScreenSizes[lodIndex - 1] * (1.0f + lodHysteresis))
+        lodIndex--;
+
+    pCurrentMesh->currentLOD = lodIndex;
+
+    return lodIndex;
+}
+
 int cControlGameEngine::InitializeShader()
 {
     mShaderManager = new cShaderManager();
@@ -164,6 +253,44 @@ int cControlGameEngine::InitializeShader()
 
     shaderProgramID = mShaderManager->getIDFromFriendlyName("shader01");
 
+    pShaderProgram = mShaderManager->pGetShaderProgramFromFriendlyName("shader01");
+
+    //---------------------------Uniform blocks--------------------------------------------------
+
+    // The C++ structs have to match the shader's std140 / std430 layout byte for byte
+    int lightsOffset = -1;
+    int lightsStride = -1;
+
+    pShaderProgram->getBufferVariableLayout("theLights[0].position", lightsOffset, lightsStride);
+
+    int instancesOffset = -1;
+    int instancesStride = -1;
+
+    pShaderProgram->getBufferVariableLayout("instances[0].matModel", instancesOffset, instancesStride);
+
+    if (pShaderProgram->getUniformBlockSize("PerFrame") != (int)sizeof(sPerFrameBlock) ||
+        lightsOffset != (int)sizeof(sLightBufferHeader) || lightsStride != (int)sizeof(sLightBlockEntry) ||
+        instancesOffset != 0 || instancesStride != (int)sizeof(sPerObjectBlock))
+    {
+        std::cout << "Error: shader01's uniform / storage blocks don't match sShaderBlocks.h" << std::endl;
+        return -1;
+    }
+
+    perFrameBuffer.Create();
+
+    glBindBuffer(GL_UNIFORM_BUFFER, perFrameBuffer.getID());
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(sPerFrameBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Grows if a frame draws more
+    instanceRing.Create(sizeof(sPerObjectBlock), 1024, true);
+
+    if (!pShaderProgram->getUniformHandle("instanceBase", instanceBaseUniform))
+    {
+        std::cout << "Error: shader01 has no instanceBase uniform" << std::endl;
+        return -1;
+    }
+
     return 0;
 }
 
@@ -209,92 +336,183 @@ glm::vec3 cControlGameEngine::GetCurrentCameraUpVector()
 
 //--------------------------------------Mesh Controls-----------------------------------------------------------------
 
-void cControlGameEngine::ChangeColor(std::string modelName, float r, float g, float b)
+unsigned int cControlGameEngine::GetModelHandle(const std::string& modelName)
 {
-    cMesh* meshToBeScaled = g_pFindMeshByFriendlyName(modelName);
+    unsigned int modelHandle = modelNameIndex.Find(modelName);
 
-    meshToBeScaled->wholeObjectManualColourRGBA = glm::vec4(r, g, b, 1.0f);
+    // Not reported here, callers decide whether a missing name is an error
+    if (modelHandle == cNameIndex::NOT_FOUND)
+        return INVALID_MODEL_HANDLE;
+
+    return modelHandle;
 }
 
-void cControlGameEngine::UseManualColors(std::string modelName, bool useColor)
+void cControlGameEngine::ChangeColor(unsigned int modelHandle, float r, float g, float b)
 {
-    cMesh* meshToBeScaled = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshToBeColoured = FindMeshByHandle(modelHandle);
+
+    if (meshToBeColoured == NULL)
+        return;
+
+    meshToBeColoured->wholeObjectManualColourRGBA = glm::vec4(r, g, b, 1.0f);
+}
+
+void cControlGameEngine::ChangeColor(const std::string& modelName, float r, float g, float b)
+{
+    ChangeColor(GetModelHandle(modelName), r, g, b);
+}
+
+void cControlGameEngine::UseManualColors(unsigned int modelHandle, bool useColor)
+{
+    cMesh* meshToBeColoured = FindMeshByHandle(modelHandle);
+
+    if (meshToBeColoured == NULL)
+        return;
 
     if (useColor)
-        meshToBeScaled->bUseManualColours = true;
+        meshToBeColoured->bUseManualColours = true;
     else
-        meshToBeScaled->bUseManualColours = false;
+        meshToBeColoured->bUseManualColours = false;
 }
 
-void cControlGameEngine::ScaleModel(std::string modelName, float scale_value)
+void cControlGameEngine::UseManualColors(const std::string& modelName, bool useColor)
 {
-    cMesh* meshToBeScaled = g_pFindMeshByFriendlyName(modelName);
+    UseManualColors(GetModelHandle(modelName), useColor);
+}
+
+void cControlGameEngine::ScaleModel(unsigned int modelHandle, float scale_value)
+{
+    cMesh* meshToBeScaled = FindMeshByHandle(modelHandle);
+
+    if (meshToBeScaled == NULL)
+        return;
 
     meshToBeScaled->setUniformDrawScale(scale_value);
 }
 
-void cControlGameEngine::MoveModel(std::string modelName, float translate_x, float translate_y, float translate_z)
+void cControlGameEngine::ScaleModel(const std::string& modelName, float scale_value)
+{
+    ScaleModel(GetModelHandle(modelName), scale_value);
+}
+
+void cControlGameEngine::MoveModel(unsigned int modelHandle, float translate_x, float translate_y, float translate_z)
 {
-    cMesh* meshToBeTranslated = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshToBeTranslated = FindMeshByHandle(modelHandle);
+
+    if (meshToBeTranslated == NULL)
+        return;
 
     const glm::vec3& position = glm::vec3(translate_x, translate_y, translate_z);
 
     meshToBeTranslated->setDrawPosition(position);
 }
 
-glm::vec3 cControlGameEngine::GetModelPosition(std::string modelName)
+void cControlGameEngine::MoveModel(const std::string& modelName, float translate_x, float translate_y, float translate_z)
 {
-    cMesh* meshPosition = g_pFindMeshByFriendlyName(modelName);
+    MoveModel(GetModelHandle(modelName), translate_x, translate_y, translate_z);
+}
+
+glm::vec3 cControlGameEngine::GetModelPosition(unsigned int modelHandle)
+{
+    cMesh* meshPosition = FindMeshByHandle(modelHandle);
+
+    if (meshPosition == NULL)
+        return glm::vec3(0.0f);
 
     return meshPosition->getDrawPosition();
 }
 
-float cControlGameEngine::GetModelScaleValue(std::string modelName)
+glm::vec3 cControlGameEngine::GetModelPosition(const std::string& modelName)
+{
+    return GetModelPosition(GetModelHandle(modelName));
+}
+
+float cControlGameEngine::GetModelScaleValue(unsigned int modelHandle)
 {
-    cMesh* meshScaleValue = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshScaleValue = FindMeshByHandle(modelHandle);
+
+    if (meshScaleValue == NULL)
+        return 0.0f;
 
     return meshScaleValue->drawScale.x;
 }
 
-std::vector<glm::vec3> cControlGameEngine::GetModelVertices(std::string modelName)
+float cControlGameEngine::GetModelScaleValue(const std::string& modelName)
 {
-    sModelDrawInfo* modelToDraw =  g_pFindModelInfoByFriendlyName(modelName);
-    cMesh* modelMesh = g_pFindMeshByFriendlyName(modelName);
+    return GetModelScaleValue(GetModelHandle(modelName));
+}
 
-    std::vector <glm::vec3> model3DVertices;
+bool cControlGameEngine::GetModelWorldAABB(unsigned int modelHandle, glm::vec3& minXYZ, glm::vec3& maxXYZ)
+{
+    cMesh* meshFound = FindMeshByHandle(modelHandle);
 
-    for (unsigned int index = 0; index < modelToDraw->numberOfVertices; index ++)
-    {
-        //---------------Calculate vertex position-----------------------------
+    if (meshFound == NULL)
+        return false;
 
-        glm::vec3 verts;
+    // In case it (or a parent) moved since the last frame. Just its own subtree.
+    transformHierarchy.UpdateMesh(meshFound);
 
-        verts.x = modelToDraw->pVertices[index].x;
-        verts.y = modelToDraw->pVertices[index].y;
-        verts.z = modelToDraw->pVertices[index].z;
+    meshFound->getWorldAABB(minXYZ, maxXYZ);
+
+    return true;
+}
+
+bool cControlGameEngine::GetModelWorldAABB(const std::string& modelName, glm::vec3& minXYZ, glm::vec3& maxXYZ)
+{
+    return GetModelWorldAABB(GetModelHandle(modelName), minXYZ, maxXYZ);
+}
+
+bool cControlGameEngine::GetModelBoundingSphere(unsigned int modelHandle, glm::vec3& centre, float& radius)
+{
+    cMesh* meshFound = FindMeshByHandle(modelHandle);
+
+    if (meshFound == NULL)
+        return false;
+
+    transformHierarchy.UpdateMesh(meshFound);
+
+    meshFound->getWorldBoundingSphere(centre, radius);
+
+    return true;
+}
+
+bool cControlGameEngine::GetModelBoundingSphere(const std::string& modelName, glm::vec3& centre, float& radius)
+{
+    return GetModelBoundingSphere(GetModelHandle(modelName), centre, radius);
+}
+
+std::vector<glm::vec3> cControlGameEngine::GetModelVertices(unsigned int modelHandle)
+{
+    cMesh* modelMesh = FindMeshByHandle(modelHandle);
 
-        //----------------Convert to world space------------------------------
+    sModelDrawInfo* modelToDraw = (modelMesh != NULL) ? modelMesh->pModelDrawInfo : NULL;
 
-        glm::mat4 matModel = glm::mat4(1.0f);
+    std::vector <glm::vec3> model3DVertices;
 
-        glm::mat4 matTranslate = glm::translate(glm::mat4(1.0f),
-            glm::vec3(modelMesh->drawPosition.x, modelMesh->drawPosition.y, modelMesh->drawPosition.z));
+    if (modelToDraw == NULL || modelToDraw->pVertices == NULL)
+    {
+        std::cout << "Vertices of " << ((modelMesh != NULL) ? modelMesh->friendlyName : "the model") << " aren't available (the model geometry was released)" << std::endl;
+        return model3DVertices;
+    }
 
-        glm::mat4 matRotateX = glm::rotate(glm::mat4(1.0f), modelMesh->drawOrientation.x, glm::vec3(1.0f, 0.0, 0.0f));
+    //----------------Convert to world space------------------------------
 
-        glm::mat4 matRotateY = glm::rotate(glm::mat4(1.0f), modelMesh->drawOrientation.y, glm::vec3(0.0f, 1.0, 0.0f));
+    // Parents included
+    transformHierarchy.UpdateMesh(modelMesh);
 
-        glm::mat4 matRotateZ = glm::rotate(glm::mat4(1.0f), modelMesh->drawOrientation.z, glm::vec3(0.0f, 0.0, 1.0f));
+    const glm::mat4& matModel = modelMesh->getWorldMatrix();
 
-        glm::mat4 matScale = glm::scale(glm::mat4(1.0f), glm::vec3(modelMesh->drawScale.x, modelMesh->drawScale.y, modelMesh->drawScale.z));
+    model3DVertices.reserve(modelToDraw->numberOfVertices);
 
-        matModel = matModel * matTranslate;
+    for (unsigned int index = 0; index < modelToDraw->numberOfVertices; index ++)
+    {
+        //---------------Calculate vertex position-----------------------------
 
-        matModel = matModel * matRotateX;
-        matModel = matModel * matRotateY;
-        matModel = matModel * matRotateZ;
+        glm::vec3 verts;
 
-        matModel = matModel * matScale;
+        verts.x = modelToDraw->pVertices[index].x;
+        verts.y = modelToDraw->pVertices[index].y;
+        verts.z = modelToDraw->pVertices[index].z;
 
         glm::vec4 vertsWorld;
 
@@ -306,9 +524,17 @@ std::vector<glm::vec3> cControlGameEngine::GetModelVertices(std::string modelNam
     return model3DVertices;
 }
 
-void cControlGameEngine::RotateMeshModel(std::string modelName, float angleRadians, float rotate_x, float rotate_y, float rotate_z)
+std::vector<glm::vec3> cControlGameEngine::GetModelVertices(const std::string& modelName)
 {
-    cMesh* meshToBeRotated = g_pFindMeshByFriendlyName(modelName);
+    return GetModelVertices(GetModelHandle(modelName));
+}
+
+void cControlGameEngine::RotateMeshModel(unsigned int modelHandle, float angleRadians, float rotate_x, float rotate_y, float rotate_z)
+{
+    cMesh* meshToBeRotated = FindMeshByHandle(modelHandle);
+
+    if (meshToBeRotated == NULL)
+        return;
 
     glm::quat rotation = glm::quat(angleRadians, rotate_x, rotate_y, rotate_z);
 
@@ -317,9 +543,17 @@ void cControlGameEngine::RotateMeshModel(std::string modelName, float angleRadia
     //meshToBeRotated->setRotationFromEuler(rotation);
 }
 
-void cControlGameEngine::TurnVisibilityOn(std::string modelName)
+void cControlGameEngine::RotateMeshModel(const std::string& modelName, float angleRadians, float rotate_x, float rotate_y, float rotate_z)
+{
+    RotateMeshModel(GetModelHandle(modelName), angleRadians, rotate_x, rotate_y, rotate_z);
+}
+
+void cControlGameEngine::TurnVisibilityOn(unsigned int modelHandle)
 {
-    cMesh* meshVisibility = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshVisibility = FindMeshByHandle(modelHandle);
+
+    if (meshVisibility == NULL)
+        return;
 
     if (meshVisibility->bIsVisible != true)
         meshVisibility->bIsVisible = true;
@@ -327,9 +561,17 @@ void cControlGameEngine::TurnVisibilityOn(std::string modelName)
         meshVisibility->bIsVisible = false;
 }
 
-void cControlGameEngine::TurnWireframeModeOn(std::string modelName)
+void cControlGameEngine::TurnVisibilityOn(const std::string& modelName)
+{
+    TurnVisibilityOn(GetModelHandle(modelName));
+}
+
+void cControlGameEngine::TurnWireframeModeOn(unsigned int modelHandle)
 {
-    cMesh* meshWireframe = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshWireframe = FindMeshByHandle(modelHandle);
+
+    if (meshWireframe == NULL)
+        return;
 
     if (meshWireframe->bIsWireframe == true)
         meshWireframe->bIsWireframe = false;
@@ -337,9 +579,17 @@ void cControlGameEngine::TurnWireframeModeOn(std::string modelName)
         meshWireframe->bIsWireframe = true;
 }
 
-void cControlGameEngine::TurnMeshLightsOn(std::string modelName)
+void cControlGameEngine::TurnWireframeModeOn(const std::string& modelName)
+{
+    TurnWireframeModeOn(GetModelHandle(modelName));
+}
+
+void cControlGameEngine::TurnMeshLightsOn(unsigned int modelHandle)
 {
-    cMesh* meshLights = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshLights = FindMeshByHandle(modelHandle);
+
+    if (meshLights == NULL)
+        return;
 
     if (meshLights->bDoNotLight == true)
         meshLights->bDoNotLight = false;
@@ -347,22 +597,59 @@ void cControlGameEngine::TurnMeshLightsOn(std::string modelName)
         meshLights->bDoNotLight = true;
 }
 
-void cControlGameEngine::DeleteMesh(std::string modelName)
+void cControlGameEngine::TurnMeshLightsOn(const std::string& modelName)
+{
+    TurnMeshLightsOn(GetModelHandle(modelName));
+}
+
+void cControlGameEngine::DeleteMesh(unsigned int modelHandle)
 {
-    cMesh* meshModel = g_pFindMeshByFriendlyName(modelName);
+    sModelSlot* modelSlot = modelTable.Get(modelHandle);
+
+    if (modelSlot == NULL)
+        return;
+
+    cMesh* meshModel = modelSlot->pMesh;
 
-    sPhysicsProperties* physicalModel = FindPhysicalModelByName(modelName);
+    sPhysicsProperties* physicalModel = modelSlot->pPhysics;
 
-    sModelDrawInfo* modelInfo = g_pFindModelInfoByFriendlyName(modelName);
+    // Another model may have been loaded under the same name
+    if (modelNameIndex.Find(meshModel->friendlyName) == modelHandle)
+        modelNameIndex.Erase(meshModel->friendlyName);
 
-    if (meshModel != NULL)
-        TotalMeshList.erase(std::remove(TotalMeshList.begin(), TotalMeshList.end(), meshModel), TotalMeshList.end());
+    // Its handle stops working from here
+    modelTable.Remove(modelHandle);
+
+    TotalMeshList.erase(std::remove(TotalMeshList.begin(), TotalMeshList.end(), meshModel), TotalMeshList.end());
+
+    // The model data is only freed once the last mesh using the file is gone
+    if (meshModel->pModelDrawInfo != NULL)
+        mVAOManager->ReleaseModel(meshModel->meshName);
+
+    meshModel->pModelDrawInfo = NULL;
+
+    // Checked once at the start of the next frame, not per unload
+    geometryArenaCompactionPending = true;
+
+    // Its children stay, as roots
+    transformHierarchy.RemoveMesh(meshModel);
+
+    delete meshModel;
+
+    if (meshListIndex >= (int)TotalMeshList.size())
+        meshListIndex = 0;
 
     if (physicalModel != NULL)
+    {
         PhysicsModelList.erase(std::remove(PhysicsModelList.begin(), PhysicsModelList.end(), physicalModel), PhysicsModelList.end());
 
-    if (modelInfo != NULL)
-        MeshDrawInfoList.erase(std::remove(MeshDrawInfoList.begin(), MeshDrawInfoList.end(), modelInfo), MeshDrawInfoList.end());
+        delete physicalModel;
+    }
+}
+
+void cControlGameEngine::DeleteMesh(const std::string& modelName)
+{
+    DeleteMesh(GetModelHandle(modelName));
 }
 
 cMesh* cControlGameEngine::ShiftToNextMeshInList()
@@ -394,145 +681,254 @@ cMesh* cControlGameEngine::GetCurrentModelSelected()
     return TotalMeshList[meshListIndex];
 }
 
-void cControlGameEngine::ShiftToNextLightInList()
+void cControlGameEngine::ChangeModelLODScreenSizes(unsigned int modelHandle, std::vector<float> lodScreenSizes)
+{
+    cMesh* meshModel = FindMeshByHandle(modelHandle);
+
+    if (meshModel == NULL)
+        return;
+
+    meshModel->vecLODScreenSizes = lodScreenSizes;
+}
+
+void cControlGameEngine::ChangeModelLODScreenSizes(const std::string& modelName, std::vector<float> lodScreenSizes)
 {
-    lightListIndex++;
+    ChangeModelLODScreenSizes(GetModelHandle(modelName), lodScreenSizes);
+}
+
+sGeometryArenaStats cControlGameEngine::GetGeometryArenaStats()
+{
+    return mVAOManager->GetGeometryArenaStats();
+}
 
-    if (lightListIndex > 10)
-        lightListIndex = 0;
+sLightClusterStats cControlGameEngine::GetLightClusterStats()
+{
+    return lightClusterGrid.getLastStats();
+}
+
+sFrustumCullStats cControlGameEngine::GetFrustumCullStats()
+{
+    return frustumCuller.getLastStats();
 }
 
-int cControlGameEngine::GetCurrentLightSelected()
+sRenderQueueStats cControlGameEngine::GetRenderQueueStats()
+{
+    return renderQueue.getLastStats();
+}
+
+sTransformHierarchyStats cControlGameEngine::GetTransformHierarchyStats()
+{
+    return transformHierarchy.getLastStats();
+}
+
+sFrameStats cControlGameEngine::GetFrameStats()
+{
+    return frameStats;
+}
+
+void cControlGameEngine::ShiftToNextLightInList()
+{
+    lightListIndex = mLightManager->getNextLight(lightListIndex);
+}
+
+unsigned int cControlGameEngine::GetCurrentLightSelected()
 {
     return lightListIndex;
 }
 
 //--------------------------------------Lights Controls-----------------------------------------------------------------
 
-void cControlGameEngine::CreateLight(int lightId, float initial_x, float initial_y, float initial_z)
+unsigned int cControlGameEngine::CreateLight(float initial_x, float initial_y, float initial_z)
 {
-    if (lightId > 15)
-    {
-        std::cout << "Light Id is more than 15 ! Cannot create light !" << std::endl;
-        return;
-    }
-    std::cout << "Light : " << lightId << " Created !" << std::endl;
+    unsigned int lightHandle = mLightManager->AddLight();
+
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    std::cout << "Light : " << lightHandle << " Created !" << std::endl;
 
-    mLightManager->SetUniformLocations(shaderProgramID, lightId);
+    pLight->param2.x = 1.0f; // Turn on
 
-    mLightManager->theLights[lightId].param2.x = 1.0f; // Turn on
+    pLight->param1.x = 2.0f;   // 0 = point light , 1 = spot light , 2 = directional light
 
-    mLightManager->theLights[lightId].param1.x = 2.0f;   // 0 = point light , 1 = spot light , 2 = directional light
+    pLight->param1.y = 50.0f; // inner angle
 
-    mLightManager->theLights[lightId].param1.y = 50.0f; // inner angle
+    pLight->param1.z = 50.0f; // outer angle
 
-    mLightManager->theLights[lightId].param1.z = 50.0f; // outer angle
+    pLight->position.x = initial_x;
 
-    mLightManager->theLights[lightId].position.x = initial_x;
+    pLight->position.y = initial_y;
 
-    mLightManager->theLights[lightId].position.y = initial_y;
+    pLight->position.z = initial_z;
 
-    mLightManager->theLights[lightId].position.z = initial_z;
+    pLight->direction = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
 
-    mLightManager->theLights[lightId].direction = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
+    pLight->atten.x = 0.0f;        // Constant attenuation
 
-    mLightManager->theLights[lightId].atten.x = 0.0f;        // Constant attenuation
+    pLight->atten.y = 0.1f;        // Linear attenuation
 
-    mLightManager->theLights[lightId].atten.y = 0.1f;        // Linear attenuation
+    pLight->atten.z = 0.0f;        // Quadratic attenuation
 
-    mLightManager->theLights[lightId].atten.z = 0.0f;        // Quadratic attenuation
+    if (lightListIndex == cLightManager::INVALID_LIGHT_HANDLE)
+        lightListIndex = lightHandle;
+
+    return lightHandle;
 }
 
-void cControlGameEngine::TurnOffLight(int lightId, bool turnOff)
+void cControlGameEngine::DeleteLight(unsigned int lightHandle)
 {
+    mLightManager->RemoveLight(lightHandle);
+
+    if (lightListIndex == lightHandle)
+        lightListIndex = mLightManager->getNextLight(lightHandle);
+}
+
+unsigned int cControlGameEngine::GetNumberOfLights()
+{
+    return mLightManager->getNumberOfLights();
+}
+
+void cControlGameEngine::TurnOffLight(unsigned int lightHandle, bool turnOff)
+{
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    if (pLight == NULL)
+        return;
+
     if (turnOff)
-        mLightManager->theLights[lightId].param2.x = 0.0f;
+        pLight->param2.x = 0.0f;
     else
-        mLightManager->theLights[lightId].param2.x = 1.0f;
+        pLight->param2.x = 1.0f;
 }
 
-void cControlGameEngine::PositionLight(int lightId, float translate_x, float translate_y, float translate_z)
+void cControlGameEngine::PositionLight(unsigned int lightHandle, float translate_x, float translate_y, float translate_z)
 {
-    mLightManager->theLights[lightId].position.x = translate_x;
+    cLight* pLight = mLightManager->getLight(lightHandle);
 
-    mLightManager->theLights[lightId].position.y = translate_y;
+    if (pLight == NULL)
+        return;
+
+    pLight->position.x = translate_x;
 
-    mLightManager->theLights[lightId].position.z = translate_z;
+    pLight->position.y = translate_y;
+
+    pLight->position.z = translate_z;
 }
 
-void cControlGameEngine::ChangeLightIntensity(int lightId, float linearAttentuation, float quadraticAttentuation)
+void cControlGameEngine::ChangeLightIntensity(unsigned int lightHandle, float linearAttentuation, float quadraticAttentuation)
 {
-    mLightManager->theLights[lightId].atten.y = linearAttentuation;
+    cLight* pLight = mLightManager->getLight(lightHandle);
 
-    mLightManager->theLights[lightId].atten.z = quadraticAttentuation;
+    if (pLight == NULL)
+        return;
+
+    pLight->atten.y = linearAttentuation;
+
+    pLight->atten.z = quadraticAttentuation;
 }
 
-void cControlGameEngine::ChangeLightType(int lightId, float lightType)
+void cControlGameEngine::ChangeLightType(unsigned int lightHandle, float lightType)
 {
-    mLightManager->theLights[lightId].param1.x = lightType;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    if (pLight == NULL)
+        return;
+
+    pLight->param1.x = lightType;
 }
 
-void cControlGameEngine::ChangeLightAngle(int lightId, float innerAngle, float outerAngle)
+void cControlGameEngine::ChangeLightAngle(unsigned int lightHandle, float innerAngle, float outerAngle)
 {
-    mLightManager->theLights[lightId].param1.y = innerAngle; // inner angle
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    if (pLight == NULL)
+        return;
 
-    mLightManager->theLights[lightId].param1.z = outerAngle; // outer angle
+    pLight->param1.y = innerAngle; // inner angle
+
+    pLight->param1.z = outerAngle; // outer angle
 }
 
-void cControlGameEngine::ChangeLightDirection(int lightId, float direction_x, float direction_y, float direction_z)
+void cControlGameEngine::ChangeLightDirection(unsigned int lightHandle, float direction_x, float direction_y, float direction_z)
 {
-    mLightManager->theLights[lightId].direction = glm::vec4(direction_x, direction_y, direction_z, 1.0f);
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    if (pLight == NULL)
+        return;
 
+    pLight->direction = glm::vec4(direction_x, direction_y, direction_z, 1.0f);
 }
 
-void cControlGameEngine::ChangeLightColour(int lightId, float color_r, float color_g, float color_b)
+void cControlGameEngine::ChangeLightColour(unsigned int lightHandle, float color_r, float color_g, float color_b)
 {
-    mLightManager->theLights[lightId].diffuse = glm::vec4(color_r, color_g, color_b, 1.0f);
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    if (pLight == NULL)
+        return;
+
+    pLight->diffuse = glm::vec4(color_r, color_g, color_b, 1.0f);
 }
 
-glm::vec3 cControlGameEngine::GetLightPosition(int lightId)
+glm::vec3 cControlGameEngine::GetLightPosition(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].position;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? glm::vec3(pLight->position) : glm::vec3(0.0f);
 }
 
-glm::vec3 cControlGameEngine::GetLightDirection(int lightId)
+glm::vec3 cControlGameEngine::GetLightDirection(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].direction;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? glm::vec3(pLight->direction) : glm::vec3(0.0f);
 }
 
-float cControlGameEngine::GetLightLinearAttenuation(int lightId)
+float cControlGameEngine::GetLightLinearAttenuation(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].atten.y;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->atten.y : 0.0f;
 }
 
-float cControlGameEngine::GetLightQuadraticAttenuation(int lightId)
+float cControlGameEngine::GetLightQuadraticAttenuation(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].atten.z;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->atten.z : 0.0f;
 }
 
-float cControlGameEngine::GetLightType(int lightId)
+float cControlGameEngine::GetLightType(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].param1.x;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->param1.x : 0.0f;
 }
 
-float cControlGameEngine::GetLightInnerAngle(int lightId)
+float cControlGameEngine::GetLightInnerAngle(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].param1.y;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->param1.y : 0.0f;
 }
 
-float cControlGameEngine::GetLightOuterAngle(int lightId)
+float cControlGameEngine::GetLightOuterAngle(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].param1.z;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->param1.z : 0.0f;
 }
 
-glm::vec3 cControlGameEngine::GetLightColor(int lightId)
+glm::vec3 cControlGameEngine::GetLightColor(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].diffuse;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? glm::vec3(pLight->diffuse) : glm::vec3(0.0f);
 }
 
-float cControlGameEngine::IsLightOn(int lightId)
+float cControlGameEngine::IsLightOn(unsigned int lightHandle)
 {
-    return mLightManager->theLights[lightId].param2.x;
+    cLight* pLight = mLightManager->getLight(lightHandle);
+
+    return (pLight != NULL) ? pLight->param2.x : 0.0f;
 }
 
 //--------------------------------------Physics Controls---------------------------------------------------------------
@@ -543,7 +939,7 @@ void  cControlGameEngine::ComparePhysicalAttributesWithOtherModels()
     {
         if (PhysicsModelList[physicalModelCount]->physicsMeshType == "Sphere")
         {
-            sPhysicsProperties* spherePhysicalModel = FindPhysicalModelByName(PhysicsModelList[physicalModelCount]->modelName);
+            sPhysicsProperties* spherePhysicalModel = PhysicsModelList[physicalModelCount];
 
             if (spherePhysicalModel != NULL)
             {
@@ -554,10 +950,10 @@ void  cControlGameEngine::ComparePhysicalAttributesWithOtherModels()
                     else
                     {
                         if (PhysicsModelList[anotherModelCount]->physicsMeshType == "Plane" || PhysicsModelList[anotherModelCount]->physicsMeshType == "Box")
-                            MakePhysicsHappen(spherePhysicalModel, PhysicsModelList[anotherModelCount]->modelName, PhysicsModelList[anotherModelCount]->physicsMeshType);
+                            MakePhysicsHappen(spherePhysicalModel, PhysicsModelList[anotherModelCount]->modelHandle, PhysicsModelList[anotherModelCount]->physicsMeshType);
 
                         else if (PhysicsModelList[anotherModelCount]->physicsMeshType == "Sphere")
-                            MakePhysicsHappen(spherePhysicalModel, PhysicsModelList[anotherModelCount]->modelName, PhysicsModelList[anotherModelCount]->physicsMeshType);
+                            MakePhysicsHappen(spherePhysicalModel, PhysicsModelList[anotherModelCount]->modelHandle, PhysicsModelList[anotherModelCount]->physicsMeshType);
                     }
                 }               
             }
@@ -572,7 +968,7 @@ void cControlGameEngine::ResetPosition(sPhysicsProperties* physicsModel)
     physicsModel->position.z = getRandomFloat(0.0, 20.0);;
     physicsModel->sphereProps->velocity = glm::vec3(0.0f, -getRandomFloat(1.0, 5.0), 0.0f);
 
-    ChangeColor(physicsModel->modelName, 1.0, 1.0, 1.0); //Reseting spheres to white again
+    ChangeColor(physicsModel->modelHandle, 1.0, 1.0, 1.0); //Reseting spheres to white again
 }
 
 void cControlGameEngine::AnimateTheCubes()
@@ -595,18 +991,18 @@ void cControlGameEngine::AnimateTheCubes()
     {
         if (boxModelCount % 2 == checkerValue)
         {
-            ChangeModelPhysicsPosition(boxModelList[boxModelCount]->modelName, boxModelList[boxModelCount]->position.x + offsetValue,
+            ChangeModelPhysicsPosition(boxModelList[boxModelCount]->modelHandle, boxModelList[boxModelCount]->position.x + offsetValue,
                 boxModelList[boxModelCount]->position.y, boxModelList[boxModelCount]->position.z);
 
-            MoveModel(boxModelList[boxModelCount]->modelName, boxModelList[boxModelCount]->position.x + offsetValue,
+            MoveModel(boxModelList[boxModelCount]->modelHandle, boxModelList[boxModelCount]->position.x + offsetValue,
                 boxModelList[boxModelCount]->position.y, boxModelList[boxModelCount]->position.z);
         }
         else
         {
-            ChangeModelPhysicsPosition(boxModelList[boxModelCount]->modelName, boxModelList[boxModelCount]->position.x - offsetValue,
+            ChangeModelPhysicsPosition(boxModelList[boxModelCount]->modelHandle, boxModelList[boxModelCount]->position.x - offsetValue,
                 boxModelList[boxModelCount]->position.y, boxModelList[boxModelCount]->position.z);
 
-            MoveModel(boxModelList[boxModelCount]->modelName, boxModelList[boxModelCount]->position.x - offsetValue,
+            MoveModel(boxModelList[boxModelCount]->modelHandle, boxModelList[boxModelCount]->position.x - offsetValue,
                 boxModelList[boxModelCount]->position.y, boxModelList[boxModelCount]->position.z);
         }
     }
@@ -617,7 +1013,7 @@ void cControlGameEngine::AnimateTheCubes()
         animationReversed = false;
 }
 
-void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, std::string model2Name, std::string collisionType)
+void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, unsigned int model2Handle, std::string collisionType)
 {
     //-----Calculate acceleration & velocity(Euler forward integration step)---------------
     
@@ -632,9 +1028,10 @@ void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, std
 
     //---------------------Set sphere's position based on new velocity--------------------
 
-    cMesh* sphereMesh = g_pFindMeshByFriendlyName(physicsModel->modelName);
+    cMesh* sphereMesh = FindMeshByHandle(physicsModel->modelHandle);
 
-    sphereMesh->setDrawPosition(physicsModel->position);
+    if (sphereMesh != NULL)
+        sphereMesh->setDrawPosition(physicsModel->position);
 
     //----------------------Check for Collision---------------------------------------------------
 
@@ -650,14 +1047,19 @@ void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, std
     {
         //---------------------Get second mesh's model----------------------------------------------
 
-        cMesh* model2Mesh = g_pFindMeshByFriendlyName(model2Name);
+        cMesh* model2Mesh = FindMeshByHandle(model2Handle);
 
-        sModelDrawInfo* modelInfo = g_pFindModelInfoByFriendlyName(model2Name);
+        sModelDrawInfo* modelInfo = (model2Mesh != NULL) ? model2Mesh->pModelDrawInfo : NULL;
 
         //------------------------Plane Collision Check---------------------------------------------
         
-        if(model2Mesh != NULL && modelInfo!= NULL)
+        if(model2Mesh != NULL && modelInfo!= NULL && modelInfo->pVertices != NULL)
+        {
+            // Its world matrix, parents included, has to be current
+            transformHierarchy.UpdateMesh(model2Mesh);
+
             result = mPhysicsManager->CheckForPlaneCollision(modelInfo, model2Mesh, physicsModel);
+        }
 
         if (result)
             mPhysicsManager->PlaneCollisionResponse(physicsModel, deltaTime);
@@ -667,7 +1069,7 @@ void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, std
     {
         //---------------------Get second sphere's physical model-----------------------------------
 
-        sPhysicsProperties * secondSphereModel = FindPhysicalModelByName(model2Name);
+        sPhysicsProperties * secondSphereModel = FindPhysicalModelByHandle(model2Handle);
 
         //----------------------Sphere Collision Check----------------------------------------------
         
@@ -680,74 +1082,149 @@ void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, std
 
             //------------------------Change colors after collision-----------------------------
 
-            ChangeColor(physicsModel->modelName, getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50));
-            ChangeColor(secondSphereModel->modelName, getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50));
+            ChangeColor(physicsModel->modelHandle, getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50));
+            ChangeColor(secondSphereModel->modelHandle, getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50), getRandomFloat(0.0, 0.50));
         }
     }
 }
 
-void cControlGameEngine::AddSpherePhysicsToMesh(std::string modelName, std::string physicsMeshType, float objectRadius)
+void cControlGameEngine::MakePhysicsHappen(sPhysicsProperties* physicsModel, const std::string& model2Name, std::string collisionType)
 {
-    sPhysicsProperties* newPhysicsModel = new sPhysicsProperties(physicsMeshType);
+    MakePhysicsHappen(physicsModel, GetModelHandle(model2Name), collisionType);
+}
 
-    cMesh* meshDetails = g_pFindMeshByFriendlyName(modelName);
+void cControlGameEngine::AddSpherePhysicsToMesh(unsigned int modelHandle, std::string physicsMeshType, float objectRadius)
+{
+    sModelSlot* modelSlot = modelTable.Get(modelHandle);
 
-    glm::vec3 modelPosition = meshDetails->getDrawPosition();
+    if (modelSlot == NULL)
+        return;
+
+    if (modelSlot->pPhysics != NULL)
+    {
+        std::cout << modelSlot->pMesh->friendlyName << " already has physics" << std::endl;
+        return;
+    }
+
+    sPhysicsProperties* newPhysicsModel = new sPhysicsProperties(physicsMeshType);
+
+    glm::vec3 modelPosition = modelSlot->pMesh->getDrawPosition();
 
     newPhysicsModel->physicsMeshType = physicsMeshType;
 
-    newPhysicsModel->modelName = modelName;
+    newPhysicsModel->modelName = modelSlot->pMesh->friendlyName;
+
+    newPhysicsModel->modelHandle = modelHandle;
 
-    newPhysicsModel->sphereProps->radius = objectRadius;
+    if (newPhysicsModel->sphereProps != NULL)
+        newPhysicsModel->sphereProps->radius = objectRadius;
 
     newPhysicsModel->position = modelPosition;
 
+    modelSlot->pPhysics = newPhysicsModel;
+
     PhysicsModelList.push_back(newPhysicsModel);
 }
 
-void cControlGameEngine::AddPlanePhysicsToMesh(std::string modelName, std::string physicsMeshType)
+void cControlGameEngine::AddSpherePhysicsToMesh(const std::string& modelName, std::string physicsMeshType, float objectRadius)
 {
+    AddSpherePhysicsToMesh(GetModelHandle(modelName), physicsMeshType, objectRadius);
+}
+
+void cControlGameEngine::AddPlanePhysicsToMesh(unsigned int modelHandle, std::string physicsMeshType)
+{
+    sModelSlot* modelSlot = modelTable.Get(modelHandle);
+
+    if (modelSlot == NULL)
+        return;
+
+    if (modelSlot->pPhysics != NULL)
+    {
+        std::cout << modelSlot->pMesh->friendlyName << " already has physics" << std::endl;
+        return;
+    }
+
     sPhysicsProperties* newPhysicsModel = new sPhysicsProperties(physicsMeshType);
 
-    cMesh* meshDetails = g_pFindMeshByFriendlyName(modelName);
+    cMesh* meshDetails = modelSlot->pMesh;
 
     glm::vec3 modelPosition = meshDetails->getDrawPosition();
 
     newPhysicsModel->physicsMeshType = physicsMeshType;
 
-    newPhysicsModel->modelName = modelName;
+    newPhysicsModel->modelName = meshDetails->friendlyName;
+
+    newPhysicsModel->modelHandle = modelHandle;
 
     newPhysicsModel->position = modelPosition;
 
+    modelSlot->pPhysics = newPhysicsModel;
+
     PhysicsModelList.push_back(newPhysicsModel);
+
+    // Plane collisions walk the triangles, so this file keeps its CPU copy
+    if (!mVAOManager->KeepCPUGeometry(meshDetails->meshName))
+        std::cout << "Error : " << mVAOManager->getLastError() << std::endl;
 }
 
-void cControlGameEngine::ChangeModelPhysicsPosition(std::string modelName, float newPositionX, float newPositionY, float newPositionZ)
+void cControlGameEngine::AddPlanePhysicsToMesh(const std::string& modelName, std::string physicsMeshType)
 {
-    sPhysicsProperties* physicalModelFound = FindPhysicalModelByName(modelName);
+    AddPlanePhysicsToMesh(GetModelHandle(modelName), physicsMeshType);
+}
+
+void cControlGameEngine::ChangeModelPhysicsPosition(unsigned int modelHandle, float newPositionX, float newPositionY, float newPositionZ)
+{
+    sPhysicsProperties* physicalModelFound = FindPhysicalModelByHandle(modelHandle);
+
+    if (physicalModelFound == NULL)
+        return;
 
     physicalModelFound->position.x = newPositionX;
     physicalModelFound->position.y = newPositionY;
     physicalModelFound->position.z = newPositionZ;
 }
 
-void cControlGameEngine::ChangeModelPhysicsVelocity(std::string modelName, glm::vec3 velocityChange)
+void cControlGameEngine::ChangeModelPhysicsPosition(const std::string& modelName, float newPositionX, float newPositionY, float newPositionZ)
 {
-    sPhysicsProperties* physicalModelFound = FindPhysicalModelByName(modelName);
+    ChangeModelPhysicsPosition(GetModelHandle(modelName), newPositionX, newPositionY, newPositionZ);
+}
+
+void cControlGameEngine::ChangeModelPhysicsVelocity(unsigned int modelHandle, glm::vec3 velocityChange)
+{
+    sPhysicsProperties* physicalModelFound = FindPhysicalModelByHandle(modelHandle);
+
+    if (physicalModelFound == NULL || physicalModelFound->sphereProps == NULL)
+        return;
 
     physicalModelFound->sphereProps->velocity = velocityChange;
 }
 
-void cControlGameEngine::ChangeModelPhysicsAcceleration(std::string modelName, glm::vec3 accelerationChange)
+void cControlGameEngine::ChangeModelPhysicsVelocity(const std::string& modelName, glm::vec3 velocityChange)
+{
+    ChangeModelPhysicsVelocity(GetModelHandle(modelName), velocityChange);
+}
+
+void cControlGameEngine::ChangeModelPhysicsAcceleration(unsigned int modelHandle, glm::vec3 accelerationChange)
 {
-    sPhysicsProperties* physicalModelFound = FindPhysicalModelByName(modelName);
+    sPhysicsProperties* physicalModelFound = FindPhysicalModelByHandle(modelHandle);
+
+    if (physicalModelFound == NULL || physicalModelFound->sphereProps == NULL)
+        return;
 
     physicalModelFound->sphereProps->acceleration = accelerationChange;
 }
 
-int cControlGameEngine::ChangeModelPhysicalMass(std::string modelName, float mass)
+void cControlGameEngine::ChangeModelPhysicsAcceleration(const std::string& modelName, glm::vec3 accelerationChange)
+{
+    ChangeModelPhysicsAcceleration(GetModelHandle(modelName), accelerationChange);
+}
+
+int cControlGameEngine::ChangeModelPhysicalMass(unsigned int modelHandle, float mass)
 {
-    sPhysicsProperties* physicalModelFound = FindPhysicalModelByName(modelName);
+    sPhysicsProperties* physicalModelFound = FindPhysicalModelByHandle(modelHandle);
+
+    if (physicalModelFound == NULL || physicalModelFound->sphereProps == NULL)
+        return 1;
 
     if (mass > 0.0f)
     {
@@ -758,33 +1235,248 @@ int cControlGameEngine::ChangeModelPhysicalMass(std::string modelName, float mas
     return 1;
 }
 
+int cControlGameEngine::ChangeModelPhysicalMass(const std::string& modelName, float mass)
+{
+    return ChangeModelPhysicalMass(GetModelHandle(modelName), mass);
+}
+
 //--------------------------------------Engine Controls-----------------------------------------------------------------
 
-void cControlGameEngine::LoadModelsInto3DSpace(std::string filePath, std::string modelName, float initial_x, float initial_y, float initial_z)
+unsigned int cControlGameEngine::LoadModelsInto3DSpace(std::string filePath, std::string modelName, float initial_x, float initial_y, float initial_z, bool bIsDynamicMesh)
 {
-    sModelDrawInfo* newModel = new sModelDrawInfo;
+    // Models using the same file share its VAO, only the mesh (transform etc.) is per model
+    sModelDrawInfo* sharedModel = mVAOManager->AcquireModel(filePath, shaderProgramID, bIsDynamicMesh);
+
+    if (sharedModel == NULL)
+    {
+        std::cout << "Cannot load model - " << modelName << " (" << mVAOManager->getLastError() << ")" << std::endl;
+        return INVALID_MODEL_HANDLE;
+    }
 
     cMesh* newMesh = new cMesh();
 
-    bool result = mVAOManager->LoadModelIntoVAO(modelName, filePath, *newModel, shaderProgramID);
+    sModelSlot newModelSlot;
+
+    newModelSlot.pMesh = newMesh;
+
+    unsigned int modelHandle = modelTable.Add(newModelSlot);
 
-    if (!result)
+    if (modelHandle == INVALID_MODEL_HANDLE)
     {
-        std::cout << "Cannot load model - " << modelName << std::endl;
-        return;
+        std::cout << "Cannot load model - " << modelName << " (too many models)" << std::endl;
+
+        mVAOManager->ReleaseModel(filePath);
+
+        delete newMesh;
+
+        return INVALID_MODEL_HANDLE;
     }
 
-    MeshDrawInfoList.push_back(newModel);
+    // The name finds the first model loaded under it, the others only by handle
+    if (!modelNameIndex.Insert(modelName, modelHandle))
+        std::cout << "Model name " << modelName << " is already used, use the handle for this one" << std::endl;
+
+    newMesh->pModelDrawInfo = sharedModel;
 
     newMesh->meshName = filePath;
 
     newMesh->friendlyName = modelName;
 
-    newMesh->drawPosition = glm::vec3(initial_x, initial_y, initial_z);
+    newMesh->setDrawPosition(glm::vec3(initial_x, initial_y, initial_z));
+
+    std::cout << "Loaded: " << newMesh->friendlyName << " | Vertices : " << sharedModel->numberOfVertices;
+
+    if (sharedModel->vecLODs.size() > 1)
+    {
+        std::cout << " | LOD triangles :";
+
+        for (unsigned int lodIndex = 0; lodIndex != sharedModel->vecLODs.size(); lodIndex++)
+            std::cout << " " << sharedModel->vecLODs[lodIndex].numberOfIndices / 3;
+    }
+
+    if (sharedModel->bIsOptimized)
+        std::cout << " | ACMR : " << sharedModel->cacheStatsBefore.ACMR << " -> " << sharedModel->cacheStatsAfter.ACMR
+            << " | ATVR : " << sharedModel->cacheStatsBefore.ATVR << " -> " << sharedModel->cacheStatsAfter.ATVR;
 
-    std::cout << "Loaded: " << newMesh->friendlyName << " | Vertices : " << newModel->numberOfVertices << std::endl;
+    std::cout << std::endl;
+
+    transformHierarchy.AddMesh(newMesh);
 
     TotalMeshList.push_back(newMesh);
+
+    return modelHandle;
+}
+
+bool cControlGameEngine::AttachModelToParent(unsigned int modelHandle, unsigned int parentModelHandle)
+{
+    cMesh* childMesh = FindMeshByHandle(modelHandle);
+
+    if (childMesh == NULL)
+        return false;
+
+    cMesh* parentMesh = NULL;
+
+    if (parentModelHandle != INVALID_MODEL_HANDLE)
+    {
+        parentMesh = FindMeshByHandle(parentModelHandle);
+
+        if (parentMesh == NULL)
+            return false;
+    }
+
+    if (!transformHierarchy.setParent(childMesh, parentMesh))
+    {
+        std::cout << "Cannot attach " << childMesh->friendlyName << " to " << parentMesh->friendlyName << " - it would be its own parent" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool cControlGameEngine::AttachModelToParent(const std::string& modelName, const std::string& parentModelName)
+{
+    unsigned int parentModelHandle = INVALID_MODEL_HANDLE;
+
+    if (!parentModelName.empty())
+    {
+        parentModelHandle = GetModelHandle(parentModelName);
+
+        if (parentModelHandle == INVALID_MODEL_HANDLE)
+            return false;
+    }
+
+    return AttachModelToParent(GetModelHandle(modelName), parentModelHandle);
+}
+
+void cControlGameEngine::EnableInstancing(bool enable)
+{
+    instancingEnabled = enable;
+}
+
+void cControlGameEngine::ChangeVertexFormat(eVertexFormat vertexFormat)
+{
+    mVAOManager->setVertexFormat(vertexFormat);
+}
+
+void cControlGameEngine::ChangeDynamicBufferStrategy(eDynamicBufferStrategy dynamicBufferStrategy)
+{
+    mVAOManager->setDynamicBufferStrategy(dynamicBufferStrategy);
+}
+
+sVertex* cControlGameEngine::GetDynamicModelVertices(unsigned int modelHandle, unsigned int& numberOfVertices)
+{
+    cMesh* meshFound = FindMeshByHandle(modelHandle);
+
+    numberOfVertices = 0;
+
+    sDynamicBufferStats dynamicBufferStats;
+
+    if (meshFound == NULL || meshFound->pModelDrawInfo == NULL || !mVAOManager->GetDynamicBufferStats(meshFound->meshName, dynamicBufferStats))
+    {
+        std::cout << ((meshFound != NULL) ? meshFound->friendlyName : "The model") << " isn't a dynamic model" << std::endl;
+        return NULL;
+    }
+
+    numberOfVertices = meshFound->pModelDrawInfo->numberOfVertices;
+
+    return meshFound->pModelDrawInfo->pVertices;
+}
+
+sVertex* cControlGameEngine::GetDynamicModelVertices(const std::string& modelName, unsigned int& numberOfVertices)
+{
+    return GetDynamicModelVertices(GetModelHandle(modelName), numberOfVertices);
+}
+
+bool cControlGameEngine::UpdateDynamicModelVertices(unsigned int modelHandle, unsigned int firstVertex, unsigned int numberOfVertices)
+{
+    cMesh* meshFound = FindMeshByHandle(modelHandle);
+
+    if (meshFound == NULL || meshFound->pModelDrawInfo == NULL)
+    {
+        std::cout << "Cannot update vertices - model not found" << std::endl;
+        return false;
+    }
+
+    if (!mVAOManager->UpdateVAOBufferRange(meshFound->meshName, meshFound->pModelDrawInfo->pVertices + firstVertex, firstVertex, numberOfVertices))
+    {
+        std::cout << "Cannot update vertices - " << meshFound->friendlyName << " (" << mVAOManager->getLastError() << ")" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool cControlGameEngine::UpdateDynamicModelVertices(const std::string& modelName, unsigned int firstVertex, unsigned int numberOfVertices)
+{
+    return UpdateDynamicModelVertices(GetModelHandle(modelName), firstVertex, numberOfVertices);
+}
+
+std::size_t cControlGameEngine::ReleaseModelGeometry()
+{
+    return mVAOManager->ReleaseCPUGeometry();
+}
+
+sModelLoadTimings cControlGameEngine::PreloadModelFiles(std::vector<std::string> filePaths)
+{
+    sModelLoadTimings loadTimings;
+
+    //--------------------------Skip repeated and already loaded files-------------------------------
+
+    std::vector<std::string> filesToLoad;
+
+    sModelDrawInfo loadedModel;
+
+    for (unsigned int index = 0; index != filePaths.size(); index++)
+    {
+        if (mVAOManager->FindDrawInfoByModelName(filePaths[index], loadedModel))
+            continue;
+
+        if (std::find(filesToLoad.begin(), filesToLoad.end(), filePaths[index]) == filesToLoad.end())
+            filesToLoad.push_back(filePaths[index]);
+    }
+
+    loadTimings.numberOfFiles = (unsigned int)filesToLoad.size();
+    loadTimings.numberOfThreads = mThreadPool->getNumberOfThreads();
+
+    //--------------------------Read and decode on the worker threads--------------------------------
+
+    std::vector<sModelDrawInfo> drawInfoList(filesToLoad.size());
+    std::vector<std::string> errorList(filesToLoad.size());
+    std::vector<char> resultList(filesToLoad.size(), 0);
+
+    std::chrono::steady_clock::time_point readStart = std::chrono::steady_clock::now();
+
+    for (unsigned int index = 0; index != filesToLoad.size(); index++)
+    {
+        mThreadPool->AddTask([this, index, &filesToLoad, &drawInfoList, &errorList, &resultList]()
+            {
+                resultList[index] = mVAOManager->ReadModelFile(filesToLoad[index], drawInfoList[index], errorList[index]);
+            });
+    }
+
+    mThreadPool->WaitForAllTasks();
+
+    std::chrono::steady_clock::time_point uploadStart = std::chrono::steady_clock::now();
+
+    //--------------------------GL buffers on the main thread----------------------------------------
+
+    for (unsigned int index = 0; index != filesToLoad.size(); index++)
+    {
+        if (!resultList[index])
+        {
+            std::cout << "Cannot load model file - " << errorList[index] << std::endl;
+            continue;
+        }
+
+        mVAOManager->UploadModelToVAO(filesToLoad[index], drawInfoList[index], shaderProgramID);
+    }
+
+    std::chrono::steady_clock::time_point uploadEnd = std::chrono::steady_clock::now();
+
+    loadTimings.readTime = std::chrono::duration<double>(uploadStart - readStart).count();
+    loadTimings.uploadTime = std::chrono::duration<double>(uploadEnd - uploadStart).count();
+
+    return loadTimings;
 }
 
 int cControlGameEngine::InitializeGameEngine()
@@ -806,6 +1498,10 @@ int cControlGameEngine::InitializeGameEngine()
 
     mPhysicsManager->setVAOManager(mVAOManager);
 
+    //-------------------------------------Worker Threads Initialize--------------------------------------------------------
+
+    mThreadPool = new cThreadPool();
+
     //------------------------------------Lights Initialize-----------------------------------------------------------------------
 
     mLightManager = new cLightManager();
@@ -832,39 +1528,108 @@ void cControlGameEngine::RunGameEngine(GLFWwindow* window)
 
     glCullFace(GL_BACK);
 
+    frameStats = sFrameStats();
+
+    //---------------------------Geometry Arenas--------------------------------------------
+
+    // Only after unloads, and only copies anything once they've left enough holes.
+    //	A model that doesn't fit compacts its arena itself when it's loaded.
+    if (geometryArenaCompactionPending)
+    {
+        mVAOManager->CompactGeometryArenas();
+
+        geometryArenaCompactionPending = false;
+    }
+
     //---------------------------Light Values Update----------------------------------------
 
-    mLightManager->UpdateUniformValues(shaderProgramID);
+    mLightManager->UpdateLightBuffer();
+
+    frameStats.numberOfActiveLights = mLightManager->getLastUploadStats().numberOfActiveLights;
+
+    frameStats.lightBytesUploaded = mLightManager->getLastUploadStats().bytesUploaded;
 
     //---------------------------Camera Values----------------------------------------------
 
-    GLint eyeLocation_UL = glGetUniformLocation(shaderProgramID, "eyeLocation");
-    glUniform4f(eyeLocation_UL,
-        cameraEye.x, cameraEye.y, cameraEye.z, 1.0f);
+    const float nearPlane = 0.1f;
+    const float farPlane = 1000.0f;
 
-    glm::mat4 matProjection = glm::perspective(0.6f, ratio, 0.1f, 1000.0f);
+    sPerFrameBlock perFrameBlock;
 
-    glm::mat4 matView = glm::lookAt(cameraEye, cameraEye + cameraTarget, upVector);
+    perFrameBlock.eyeLocation = glm::vec4(cameraEye, 1.0f);
 
-    GLint matProjection_UL = glGetUniformLocation(shaderProgramID, "matProjection");
-    glUniformMatrix4fv(matProjection_UL, 1, GL_FALSE, glm::value_ptr(matProjection));
+    perFrameBlock.matProjection = glm::perspective(fieldOfView, ratio, nearPlane, farPlane);
 
-    GLint matView_UL = glGetUniformLocation(shaderProgramID, "matView");
-    glUniformMatrix4fv(matView_UL, 1, GL_FALSE, glm::value_ptr(matView));
+    perFrameBlock.matView = glm::lookAt(cameraEye, cameraEye + cameraTarget, upVector);
 
-    //----------------------------Draw all the objects--------------------------------------
+    //---------------------------Light Clusters---------------------------------------------
+
+    unsigned int numberOfActiveLights = 0;
+
+    const sLightBlockEntry* pActiveLights = mLightManager->getActiveLights(numberOfActiveLights);
+
+    lightClusterGrid.setProjection(fieldOfView, width, height, nearPlane, farPlane);
+
+    lightClusterGrid.Build(perFrameBlock.matView, pActiveLights, numberOfActiveLights, mThreadPool);
+
+    lightClusterGrid.UploadAndBind();
+
+    lightClusterGrid.FillPerFrameBlock(perFrameBlock);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, perFrameBuffer.getID());
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(sPerFrameBlock), &perFrameBlock);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_PER_FRAME, perFrameBuffer.getID());
+
+    //----------------------------World Transforms------------------------------------------
+
+    // Only the subtrees with something that moved, turned or was scaled
+    transformHierarchy.Update(mThreadPool);
+
+    //----------------------------Fill every object's block---------------------------------
+
+    drawList.clear();
 
     for (unsigned int index = 0; index != TotalMeshList.size(); index++)
     {
-        cMesh* pCurrentMesh = TotalMeshList[index];
+        if (TotalMeshList[index]->bIsVisible)
+            drawList.push_back(TotalMeshList[index]);
+    }
 
-        if (pCurrentMesh->bIsVisible)
-        {
-            glm::mat4 matModel = glm::mat4(1.0f);
+    // Big lists are split across the thread pool
+    frustumCuller.Cull(perFrameBlock.matProjection * perFrameBlock.matView, drawList, mThreadPool);
 
-            DrawObject(pCurrentMesh, matModel, shaderProgramID);
-        }
-    }
+    frameStats.numberOfMeshesCulled = frustumCuller.getLastStats().numberOfMeshesCulled;
+
+    objectBlocks.resize(drawList.size());
+
+    for (unsigned int index = 0; index != drawList.size(); index++)
+        FillObjectBlock(drawList[index], objectBlocks[index]);
+
+    //----------------------------Group them and fill the instances-------------------------
+
+    BuildInstanceGroups(perFrameBlock.matView);
+
+    unsigned char* pInstances = instanceRing.BeginFrame((unsigned int)drawOrder.size());
+
+    // Copied in one go each, the ring may be write combined GPU memory
+    for (unsigned int instance = 0; instance != drawOrder.size(); instance++)
+        memcpy(pInstances + (std::size_t)instance * instanceRing.getEntryStride(), &objectBlocks[drawOrder[instance]], sizeof(sPerObjectBlock));
+
+    instanceRing.EndFrame();
+
+    instanceRing.BindFrame(STORAGE_BINDING_INSTANCES);
+
+    //----------------------------Draw all the groups---------------------------------------
+
+    boundVAO = 0;
+    boundPolygonMode = 0;
+
+    for (unsigned int index = 0; index != instanceGroups.size(); index++)
+        DrawInstances(instanceGroups[index]);
+
+    glBindVertexArray(0);
 
     //----------------------------Title Screen Values---------------------------------------------
 
@@ -913,7 +1678,18 @@ void cControlGameEngine::RunGameEngine(GLFWwindow* window)
         << meshObj->drawPosition.x << ", "
         << meshObj->drawPosition.y << ", "
         << meshObj->drawPosition.z << ") | ModelScaleVal : "
-        << meshObj->drawScale.x;
+        << meshObj->drawScale.x << " | Triangles : "
+        << frameStats.numberOfTriangles << " / "
+        << frameStats.numberOfFullDetailTriangles << " | LOD 0/1/2/3 : "
+        << frameStats.numberOfMeshesPerLOD[0] << "/"
+        << frameStats.numberOfMeshesPerLOD[1] << "/"
+        << frameStats.numberOfMeshesPerLOD[2] << "/"
+        << frameStats.numberOfMeshesPerLOD[3] << " | Drawn / Culled : "
+        << frameStats.numberOfMeshesDrawn << " / "
+        << frameStats.numberOfMeshesCulled << " | Draws : "
+        << frameStats.numberOfDrawCalls << " | VAO binds : "
+        << frameStats.numberOfVAOBinds << " (" << frameStats.numberOfVAOBindsAvoided << " avoided) | Polygon mode : "
+        << frameStats.numberOfPolygonModeChanges << " (" << frameStats.numberOfPolygonModeChangesAvoided << " avoided)";
 
     std::string theTitle = ssTitle.str();
 
@@ -5,6 +5,62 @@
 #include "cLightHelper.h"
 #include "cVAOManager.h"
 #include "cShaderManager.h"
+#include "cThreadPool.h"
+#include "cUniformBufferRing.h"
+#include "cLightClusterGrid.h"
+#include "cFrustumCuller.h"
+#include "cRenderQueue.h"
+#include "cTransformHierarchy.h"
+#include "cHandleTable.h"
+#include "cNameIndex.h"
+#include "sShaderBlocks.h"
+
+// Startup timings from PreloadModelFiles (seconds, wall clock)
+struct sModelLoadTimings
+{
+    unsigned int numberOfFiles = 0;
+    unsigned int numberOfThreads = 0;
+
+    double readTime = 0.0;      // Reading + decoding every file on the thread pool
+    double uploadTime = 0.0;    // Creating the VAOs / buffers on the main thread
+};
+
+// Counted while drawing the last frame
+struct sFrameStats
+{
+    unsigned int numberOfMeshesDrawn = 0;
+    unsigned int numberOfMeshesCulled = 0;          // Visible, but outside the view frustum
+    unsigned int numberOfTriangles = 0;             // What was actually drawn
+    unsigned int numberOfFullDetailTriangles = 0;   // What LOD 0 everywhere would have drawn
+    unsigned int numberOfMeshesPerLOD[4] = { 0, 0, 0, 0 };
+
+    unsigned int numberOfDrawCalls = 0;
+    unsigned int numberOfVAOBinds = 0;
+    unsigned int numberOfPolygonModeChanges = 0;
+
+    // Skipped because the state was already set (the sorted groups share it)
+    unsigned int numberOfVAOBindsAvoided = 0;
+    unsigned int numberOfPolygonModeChangesAvoided = 0;
+
+    unsigned int numberOfActiveLights = 0;
+    unsigned int lightBytesUploaded = 0;
+};
+
+// Meshes with the same model, LOD and polygon mode, drawn with one instanced draw.
+//	Their entries are next to each other in the instance ring.
+struct sInstanceGroup
+{
+    cMesh* pFirstMesh = NULL;
+    unsigned int firstInstance = 0;
+    unsigned int numberOfInstances = 0;
+};
+
+// What a model handle addresses
+struct sModelSlot
+{
+    cMesh* pMesh = NULL;
+    sPhysicsProperties* pPhysics = NULL;    // Once physics is added to the model
+};
 
 class cControlGameEngine
 {
@@ -12,7 +68,7 @@ private:
 
     int gSelectedLight = 0;
     int meshListIndex = 0;
-    int lightListIndex = 0;
+    unsigned int lightListIndex = cLightManager::INVALID_LIGHT_HANDLE;
 
     bool animationReversed = false;
 
@@ -20,33 +76,99 @@ private:
     glm::vec3 cameraTarget = glm::vec3(0.0f, 0.0f, -1.0f);
     glm::vec3 upVector = glm::vec3(0.0f, 1.0f, 0.0f);
 
+    float fieldOfView = 0.6f;   // Vertical, radians
+
+    //-------------------Level of detail-------------------
+
+    // Used by meshes without their own LOD screen sizes
+    std::vector<float> defaultLODScreenSizes = { 0.25f, 0.12f, 0.05f };
+
+    // A level only changes once the screen size is this fraction past the threshold
+    float lodHysteresis = 0.1f;
+
+    sFrameStats frameStats;
+
+    // VAO bound / polygon mode set while drawing this frame (0 before the first group)
+    GLuint boundVAO = 0;
+    GLenum boundPolygonMode = 0;
+
+    unsigned int SelectLOD(cMesh* pCurrentMesh, const glm::mat4& matModel);
+
     GLuint shaderProgramID = 0;
 
     cShaderManager* mShaderManager = NULL;
 
+    cShaderManager::cShaderProgram* pShaderProgram = NULL;
+
+    // shader01's std140 blocks (sShaderBlocks.h). Lights are cLightManager's.
+    cGLBuffer perFrameBuffer;
+
+    // sPerObjectBlock of every mesh drawn this frame ("Instances"), in group order
+    cUniformBufferRing instanceRing;
+
+    // Where this draw's meshes start in the instance ring
+    sUniformHandle<UNIFORM_TYPE_INT> instanceBaseUniform;
+
+    // Off = every mesh is its own group
+    bool instancingEnabled = true;
+
+    // Bins the lights for the fragment shader each frame
+    cLightClusterGrid lightClusterGrid;
+
+    // Parent / child links of TotalMeshList's meshes, and their world matrices
+    cTransformHierarchy transformHierarchy;
+
+    // DeleteMesh freed arena space, RunGameEngine checks the fragmentation at the frame start
+    bool geometryArenaCompactionPending = false;
+
+    // Drops the meshes outside the view from drawList each frame
+    cFrustumCuller frustumCuller;
+
+    // Visible meshes of this frame
+    std::vector< cMesh* > drawList;
+
+    // Sorts drawList by GL state, then front to back
+    cRenderQueue renderQueue;
+
+    // drawList's blocks, the drawList indices sorted into groups and the groups
+    std::vector< sPerObjectBlock > objectBlocks;
+    std::vector< unsigned int > drawOrder;
+    std::vector< sInstanceGroup > instanceGroups;
+
     cVAOManager* mVAOManager = NULL;
 
     cPhysics* mPhysicsManager = NULL;
 
     cLightManager* mLightManager = NULL;
 
+    cThreadPool* mThreadPool = NULL;
+
     std::vector < sPhysicsProperties* > PhysicsModelList;
 
     std::vector< cMesh* > TotalMeshList;
 
-    std::vector < sModelDrawInfo* > MeshDrawInfoList;
+    // Every loaded model by handle, and the handles by model name
+    cHandleTable< sModelSlot > modelTable;
+    cNameIndex modelNameIndex;
 
     cShaderManager::cShader vertexShader;
 
     cShaderManager::cShader fragmentShader;
 
-    void DrawObject(cMesh* pCurrentMesh, glm::mat4 matModel, GLuint shaderProgramID);
+    // Model matrix, flags and LOD of the mesh
+    void FillObjectBlock(cMesh* pCurrentMesh, sPerObjectBlock& objectBlock);
 
-    cMesh* g_pFindMeshByFriendlyName(std::string friendlyNameToFind);
+    // Sorts drawList's meshes that have a model into instanceGroups (drawOrder)
+    void BuildInstanceGroups(const glm::mat4& matView);
 
-    sModelDrawInfo* g_pFindModelInfoByFriendlyName(std::string friendlyNameToFind);
+    // Draws the group's meshes with the instance ring already bound
+    void DrawInstances(const sInstanceGroup& instanceGroup);
 
-    sPhysicsProperties* FindPhysicalModelByName(std::string modelName);
+    // NULL for a stale or invalid handle
+    cMesh* FindMeshByHandle(unsigned int modelHandle);
+
+    // NULL also if the model has no physics
+    sPhysicsProperties* FindPhysicalModelByHandle(unsigned int modelHandle);
 
     int InitializeShader();
 
@@ -77,29 +199,64 @@ public:
 
     //-------------------Mesh Controls---------------------------------------------------
 
-    void ChangeColor(std::string modelName, float r, float g, float b);
+    // Models are addressed by the handle LoadModelsInto3DSpace returns, or by name (a hash
+    //	lookup, then the same as the handle). A deleted model's handle stops working : the
+    //	handle overloads then do nothing and return zeros / false.
+    static const unsigned int INVALID_MODEL_HANDLE = cHandleTable<sModelSlot>::INVALID_HANDLE;
+
+    // INVALID_MODEL_HANDLE if there's no model of that name (nothing is printed)
+    unsigned int GetModelHandle(const std::string& modelName);
+
+    void ChangeColor(unsigned int modelHandle, float r, float g, float b);
+    void ChangeColor(const std::string& modelName, float r, float g, float b);
 
-    void UseManualColors(std::string modelName, bool useColor);
+    void UseManualColors(unsigned int modelHandle, bool useColor);
+    void UseManualColors(const std::string& modelName, bool useColor);
 
-    void ScaleModel(std::string modelName, float scale_value);
+    void ScaleModel(unsigned int modelHandle, float scale_value);
+    void ScaleModel(const std::string& modelName, float scale_value);
 
-    void MoveModel(std::string modelName, float translate_x, float translate_y, float translate_z);
+    void MoveModel(unsigned int modelHandle, float translate_x, float translate_y, float translate_z);
+    void MoveModel(const std::string& modelName, float translate_x, float translate_y, float translate_z);
 
-    glm::vec3 GetModelPosition(std::string modelName);
+    glm::vec3 GetModelPosition(unsigned int modelHandle);
+    glm::vec3 GetModelPosition(const std::string& modelName);
 
-    float GetModelScaleValue(std::string modelName);
+    float GetModelScaleValue(unsigned int modelHandle);
+    float GetModelScaleValue(const std::string& modelName);
 
-    void RotateMeshModel(std::string modelName, float angleRadians, float rotate_x, float rotate_y, float rotate_z);
+    // World space bounds of the model, cached in its cMesh until it moves, turns or is scaled.
+    //	False if there's no such model.
+    bool GetModelWorldAABB(unsigned int modelHandle, glm::vec3& minXYZ, glm::vec3& maxXYZ);
+    bool GetModelWorldAABB(const std::string& modelName, glm::vec3& minXYZ, glm::vec3& maxXYZ);
 
-    void TurnVisibilityOn(std::string modelName);
+    bool GetModelBoundingSphere(unsigned int modelHandle, glm::vec3& centre, float& radius);
+    bool GetModelBoundingSphere(const std::string& modelName, glm::vec3& centre, float& radius);
 
-    void TurnWireframeModeOn(std::string modelName);
+    // The model's position, orientation and scale become relative to the parent's and it
+    //	follows the parent around. INVALID_MODEL_HANDLE / an empty parent name detaches it.
+    //	False if a model isn't found or the parent is the model itself or one of its children.
+    bool AttachModelToParent(unsigned int modelHandle, unsigned int parentModelHandle);
+    bool AttachModelToParent(const std::string& modelName, const std::string& parentModelName);
 
-    void TurnMeshLightsOn(std::string modelName);
+    void RotateMeshModel(unsigned int modelHandle, float angleRadians, float rotate_x, float rotate_y, float rotate_z);
+    void RotateMeshModel(const std::string& modelName, float angleRadians, float rotate_x, float rotate_y, float rotate_z);
 
-    std::vector<glm::vec3> GetModelVertices(std::string modelName);
+    void TurnVisibilityOn(unsigned int modelHandle);
+    void TurnVisibilityOn(const std::string& modelName);
 
-    void DeleteMesh(std::string modelName);
+    void TurnWireframeModeOn(unsigned int modelHandle);
+    void TurnWireframeModeOn(const std::string& modelName);
+
+    void TurnMeshLightsOn(unsigned int modelHandle);
+    void TurnMeshLightsOn(const std::string& modelName);
+
+    std::vector<glm::vec3> GetModelVertices(unsigned int modelHandle);
+    std::vector<glm::vec3> GetModelVertices(const std::string& modelName);
+
+    // Its physics goes with it
+    void DeleteMesh(unsigned int modelHandle);
+    void DeleteMesh(const std::string& modelName);
 
     cMesh* ShiftToNextMeshInList();
 
@@ -107,63 +264,96 @@ public:
 
     cMesh* GetCurrentModelSelected();
 
+    // Screen sizes (fraction of the viewport height, largest first) below which
+    //	LOD 1, 2, ... of the model is drawn
+    void ChangeModelLODScreenSizes(unsigned int modelHandle, std::vector<float> lodScreenSizes);
+    void ChangeModelLODScreenSizes(const std::string& modelName, std::vector<float> lodScreenSizes);
+
+    sFrameStats GetFrameStats();
+
+    sLightClusterStats GetLightClusterStats();
+
+    sFrustumCullStats GetFrustumCullStats();
+
+    sRenderQueueStats GetRenderQueueStats();
+
+    sTransformHierarchyStats GetTransformHierarchyStats();
+
+    sGeometryArenaStats GetGeometryArenaStats();
+
     //-------------------Light Controls---------------------------------------------------
 
-    void CreateLight(int lightId, float initial_x, float initial_y, float initial_z);
+    // Returns the light's handle, which the other light controls take (a deleted light's handle stops working)
+    unsigned int CreateLight(float initial_x, float initial_y, float initial_z);
+
+    void DeleteLight(unsigned int lightHandle);
 
-    void TurnOffLight(int lightId, bool turnOff);
+    unsigned int GetNumberOfLights();
 
-    void PositionLight(int lightId, float translate_x, float translate_y, float translate_z);
+    void TurnOffLight(unsigned int lightHandle, bool turnOff);
 
-    void ChangeLightIntensity(int lightId, float linearAttentuation, float quadraticAttentuation);
+    void PositionLight(unsigned int lightHandle, float translate_x, float translate_y, float translate_z);
 
-    void ChangeLightType(int lightId, float lightType);
+    void ChangeLightIntensity(unsigned int lightHandle, float linearAttentuation, float quadraticAttentuation);
 
-    void ChangeLightAngle(int lightId, float innerAngle, float outerAngle);
+    void ChangeLightType(unsigned int lightHandle, float lightType);
 
-    void ChangeLightDirection(int lightId, float direction_x, float direction_y, float direction_z);
+    void ChangeLightAngle(unsigned int lightHandle, float innerAngle, float outerAngle);
 
-    void ChangeLightColour(int lightId, float color_r, float color_g, float color_b);
+    void ChangeLightDirection(unsigned int lightHandle, float direction_x, float direction_y, float direction_z);
 
-    float GetLightLinearAttenuation(int lightId);
+    void ChangeLightColour(unsigned int lightHandle, float color_r, float color_g, float color_b);
 
-    float GetLightQuadraticAttenuation(int lightId);
+    float GetLightLinearAttenuation(unsigned int lightHandle);
 
-    float GetLightType(int lightId);
+    float GetLightQuadraticAttenuation(unsigned int lightHandle);
 
-    float GetLightInnerAngle(int lightId);
+    float GetLightType(unsigned int lightHandle);
 
-    float GetLightOuterAngle(int lightId);
+    float GetLightInnerAngle(unsigned int lightHandle);
 
-    float IsLightOn(int lightId);
+    float GetLightOuterAngle(unsigned int lightHandle);
 
-    glm::vec3 GetLightPosition(int lightId);
+    float IsLightOn(unsigned int lightHandle);
 
-    glm::vec3 GetLightDirection(int lightId);
+    glm::vec3 GetLightPosition(unsigned int lightHandle);
 
-    glm::vec3 GetLightColor(int lightId);
+    glm::vec3 GetLightDirection(unsigned int lightHandle);
+
+    glm::vec3 GetLightColor(unsigned int lightHandle);
 
     void ShiftToNextLightInList();
 
-    int GetCurrentLightSelected();
+    // Handle of the selected light
+    unsigned int GetCurrentLightSelected();
 
     //------------------Physics Controls---------------------------------------------------
 
+    // Physics belongs to a model and takes the model's handle (or name)
+
     void ComparePhysicalAttributesWithOtherModels();
 
-    void MakePhysicsHappen(sPhysicsProperties* physicsModel, std::string Model2, std::string collisionType);
+    void MakePhysicsHappen(sPhysicsProperties* physicsModel, unsigned int model2Handle, std::string collisionType);
+    void MakePhysicsHappen(sPhysicsProperties* physicsModel, const std::string& Model2, std::string collisionType);
 
-    void ChangeModelPhysicsPosition(std::string modelName, float newPositionX, float newPositionY, float newPositionZ);
+    void ChangeModelPhysicsPosition(unsigned int modelHandle, float newPositionX, float newPositionY, float newPositionZ);
+    void ChangeModelPhysicsPosition(const std::string& modelName, float newPositionX, float newPositionY, float newPositionZ);
 
-    void AddSpherePhysicsToMesh(std::string modelName, std::string physicsMeshType, float objectRadius);
+    // One physics model per model
+    void AddSpherePhysicsToMesh(unsigned int modelHandle, std::string physicsMeshType, float objectRadius);
+    void AddSpherePhysicsToMesh(const std::string& modelName, std::string physicsMeshType, float objectRadius);
 
-    void AddPlanePhysicsToMesh(std::string modelName, std::string physicsMeshType);
+    void AddPlanePhysicsToMesh(unsigned int modelHandle, std::string physicsMeshType);
+    void AddPlanePhysicsToMesh(const std::string& modelName, std::string physicsMeshType);
 
-    void ChangeModelPhysicsVelocity(std::string modelName, glm::vec3 velocityChange);
+    void ChangeModelPhysicsVelocity(unsigned int modelHandle, glm::vec3 velocityChange);
+    void ChangeModelPhysicsVelocity(const std::string& modelName, glm::vec3 velocityChange);
 
-    void ChangeModelPhysicsAcceleration(std::string modelName, glm::vec3 accelerationChange);
+    void ChangeModelPhysicsAcceleration(unsigned int modelHandle, glm::vec3 accelerationChange);
+    void ChangeModelPhysicsAcceleration(const std::string& modelName, glm::vec3 accelerationChange);
 
-    int ChangeModelPhysicalMass(std::string modelName, float mass);
+    int ChangeModelPhysicalMass(unsigned int modelHandle, float mass);
+    int ChangeModelPhysicalMass(const std::string& modelName, float mass);
 
     void ResetPosition(sPhysicsProperties* physicsModel);
 
@@ -171,7 +361,37 @@ public:
 
     //-------------------Engine Controls---------------------------------------------------
 
-    void LoadModelsInto3DSpace(std::string filePath, std::string modelName, float initial_x, float initial_y, float initial_z);
+    // Meshes sharing a model, LOD and polygon mode are drawn with one instanced draw (on by default)
+    void EnableInstancing(bool enable);
+
+    // Vertex buffer layout for models loaded after this call (compact by default)
+    void ChangeVertexFormat(eVertexFormat vertexFormat);
+
+    // Reads and decodes the files on worker threads, then uploads them on this thread.
+    // LoadModelsInto3DSpace then just shares the already loaded files.
+    sModelLoadTimings PreloadModelFiles(std::vector<std::string> filePaths);
+
+    // Frees the vertex / index arrays kept after upload, except for the files that plane
+    //	physics reads (AddPlanePhysicsToMesh). Call once GetModelVertices isn't needed anymore.
+    // Returns the bytes freed.
+    std::size_t ReleaseModelGeometry();
+
+    // bIsDynamicMesh gives the file a vertex buffer that UpdateDynamicModelVertices can rewrite
+    //	(only if this is the first model using the file).
+    // Returns the model's handle, INVALID_MODEL_HANDLE if it couldn't be loaded.
+    unsigned int LoadModelsInto3DSpace(std::string filePath, std::string modelName, float initial_x, float initial_y, float initial_z, bool bIsDynamicMesh = false);
+
+    // How dynamic models loaded after this call update their vertex buffer (persistent mapped ring by default)
+    void ChangeDynamicBufferStrategy(eDynamicBufferStrategy dynamicBufferStrategy);
+
+    // The vertices of a dynamic model, shared by every model using its file, to be
+    //	edited in place. NULL if the model isn't dynamic.
+    sVertex* GetDynamicModelVertices(unsigned int modelHandle, unsigned int& numberOfVertices);
+    sVertex* GetDynamicModelVertices(const std::string& modelName, unsigned int& numberOfVertices);
+
+    // Uploads the edited range of the vertices (call once per frame, after the edits)
+    bool UpdateDynamicModelVertices(unsigned int modelHandle, unsigned int firstVertex, unsigned int numberOfVertices);
+    bool UpdateDynamicModelVertices(const std::string& modelName, unsigned int firstVertex, unsigned int numberOfVertices);
 
     int InitializeGameEngine();
 
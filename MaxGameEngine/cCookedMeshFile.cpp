@@ -0,0 +1,401 @@
+#include "cCookedMeshFile.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <system_error>
+#include <vector>
+
+// Arrays start on a 64 byte boundary after the header
+static const unsigned int COOKED_DATA_ALIGNMENT = 64;
+
+cCookedMeshFile::cCookedMeshFile()
+{
+	this->m_pHeader = NULL;
+}
+
+std::string cCookedMeshFile::CookedFileNameFor(const std::string& sourceFileName)
+{
+	return sourceFileName + ".cooked";
+}
+
+bool cCookedMeshFile::Open(const std::string& sourceFileName, unsigned int requiredFlags)
+{
+	this->Close();
+
+	std::string cookedFileName = cCookedMeshFile::CookedFileNameFor(sourceFileName);
+
+	if (!this->m_mappedFile.Open(cookedFileName))
+	{
+		this->m_lastError = "No cooked file : " + cookedFileName;
+		return false;
+	}
+
+	if (!this->m_IsHeaderValid(requiredFlags))
+	{
+		this->Close();
+		return false;
+	}
+
+	unsigned long long sourceFileSize = 0;
+	long long sourceWriteTime = 0;
+
+	if (!cCookedMeshFile::m_GetSourceStamp(sourceFileName, sourceFileSize, sourceWriteTime))
+	{
+		// Only the cooked file was shipped, use it as it is
+		return true;
+	}
+
+	if (sourceFileSize == this->m_pHeader->sourceFileSize && sourceWriteTime == this->m_pHeader->sourceWriteTime)
+		return true;
+
+	// The time stamp changes on a checkout or copy, so compare the contents before re-cooking
+	unsigned long long sourceHash = 0;
+
+	if (!cCookedMeshFile::m_HashFile(sourceFileName, sourceHash) || sourceHash != this->m_pHeader->sourceHash)
+	{
+		this->m_lastError = "Source changed since it was cooked : " + sourceFileName;
+		this->Close();
+		return false;
+	}
+
+	// Same contents : refresh the stamp so the hash isn't needed next time
+	this->m_mappedFile.Close();
+	this->m_pHeader = NULL;
+
+	{
+		std::fstream cookedFile(cookedFileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+
+		if (cookedFile.is_open())
+		{
+			cookedFile.seekp(offsetof(sHeader, sourceFileSize));
+			cookedFile.write(reinterpret_cast<const char*>(&sourceFileSize), sizeof(sourceFileSize));
+			cookedFile.write(reinterpret_cast<const char*>(&sourceWriteTime), sizeof(sourceWriteTime));
+		}
+	}
+
+	if (!this->m_mappedFile.Open(cookedFileName) || !this->m_IsHeaderValid(requiredFlags))
+	{
+		this->Close();
+		return false;
+	}
+
+	return true;
+}
+
+void cCookedMeshFile::Close(void)
+{
+	this->m_mappedFile.Close();
+	this->m_pHeader = NULL;
+
+	return;
+}
+
+const cCookedMeshFile::sHeader* cCookedMeshFile::getHeader(void) const
+{
+	return this->m_pHeader;
+}
+
+const sVertex* cCookedMeshFile::getVertices(void) const
+{
+	if (this->m_pHeader == NULL)
+		return NULL;
+
+	return reinterpret_cast<const sVertex*>(this->m_mappedFile.getData() + this->m_pHeader->vertexDataOffset);
+}
+
+const unsigned int* cCookedMeshFile::getIndices(void) const
+{
+	if (this->m_pHeader == NULL)
+		return NULL;
+
+	return reinterpret_cast<const unsigned int*>(this->m_mappedFile.getData() + this->m_pHeader->indexDataOffset);
+}
+
+const cCookedMeshFile::sLODEntry* cCookedMeshFile::getLODs(void) const
+{
+	if (this->m_pHeader == NULL || this->m_pHeader->numberOfLODs == 0)
+		return NULL;
+
+	return reinterpret_cast<const sLODEntry*>(this->m_mappedFile.getData() + this->m_pHeader->lodDataOffset);
+}
+
+bool cCookedMeshFile::CopyInto(sModelDrawInfo& drawInfo)
+{
+	if (this->m_pHeader == NULL)
+	{
+		this->m_lastError = "No cooked file is open";
+		return false;
+	}
+
+	//-------------------Indices, checked on the way-----------------
+
+	// A damaged or stale file would have the physics and the GPU read past the vertices
+	const unsigned int* pSourceIndices = this->getIndices();
+	unsigned int* pIndices = new unsigned int[this->m_pHeader->numberOfIndices];
+
+	unsigned int largestIndex = 0;
+
+	for (unsigned int index = 0; index != this->m_pHeader->numberOfIndices; index++)
+	{
+		pIndices[index] = pSourceIndices[index];
+		largestIndex = std::max(largestIndex, pSourceIndices[index]);
+	}
+
+	if (this->m_pHeader->numberOfIndices != 0 && largestIndex >= this->m_pHeader->numberOfVertices)
+	{
+		delete[] pIndices;
+
+		this->m_lastError = "Cooked file is corrupt (an index is past the last vertex)";
+		return false;
+	}
+
+	drawInfo.numberOfVertices = this->m_pHeader->numberOfVertices;
+	drawInfo.numberOfIndices = this->m_pHeader->numberOfIndices;
+	drawInfo.numberOfTriangles = this->m_pHeader->numberOfTriangles;
+
+	drawInfo.pVertices = new sVertex[drawInfo.numberOfVertices];
+	drawInfo.pIndices = pIndices;
+
+	memcpy(drawInfo.pVertices, this->getVertices(), sizeof(sVertex) * drawInfo.numberOfVertices);
+
+	drawInfo.minExtents_XYZ = glm::vec3(this->m_pHeader->minExtents_XYZ[0], this->m_pHeader->minExtents_XYZ[1], this->m_pHeader->minExtents_XYZ[2]);
+	drawInfo.maxExtents_XYZ = glm::vec3(this->m_pHeader->maxExtents_XYZ[0], this->m_pHeader->maxExtents_XYZ[1], this->m_pHeader->maxExtents_XYZ[2]);
+	drawInfo.deltaExtents_XYZ = drawInfo.maxExtents_XYZ - drawInfo.minExtents_XYZ;
+	drawInfo.maxExtent = this->m_pHeader->maxExtent;
+
+	drawInfo.boundingSphereCentre = glm::vec3(this->m_pHeader->boundingSphere[0], this->m_pHeader->boundingSphere[1], this->m_pHeader->boundingSphere[2]);
+	drawInfo.boundingSphereRadius = this->m_pHeader->boundingSphere[3];
+
+	drawInfo.vecLODs.clear();
+
+	const sLODEntry* pLODs = this->getLODs();
+
+	for (unsigned int lodIndex = 0; lodIndex != this->m_pHeader->numberOfLODs; lodIndex++)
+	{
+		sMeshLOD lod;
+		lod.firstIndex = pLODs[lodIndex].firstIndex;
+		lod.numberOfIndices = pLODs[lodIndex].numberOfIndices;
+		lod.error = pLODs[lodIndex].error;
+		lod.firstSubMesh = 0;
+		lod.numberOfSubMeshes = 0;
+
+		drawInfo.vecLODs.push_back(lod);
+	}
+
+	drawInfo.bIsOptimized = (this->m_pHeader->flags & COOKED_FLAG_OPTIMIZED) != 0;
+	drawInfo.cacheStatsBefore.ACMR = this->m_pHeader->cacheStatsBefore[0];
+	drawInfo.cacheStatsBefore.ATVR = this->m_pHeader->cacheStatsBefore[1];
+	drawInfo.cacheStatsAfter.ACMR = this->m_pHeader->cacheStatsAfter[0];
+	drawInfo.cacheStatsAfter.ATVR = this->m_pHeader->cacheStatsAfter[1];
+
+	return true;
+}
+
+bool cCookedMeshFile::Write(const std::string& sourceFileName, const sModelDrawInfo& drawInfo, unsigned int cookedFlags, std::string& errorText)
+{
+	sHeader header;
+	memset(&header, 0, sizeof(header));
+
+	header.magic = cCookedMeshFile::COOKED_MAGIC;
+	header.version = cCookedMeshFile::COOKED_VERSION;
+	header.vertexSize = sizeof(sVertex);
+	header.indexSize = sizeof(unsigned int);
+
+	if (!cCookedMeshFile::m_GetSourceStamp(sourceFileName, header.sourceFileSize, header.sourceWriteTime) ||
+		!cCookedMeshFile::m_HashFile(sourceFileName, header.sourceHash))
+	{
+		errorText = "Can't read the source file : " + sourceFileName;
+		return false;
+	}
+
+	header.numberOfVertices = drawInfo.numberOfVertices;
+	header.numberOfIndices = drawInfo.numberOfIndices;
+	header.numberOfTriangles = drawInfo.numberOfTriangles;
+
+	header.vertexDataOffset = ((sizeof(sHeader) + COOKED_DATA_ALIGNMENT - 1) / COOKED_DATA_ALIGNMENT) * COOKED_DATA_ALIGNMENT;
+	header.indexDataOffset = header.vertexDataOffset + header.vertexSize * header.numberOfVertices;
+
+	std::vector<sLODEntry> vecLODEntries(drawInfo.vecLODs.size());
+
+	for (unsigned int lodIndex = 0; lodIndex != drawInfo.vecLODs.size(); lodIndex++)
+	{
+		vecLODEntries[lodIndex].firstIndex = drawInfo.vecLODs[lodIndex].firstIndex;
+		vecLODEntries[lodIndex].numberOfIndices = drawInfo.vecLODs[lodIndex].numberOfIndices;
+		vecLODEntries[lodIndex].error = drawInfo.vecLODs[lodIndex].error;
+	}
+
+	header.numberOfLODs = (unsigned int)vecLODEntries.size();
+	header.lodDataOffset = header.indexDataOffset + header.indexSize * header.numberOfIndices;
+
+	for (unsigned int axis = 0; axis != 3; axis++)
+	{
+		header.minExtents_XYZ[axis] = drawInfo.minExtents_XYZ[axis];
+		header.maxExtents_XYZ[axis] = drawInfo.maxExtents_XYZ[axis];
+		header.boundingSphere[axis] = drawInfo.boundingSphereCentre[axis];
+	}
+
+	header.boundingSphere[3] = drawInfo.boundingSphereRadius;
+
+	header.maxExtent = drawInfo.maxExtent;
+
+	header.flags = cookedFlags;
+	header.cacheStatsBefore[0] = drawInfo.cacheStatsBefore.ACMR;
+	header.cacheStatsBefore[1] = drawInfo.cacheStatsBefore.ATVR;
+	header.cacheStatsAfter[0] = drawInfo.cacheStatsAfter.ACMR;
+	header.cacheStatsAfter[1] = drawInfo.cacheStatsAfter.ATVR;
+
+	// Written to a temp file first so a crash never leaves a half written cache behind
+	std::string cookedFileName = cCookedMeshFile::CookedFileNameFor(sourceFileName);
+	std::string tempFileName = cookedFileName + ".tmp";
+
+	{
+		std::ofstream cookedFile(tempFileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if (!cookedFile.is_open())
+		{
+			errorText = "Can't create the cooked file : " + tempFileName;
+			return false;
+		}
+
+		char padding[COOKED_DATA_ALIGNMENT] = { 0 };
+
+		cookedFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		cookedFile.write(padding, header.vertexDataOffset - sizeof(header));
+		cookedFile.write(reinterpret_cast<const char*>(drawInfo.pVertices), sizeof(sVertex) * header.numberOfVertices);
+		cookedFile.write(reinterpret_cast<const char*>(drawInfo.pIndices), sizeof(unsigned int) * header.numberOfIndices);
+
+		if (!vecLODEntries.empty())
+			cookedFile.write(reinterpret_cast<const char*>(vecLODEntries.data()), sizeof(sLODEntry) * vecLODEntries.size());
+
+		if (!cookedFile.good())
+		{
+			errorText = "Can't write the cooked file : " + tempFileName;
+			cookedFile.close();
+			std::remove(tempFileName.c_str());
+			return false;
+		}
+	}
+
+	std::error_code renameError;
+	std::filesystem::rename(tempFileName, cookedFileName, renameError);
+
+	if (renameError)
+	{
+		errorText = "Can't replace the cooked file : " + cookedFileName + " (" + renameError.message() + ")";
+		std::remove(tempFileName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+std::string cCookedMeshFile::getLastError(void) const
+{
+	return this->m_lastError;
+}
+
+bool cCookedMeshFile::m_GetSourceStamp(const std::string& sourceFileName, unsigned long long& fileSize, long long& writeTime)
+{
+	std::error_code fileError;
+
+	std::uintmax_t theFileSize = std::filesystem::file_size(sourceFileName, fileError);
+
+	if (fileError)
+		return false;
+
+	std::filesystem::file_time_type theWriteTime = std::filesystem::last_write_time(sourceFileName, fileError);
+
+	if (fileError)
+		return false;
+
+	fileSize = static_cast<unsigned long long>(theFileSize);
+	writeTime = static_cast<long long>(theWriteTime.time_since_epoch().count());
+
+	return true;
+}
+
+bool cCookedMeshFile::m_HashFile(const std::string& fileName, unsigned long long& hash)
+{
+	cMappedFile theFile;
+
+	if (!theFile.Open(fileName))
+		return false;
+
+	// 64 bit FNV-1a
+	unsigned long long theHash = 14695981039346656037ULL;
+
+	const unsigned char* pData = theFile.getData();
+
+	for (std::size_t index = 0; index != theFile.getSize(); index++)
+	{
+		theHash ^= pData[index];
+		theHash *= 1099511628211ULL;
+	}
+
+	hash = theHash;
+
+	return true;
+}
+
+bool cCookedMeshFile::m_IsHeaderValid(unsigned int requiredFlags)
+{
+	std::size_t fileSize = this->m_mappedFile.getSize();
+
+	if (fileSize < sizeof(sHeader))
+	{
+		this->m_lastError = "Cooked file is truncated";
+		return false;
+	}
+
+	const sHeader* pHeader = reinterpret_cast<const sHeader*>(this->m_mappedFile.getData());
+
+	if (pHeader->magic != cCookedMeshFile::COOKED_MAGIC || pHeader->version != cCookedMeshFile::COOKED_VERSION ||
+		pHeader->vertexSize != sizeof(sVertex) || pHeader->indexSize != sizeof(unsigned int))
+	{
+		this->m_lastError = "Cooked file is from another version";
+		return false;
+	}
+
+	if (pHeader->flags != requiredFlags)
+	{
+		this->m_lastError = "Cooked file was made with other options";
+		return false;
+	}
+
+	unsigned long long vertexDataEnd = pHeader->vertexDataOffset + static_cast<unsigned long long>(pHeader->vertexSize) * pHeader->numberOfVertices;
+	unsigned long long indexDataEnd = pHeader->indexDataOffset + static_cast<unsigned long long>(pHeader->indexSize) * pHeader->numberOfIndices;
+	unsigned long long lodDataEnd = pHeader->lodDataOffset + static_cast<unsigned long long>(sizeof(sLODEntry)) * pHeader->numberOfLODs;
+
+	// Without LODs the index array is LOD 0, with them LOD 0 is the first entry
+	unsigned int numberOfLOD0Indices = pHeader->numberOfIndices;
+
+	if (pHeader->numberOfLODs != 0 && lodDataEnd <= fileSize)
+		numberOfLOD0Indices = reinterpret_cast<const sLODEntry*>(this->m_mappedFile.getData() + pHeader->lodDataOffset)->numberOfIndices;
+
+	if (pHeader->vertexDataOffset < sizeof(sHeader) || vertexDataEnd > pHeader->indexDataOffset || indexDataEnd > fileSize ||
+		(pHeader->numberOfLODs != 0 && (pHeader->lodDataOffset < indexDataEnd || lodDataEnd > fileSize)) ||
+		numberOfLOD0Indices != pHeader->numberOfTriangles * 3)
+	{
+		this->m_lastError = "Cooked file is corrupt";
+		return false;
+	}
+
+	const sLODEntry* pLODs = reinterpret_cast<const sLODEntry*>(this->m_mappedFile.getData() + pHeader->lodDataOffset);
+
+	for (unsigned int lodIndex = 0; lodIndex != pHeader->numberOfLODs; lodIndex++)
+	{
+		if (static_cast<unsigned long long>(pLODs[lodIndex].firstIndex) + pLODs[lodIndex].numberOfIndices > pHeader->numberOfIndices)
+		{
+			this->m_lastError = "Cooked file is corrupt";
+			return false;
+		}
+	}
+
+	this->m_pHeader = pHeader;
+
+	return true;
+}
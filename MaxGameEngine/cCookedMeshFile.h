@@ -0,0 +1,110 @@
+#ifndef _cCookedMeshFile_HG_
+#define _cCookedMeshFile_HG_
+
+#include <string>
+
+#include "cMappedFile.h"
+#include "sModelDrawInfo.h"
+
+// Binary cache of a decoded mesh, written next to the source as "<file>.cooked".
+// Layout is the header, the full 48 byte sVertex array, the 32 bit index array, then
+//	the LOD table. What it saves is the PLY parse and the optimize / LOD steps: CopyInto
+//	copies the arrays out of the mapping to the heap (the physics and GetModelVertices
+//	read pVertices), and cVertexFormat packs them into the GPU layout and index width
+//	picked at load time before they're uploaded.
+// The header keeps the size, write time and hash of the source; if the source
+//	changes the cooked file is rejected and the caller cooks it again.
+class cCookedMeshFile
+{
+public:
+
+	static const unsigned int COOKED_MAGIC = 0x4D43474D;	// "MGCM"
+	static const unsigned int COOKED_VERSION = 5;
+
+	// sHeader::flags
+	static const unsigned int COOKED_FLAG_OPTIMIZED = 0x1;		// Went through cMeshOptimizer::Optimize
+	static const unsigned int COOKED_FLAG_SPLIT_16BIT = 0x2;	// Went through cMeshOptimizer::SplitFor16BitIndices
+	static const unsigned int COOKED_FLAG_LODS = 0x4;			// Went through cMeshSimplifier::BuildLODChain
+
+	// One entry of the LOD table (sub mesh ranges are worked out again when it's loaded)
+	struct sLODEntry
+	{
+		unsigned int firstIndex;
+		unsigned int numberOfIndices;
+		float error;
+	};
+
+	struct sHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int vertexSize;		// sizeof(sVertex) when it was cooked
+		unsigned int indexSize;			// sizeof(unsigned int) when it was cooked
+
+		unsigned long long sourceFileSize;
+		long long sourceWriteTime;
+		unsigned long long sourceHash;	// FNV-1a of the whole source file
+
+		unsigned int numberOfVertices;
+		unsigned int numberOfIndices;
+		unsigned int numberOfTriangles;	// LOD 0's
+		unsigned int vertexDataOffset;	// From the start of the file
+		unsigned int indexDataOffset;
+
+		unsigned int numberOfLODs;		// 0 if the mesh has LOD 0 only
+		unsigned int lodDataOffset;
+
+		float minExtents_XYZ[3];
+		float maxExtents_XYZ[3];
+		float maxExtent;
+		float boundingSphere[4];		// Centre XYZ, radius
+
+		unsigned int flags;
+		float cacheStatsBefore[2];		// ACMR, ATVR
+		float cacheStatsAfter[2];
+	};
+
+	cCookedMeshFile();
+
+	static std::string CookedFileNameFor(const std::string& sourceFileName);
+
+	// Maps the cooked file of sourceFileName. Fails if it's missing, from another
+	//	version, cooked with other flags, or the source has been modified since.
+	bool Open(const std::string& sourceFileName, unsigned int requiredFlags = 0);
+
+	void Close(void);
+
+	const sHeader* getHeader(void) const;
+
+	const sVertex* getVertices(void) const;
+
+	const unsigned int* getIndices(void) const;
+
+	const sLODEntry* getLODs(void) const;
+
+	// Fills the counts, extents and vecLODs and copies the arrays to the heap (pVertices, pIndices).
+	//	False (and nothing filled) if an index is past the last vertex.
+	bool CopyInto(sModelDrawInfo& drawInfo);
+
+	// drawInfo should already have its extents calculated. cookedFlags are the
+	//	COOKED_FLAG_ steps that were applied (Open has to ask for the same ones).
+	static bool Write(const std::string& sourceFileName, const sModelDrawInfo& drawInfo, unsigned int cookedFlags, std::string& errorText);
+
+	std::string getLastError(void) const;
+
+private:
+
+	static bool m_GetSourceStamp(const std::string& sourceFileName, unsigned long long& fileSize, long long& writeTime);
+
+	static bool m_HashFile(const std::string& fileName, unsigned long long& hash);
+
+	bool m_IsHeaderValid(unsigned int requiredFlags);
+
+	cMappedFile m_mappedFile;
+
+	const sHeader* m_pHeader;
+
+	std::string m_lastError;
+};
+
+#endif
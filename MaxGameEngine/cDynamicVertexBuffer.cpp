@@ -0,0 +1,271 @@
+#include "cDynamicVertexBuffer.h"
+#include "cVertexFormat.h"
+
+#include "../OpenGLCommon.h"
+
+#include <chrono>
+#include <iostream>
+
+sDynamicBufferStats::sDynamicBufferStats()
+{
+	this->numberOfUpdates = 0;
+	this->bytesUploaded = 0;
+	this->numberOfFenceWaits = 0;
+	this->fenceWaitTime = 0.0;
+}
+
+cDynamicVertexBuffer::cDynamicVertexBuffer()
+{
+	this->m_strategy = DYNAMIC_BUFFER_SUB_DATA;
+	this->m_vertexFormat = VERTEX_FORMAT_FLOAT;
+	this->m_vertexStride = 0;
+	this->m_numberOfVertices = 0;
+
+	this->m_pMappedRing = NULL;
+	this->m_currentRegion = 0;
+
+	for (unsigned int region = 0; region != REGIONS; region++)
+	{
+		this->m_regionFences[region] = NULL;
+		this->m_regionDirtyFirst[region] = 0;
+		this->m_regionDirtyLast[region] = 0;
+	}
+}
+
+cDynamicVertexBuffer::~cDynamicVertexBuffer()
+{
+	this->Reset();
+}
+
+void cDynamicVertexBuffer::Create(eDynamicBufferStrategy strategy, eVertexFormat vertexFormat, const sVertex* pVertices, unsigned int numberOfVertices)
+{
+	this->Reset();
+
+	this->m_strategy = strategy;
+	this->m_vertexFormat = vertexFormat;
+	this->m_vertexStride = cVertexFormat::getStride(vertexFormat);
+	this->m_numberOfVertices = numberOfVertices;
+
+	GLsizeiptr regionBytes = (GLsizeiptr)this->m_vertexStride * numberOfVertices;
+
+	//--------------------------Persistent mapped ring-----------------------------------------
+
+	if (this->m_strategy == DYNAMIC_BUFFER_PERSISTENT_RING)
+	{
+		if (GLAD_GL_VERSION_4_4 && glBufferStorage != NULL)
+		{
+			const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+			this->m_buffer.Create();
+
+			glBindBuffer(GL_ARRAY_BUFFER, this->m_buffer.getID());
+
+			glBufferStorage(GL_ARRAY_BUFFER, regionBytes * REGIONS, NULL, mapFlags);
+
+			this->m_pMappedRing = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionBytes * REGIONS, mapFlags);
+		}
+
+		if (this->m_pMappedRing != NULL)
+		{
+			// Every copy starts out as the loaded mesh
+			for (unsigned int region = 0; region != REGIONS; region++)
+				cVertexFormat::PackVertexRange(vertexFormat, pVertices, numberOfVertices, this->m_pMappedRing + regionBytes * region);
+
+			this->m_currentRegion = 0;
+
+			return;
+		}
+
+		std::cout << "Warning : persistent mapped buffers need GL 4.4, the dynamic buffer orphans instead" << std::endl;
+
+		this->m_strategy = DYNAMIC_BUFFER_ORPHAN;
+	}
+
+	//--------------------------Sub data / orphaning------------------------------------------
+
+	this->m_buffer.Create();
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->m_buffer.getID());
+
+	glBufferData(GL_ARRAY_BUFFER,
+		regionBytes,
+		this->m_Pack(pVertices, numberOfVertices),
+		(this->m_strategy == DYNAMIC_BUFFER_ORPHAN ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW));
+
+	return;
+}
+
+unsigned int cDynamicVertexBuffer::Update(const sVertex* pAllVertices, unsigned int firstVertex, unsigned int numberOfVertices)
+{
+	if (this->m_buffer.getID() == 0 || firstVertex >= this->m_numberOfVertices)
+		return this->m_currentRegion * this->m_numberOfVertices;
+
+	if (numberOfVertices > this->m_numberOfVertices - firstVertex)
+		numberOfVertices = this->m_numberOfVertices - firstVertex;
+
+	this->m_stats.numberOfUpdates++;
+
+	switch (this->m_strategy)
+	{
+	case DYNAMIC_BUFFER_SUB_DATA:
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, this->m_buffer.getID());
+
+		glBufferSubData(GL_ARRAY_BUFFER,
+			(GLintptr)this->m_vertexStride * firstVertex,
+			(GLsizeiptr)this->m_vertexStride * numberOfVertices,
+			this->m_Pack(pAllVertices + firstVertex, numberOfVertices));
+
+		this->m_stats.bytesUploaded += (std::size_t)this->m_vertexStride * numberOfVertices;
+
+		return 0;
+	}
+
+	case DYNAMIC_BUFFER_ORPHAN:
+	{
+		// The old storage stays alive until the GPU is done with it, so this never waits,
+		//	but the whole mesh goes up every time
+		GLsizeiptr bufferBytes = (GLsizeiptr)this->m_vertexStride * this->m_numberOfVertices;
+
+		glBindBuffer(GL_ARRAY_BUFFER, this->m_buffer.getID());
+
+		glBufferData(GL_ARRAY_BUFFER, bufferBytes, NULL, GL_STREAM_DRAW);
+
+		glBufferSubData(GL_ARRAY_BUFFER, 0, bufferBytes, this->m_Pack(pAllVertices, this->m_numberOfVertices));
+
+		this->m_stats.bytesUploaded += (std::size_t)bufferBytes;
+
+		return 0;
+	}
+
+	default:
+		break;
+	}
+
+	//--------------------------Persistent mapped ring-----------------------------------------
+
+	// Every copy is missing this range now
+	for (unsigned int region = 0; region != REGIONS; region++)
+	{
+		if (this->m_regionDirtyFirst[region] == this->m_regionDirtyLast[region])
+		{
+			this->m_regionDirtyFirst[region] = firstVertex;
+			this->m_regionDirtyLast[region] = firstVertex + numberOfVertices;
+		}
+		else
+		{
+			if (firstVertex < this->m_regionDirtyFirst[region])
+				this->m_regionDirtyFirst[region] = firstVertex;
+
+			if (firstVertex + numberOfVertices > this->m_regionDirtyLast[region])
+				this->m_regionDirtyLast[region] = firstVertex + numberOfVertices;
+		}
+	}
+
+	// Everything drawn since the last update used the current copy
+	if (this->m_regionFences[this->m_currentRegion] != NULL)
+		glDeleteSync((GLsync)this->m_regionFences[this->m_currentRegion]);
+
+	this->m_regionFences[this->m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	unsigned int nextRegion = (this->m_currentRegion + 1) % REGIONS;
+
+	this->m_WaitForRegion(nextRegion);
+
+	unsigned int dirtyFirst = this->m_regionDirtyFirst[nextRegion];
+	unsigned int dirtyCount = this->m_regionDirtyLast[nextRegion] - dirtyFirst;
+
+	std::size_t regionOffset = (std::size_t)this->m_vertexStride * (nextRegion * this->m_numberOfVertices + dirtyFirst);
+
+	cVertexFormat::PackVertexRange(this->m_vertexFormat, pAllVertices + dirtyFirst, dirtyCount, this->m_pMappedRing + regionOffset);
+
+	this->m_regionDirtyFirst[nextRegion] = 0;
+	this->m_regionDirtyLast[nextRegion] = 0;
+
+	this->m_stats.bytesUploaded += (std::size_t)this->m_vertexStride * dirtyCount;
+
+	this->m_currentRegion = nextRegion;
+
+	return this->m_currentRegion * this->m_numberOfVertices;
+}
+
+void cDynamicVertexBuffer::Reset(void)
+{
+	for (unsigned int region = 0; region != REGIONS; region++)
+	{
+		if (this->m_regionFences[region] != NULL)
+			glDeleteSync((GLsync)this->m_regionFences[region]);
+
+		this->m_regionFences[region] = NULL;
+		this->m_regionDirtyFirst[region] = 0;
+		this->m_regionDirtyLast[region] = 0;
+	}
+
+	// Deleting the buffer unmaps it
+	this->m_pMappedRing = NULL;
+	this->m_currentRegion = 0;
+
+	this->m_buffer.Reset();
+
+	return;
+}
+
+unsigned int cDynamicVertexBuffer::getBufferID(void) const
+{
+	return this->m_buffer.getID();
+}
+
+eDynamicBufferStrategy cDynamicVertexBuffer::getStrategy(void) const
+{
+	return this->m_strategy;
+}
+
+sDynamicBufferStats cDynamicVertexBuffer::getStats(void) const
+{
+	return this->m_stats;
+}
+
+const void* cDynamicVertexBuffer::m_Pack(const sVertex* pVertices, unsigned int numberOfVertices)
+{
+	if (this->m_vertexFormat == VERTEX_FORMAT_FLOAT)
+		return pVertices;
+
+	this->m_vecScratch.resize((std::size_t)this->m_vertexStride * numberOfVertices);
+
+	cVertexFormat::PackVertexRange(this->m_vertexFormat, pVertices, numberOfVertices, this->m_vecScratch.data());
+
+	return this->m_vecScratch.data();
+}
+
+void cDynamicVertexBuffer::m_WaitForRegion(unsigned int region)
+{
+	GLsync regionFence = (GLsync)this->m_regionFences[region];
+
+	if (regionFence == NULL)
+		return;
+
+	GLenum waitResult = glClientWaitSync(regionFence, 0, 0);
+
+	if (waitResult == GL_TIMEOUT_EXPIRED)
+	{
+		std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+
+		// Flushes on the first wait so the fence can't sit in an unsubmitted command buffer
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+		while (waitResult == GL_TIMEOUT_EXPIRED)
+		{
+			waitResult = glClientWaitSync(regionFence, waitFlags, 1000000);		// 1 ms in nanoseconds
+			waitFlags = 0;
+		}
+
+		this->m_stats.numberOfFenceWaits++;
+		this->m_stats.fenceWaitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+	}
+
+	glDeleteSync(regionFence);
+
+	this->m_regionFences[region] = NULL;
+
+	return;
+}
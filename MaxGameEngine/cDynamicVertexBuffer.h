@@ -0,0 +1,98 @@
+#ifndef _cDynamicVertexBuffer_HG_
+#define _cDynamicVertexBuffer_HG_
+
+#include <vector>
+#include <cstddef>
+
+#include "sModelDrawInfo.h"
+#include "cGLResource.h"
+
+// How a dynamic model's vertex buffer gets its new vertices every update
+enum eDynamicBufferStrategy
+{
+	DYNAMIC_BUFFER_SUB_DATA,			// glBufferSubData of only the changed range (the driver may stall or copy if the GPU still reads it)
+	DYNAMIC_BUFFER_ORPHAN,				// glBufferData(NULL) then the whole mesh, the driver hands out fresh storage
+	DYNAMIC_BUFFER_PERSISTENT_RING		// Three copies in one persistently mapped buffer (GL 4.4), fenced, written in turn
+};
+
+struct sDynamicBufferStats
+{
+	sDynamicBufferStats();
+
+	unsigned int numberOfUpdates;
+	std::size_t bytesUploaded;
+
+	// Ring only : updates that had to wait for the GPU to finish with a copy
+	unsigned int numberOfFenceWaits;
+	double fenceWaitTime;				// Seconds
+};
+
+// Vertex buffer of a model whose vertices change after loading (deforming or
+//	procedurally generated meshes). Vertices are given as sVertex and packed into
+//	the model's vertex format on the way in.
+// The ring keeps REGIONS copies of the mesh back to back; each update writes the
+//	next copy and returns where it starts, which the model draws as its base vertex
+//	(sModelDrawInfo::VertexBuffer_Start_Index). A fence is put down after a copy's
+//	draws, so the CPU only waits if it laps the GPU.
+// Main thread only (GL calls).
+class cDynamicVertexBuffer
+{
+public:
+
+	static const unsigned int REGIONS = 3;
+
+	cDynamicVertexBuffer();
+	~cDynamicVertexBuffer();
+
+	// Creates and fills the buffer, bound to GL_ARRAY_BUFFER (bind the VAO first).
+	//	Without GL 4.4 the ring falls back to orphaning (see getStrategy).
+	void Create(eDynamicBufferStrategy strategy, eVertexFormat vertexFormat,
+		const sVertex* pVertices, unsigned int numberOfVertices);
+
+	// Uploads vertices [firstVertex, firstVertex + numberOfVertices) of pAllVertices
+	//	(every vertex of the mesh; orphaning and the ring read outside the range).
+	//	Returns the base vertex to draw with.
+	unsigned int Update(const sVertex* pAllVertices, unsigned int firstVertex, unsigned int numberOfVertices);
+
+	// Deletes the fences and the buffer
+	void Reset(void);
+
+	unsigned int getBufferID(void) const;
+
+	eDynamicBufferStrategy getStrategy(void) const;
+
+	sDynamicBufferStats getStats(void) const;
+
+private:
+
+	cDynamicVertexBuffer(const cDynamicVertexBuffer&);
+	cDynamicVertexBuffer& operator=(const cDynamicVertexBuffer&);
+
+	// Packs the range into m_vecScratch (or returns pVertices itself for the float layout)
+	const void* m_Pack(const sVertex* pVertices, unsigned int numberOfVertices);
+
+	// Blocks until the GPU is done with the region's last draws
+	void m_WaitForRegion(unsigned int region);
+
+	eDynamicBufferStrategy m_strategy;
+	eVertexFormat m_vertexFormat;
+	unsigned int m_vertexStride;
+	unsigned int m_numberOfVertices;
+
+	cGLBuffer m_buffer;
+
+	// Ring only
+	unsigned char* m_pMappedRing;
+	unsigned int m_currentRegion;
+	void* m_regionFences[REGIONS];				// GLsync, NULL once waited on
+
+	// Vertices [first, last) changed since the region was last written
+	unsigned int m_regionDirtyFirst[REGIONS];
+	unsigned int m_regionDirtyLast[REGIONS];
+
+	std::vector<unsigned char> m_vecScratch;
+
+	sDynamicBufferStats m_stats;
+};
+
+#endif
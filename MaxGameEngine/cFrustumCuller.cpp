@@ -0,0 +1,171 @@
+#include "cFrustumCuller.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "SSECommon.h"
+
+cFrustumCuller::cFrustumCuller()
+{
+	for (unsigned int plane = 0; plane != 6; plane++)
+		this->m_planes[plane] = glm::vec4(0.0f);
+}
+
+void cFrustumCuller::Cull(const glm::mat4& matViewProjection, std::vector<cMesh*>& vecMeshes, cThreadPool* pThreadPool)
+{
+	std::chrono::steady_clock::time_point cullStart = std::chrono::steady_clock::now();
+
+	unsigned int numberOfMeshes = (unsigned int)vecMeshes.size();
+
+	this->m_lastStats = sFrustumCullStats();
+	this->m_lastStats.numberOfMeshesTested = numberOfMeshes;
+	this->m_lastStats.numberOfThreads = 1;
+
+	//------------------------Planes from the matrix------------------------------------------
+	// (Gribb & Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix")
+
+	glm::vec4 row[4];
+
+	for (unsigned int rowIndex = 0; rowIndex != 4; rowIndex++)
+		row[rowIndex] = glm::vec4(matViewProjection[0][rowIndex], matViewProjection[1][rowIndex], matViewProjection[2][rowIndex], matViewProjection[3][rowIndex]);
+
+	this->m_planes[0] = row[3] + row[0];		// Left
+	this->m_planes[1] = row[3] - row[0];		// Right
+	this->m_planes[2] = row[3] + row[1];		// Bottom
+	this->m_planes[3] = row[3] - row[1];		// Top
+	this->m_planes[4] = row[3] + row[2];		// Near
+	this->m_planes[5] = row[3] - row[2];		// Far
+
+	// So the distance to the plane is in world units (compared against the radius)
+	for (unsigned int plane = 0; plane != 6; plane++)
+		this->m_planes[plane] /= glm::length(glm::vec3(this->m_planes[plane]));
+
+	//------------------------Test every mesh------------------------------------------------
+
+	this->m_vecCentreX.resize(numberOfMeshes);
+	this->m_vecCentreY.resize(numberOfMeshes);
+	this->m_vecCentreZ.resize(numberOfMeshes);
+	this->m_vecRadius.resize(numberOfMeshes);
+	this->m_vecMeshVisible.resize(numberOfMeshes);
+
+	if (pThreadPool != NULL && numberOfMeshes >= 2 * MIN_MESHES_PER_TASK)
+	{
+		unsigned int numberOfTasks = std::min(pThreadPool->getNumberOfThreads(), numberOfMeshes / MIN_MESHES_PER_TASK);
+
+		unsigned int meshesPerTask = (numberOfMeshes + numberOfTasks - 1) / numberOfTasks;
+
+		// Keep the tasks' ranges on whole groups of 4
+		meshesPerTask = (meshesPerTask + 3) & ~3u;
+
+		for (unsigned int firstMesh = 0; firstMesh < numberOfMeshes; firstMesh += meshesPerTask)
+		{
+			unsigned int lastMesh = std::min(firstMesh + meshesPerTask, numberOfMeshes);
+
+			pThreadPool->AddTask([this, &vecMeshes, firstMesh, lastMesh]()
+				{
+					this->m_CullRange(vecMeshes, firstMesh, lastMesh);
+				});
+		}
+
+		pThreadPool->WaitForAllTasks();
+
+		this->m_lastStats.numberOfThreads = numberOfTasks;
+	}
+	else
+		this->m_CullRange(vecMeshes, 0, numberOfMeshes);
+
+	//------------------------Keep the visible ones, in order--------------------------------
+
+	unsigned int numberOfVisible = 0;
+
+	for (unsigned int index = 0; index != numberOfMeshes; index++)
+	{
+		if (this->m_vecMeshVisible[index])
+			vecMeshes[numberOfVisible++] = vecMeshes[index];
+	}
+
+	vecMeshes.resize(numberOfVisible);
+
+	this->m_lastStats.numberOfMeshesCulled = numberOfMeshes - numberOfVisible;
+
+	this->m_lastStats.cullTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - cullStart).count();
+
+	return;
+}
+
+void cFrustumCuller::m_CullRange(const std::vector<cMesh*>& vecMeshes, unsigned int firstMesh, unsigned int lastMesh)
+{
+	//------------------------Pack the spheres-----------------------------------------------
+
+	// Cached in the mesh, only recalculated for the ones that moved
+	for (unsigned int index = firstMesh; index != lastMesh; index++)
+	{
+		glm::vec3 centre;
+		float radius;
+
+		vecMeshes[index]->getWorldBoundingSphere(centre, radius);
+
+		this->m_vecCentreX[index] = centre.x;
+		this->m_vecCentreY[index] = centre.y;
+		this->m_vecCentreZ[index] = centre.z;
+		this->m_vecRadius[index] = radius;
+	}
+
+	//------------------------Spheres against the planes---------------------------------------
+
+	unsigned int index = firstMesh;
+
+#if ENGINE_USE_SSE
+	for (; index + 4 <= lastMesh; index += 4)
+	{
+		__m128 centreX = _mm_loadu_ps(&this->m_vecCentreX[index]);
+		__m128 centreY = _mm_loadu_ps(&this->m_vecCentreY[index]);
+		__m128 centreZ = _mm_loadu_ps(&this->m_vecCentreZ[index]);
+		__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&this->m_vecRadius[index]));
+
+		// Lanes that are completely behind any one plane
+		__m128 outside = _mm_setzero_ps();
+
+		for (unsigned int plane = 0; plane != 6; plane++)
+		{
+			const glm::vec4& thePlane = this->m_planes[plane];
+
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(centreX, _mm_set1_ps(thePlane.x)), _mm_mul_ps(centreY, _mm_set1_ps(thePlane.y))),
+				_mm_add_ps(_mm_mul_ps(centreZ, _mm_set1_ps(thePlane.z)), _mm_set1_ps(thePlane.w)));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+
+		for (unsigned int lane = 0; lane != 4; lane++)
+			this->m_vecMeshVisible[index + lane] = ((outsideMask >> lane) & 1) ? 0 : 1;
+	}
+#endif
+
+	for (; index < lastMesh; index++)
+	{
+		glm::vec3 centre(this->m_vecCentreX[index], this->m_vecCentreY[index], this->m_vecCentreZ[index]);
+
+		unsigned char bVisible = 1;
+
+		for (unsigned int plane = 0; plane != 6; plane++)
+		{
+			if (glm::dot(glm::vec3(this->m_planes[plane]), centre) + this->m_planes[plane].w < -this->m_vecRadius[index])
+			{
+				bVisible = 0;
+				break;
+			}
+		}
+
+		this->m_vecMeshVisible[index] = bVisible;
+	}
+
+	return;
+}
+
+sFrustumCullStats cFrustumCuller::getLastStats(void) const
+{
+	return this->m_lastStats;
+}
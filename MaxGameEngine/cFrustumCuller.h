@@ -0,0 +1,59 @@
+#ifndef _cFrustumCuller_HG_
+#define _cFrustumCuller_HG_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "cMesh.h"
+#include "cThreadPool.h"
+
+// What the last Cull did
+struct sFrustumCullStats
+{
+	unsigned int numberOfMeshesTested = 0;
+	unsigned int numberOfMeshesCulled = 0;
+	unsigned int numberOfThreads = 0;			// 1 = culled on the main thread
+
+	double cullTime = 0.0;						// Seconds, wall clock
+};
+
+// Drops the meshes whose world bounding sphere (cMesh::getWorldBoundingSphere) is completely
+//	outside the view frustum. The spheres are packed into arrays and tested 4 at a time
+//	against the 6 planes of the frustum.
+class cFrustumCuller
+{
+public:
+
+	// Lists shorter than this are culled on the calling thread, longer ones are split
+	//	into tasks of at least this many meshes
+	static const unsigned int MIN_MESHES_PER_TASK = 1024;
+
+	cFrustumCuller();
+
+	// Removes the culled meshes from vecMeshes, the rest keep their order.
+	//	matViewProjection is matProjection * matView. pThreadPool can be NULL.
+	void Cull(const glm::mat4& matViewProjection, std::vector<cMesh*>& vecMeshes, cThreadPool* pThreadPool);
+
+	sFrustumCullStats getLastStats(void) const;
+
+private:
+
+	// Culls vecMeshes[firstMesh, lastMesh) into m_vecMeshVisible
+	void m_CullRange(const std::vector<cMesh*>& vecMeshes, unsigned int firstMesh, unsigned int lastMesh);
+
+	// a, b, c, d of each plane (inside when ax + by + cz + d >= 0), normalised
+	glm::vec4 m_planes[6];
+
+	// Bounding spheres, one array per part
+	std::vector<float> m_vecCentreX;
+	std::vector<float> m_vecCentreY;
+	std::vector<float> m_vecCentreZ;
+	std::vector<float> m_vecRadius;
+
+	// Not a vector<bool>, the tasks write their own ranges of it
+	std::vector<unsigned char> m_vecMeshVisible;
+
+	sFrustumCullStats m_lastStats;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "cGLResource.h"
+
+#include "../OpenGLCommon.h"
+
+//-------------------cGLBuffer-----------------
+
+cGLBuffer::cGLBuffer()
+{
+	this->m_ID = 0;
+}
+
+cGLBuffer::~cGLBuffer()
+{
+	this->Reset();
+}
+
+cGLBuffer::cGLBuffer(cGLBuffer&& other)
+{
+	this->m_ID = other.m_ID;
+	other.m_ID = 0;
+}
+
+cGLBuffer& cGLBuffer::operator=(cGLBuffer&& other)
+{
+	if (this != &other)
+	{
+		this->Reset();
+
+		this->m_ID = other.m_ID;
+		other.m_ID = 0;
+	}
+
+	return *this;
+}
+
+void cGLBuffer::Create(void)
+{
+	this->Reset();
+
+	glGenBuffers(1, &(this->m_ID));
+
+	return;
+}
+
+void cGLBuffer::Reset(void)
+{
+	if (this->m_ID != 0)
+		glDeleteBuffers(1, &(this->m_ID));
+
+	this->m_ID = 0;
+
+	return;
+}
+
+unsigned int cGLBuffer::getID(void) const
+{
+	return this->m_ID;
+}
+
+//-------------------cGLVertexArray-----------------
+
+cGLVertexArray::cGLVertexArray()
+{
+	this->m_ID = 0;
+}
+
+cGLVertexArray::~cGLVertexArray()
+{
+	this->Reset();
+}
+
+cGLVertexArray::cGLVertexArray(cGLVertexArray&& other)
+{
+	this->m_ID = other.m_ID;
+	other.m_ID = 0;
+}
+
+cGLVertexArray& cGLVertexArray::operator=(cGLVertexArray&& other)
+{
+	if (this != &other)
+	{
+		this->Reset();
+
+		this->m_ID = other.m_ID;
+		other.m_ID = 0;
+	}
+
+	return *this;
+}
+
+void cGLVertexArray::Create(void)
+{
+	this->Reset();
+
+	glGenVertexArrays(1, &(this->m_ID));
+
+	return;
+}
+
+void cGLVertexArray::Reset(void)
+{
+	if (this->m_ID != 0)
+		glDeleteVertexArrays(1, &(this->m_ID));
+
+	this->m_ID = 0;
+
+	return;
+}
+
+unsigned int cGLVertexArray::getID(void) const
+{
+	return this->m_ID;
+}
@@ -0,0 +1,60 @@
+#ifndef _cGLResource_HG_
+#define _cGLResource_HG_
+
+// Owners of a single GL object name, deleted when the owner goes away.
+// They can be moved (e.g. into a map entry) but not copied, so a name can
+//	never be deleted twice. Only create / destroy them with the context current.
+
+class cGLBuffer
+{
+public:
+
+	cGLBuffer();
+	~cGLBuffer();
+
+	cGLBuffer(cGLBuffer&& other);
+	cGLBuffer& operator=(cGLBuffer&& other);
+
+	// glGenBuffers (any buffer already held is deleted first)
+	void Create(void);
+
+	// glDeleteBuffers
+	void Reset(void);
+
+	unsigned int getID(void) const;
+
+private:
+
+	cGLBuffer(const cGLBuffer&);
+	cGLBuffer& operator=(const cGLBuffer&);
+
+	unsigned int m_ID;
+};
+
+class cGLVertexArray
+{
+public:
+
+	cGLVertexArray();
+	~cGLVertexArray();
+
+	cGLVertexArray(cGLVertexArray&& other);
+	cGLVertexArray& operator=(cGLVertexArray&& other);
+
+	// glGenVertexArrays (any VAO already held is deleted first)
+	void Create(void);
+
+	// glDeleteVertexArrays
+	void Reset(void);
+
+	unsigned int getID(void) const;
+
+private:
+
+	cGLVertexArray(const cGLVertexArray&);
+	cGLVertexArray& operator=(const cGLVertexArray&);
+
+	unsigned int m_ID;
+};
+
+#endif
@@ -0,0 +1,450 @@
+#include "cGeometryArena.h"
+#include "cVertexFormat.h"
+
+#include "../OpenGLCommon.h"
+
+#include <algorithm>
+
+// Index ranges start on this boundary so 32 bit indices stay aligned
+static const unsigned int ARENA_INDEX_ALIGNMENT = 4;
+
+//-------------------sGeometryArenaStats-----------------
+
+sGeometryArenaStats::sGeometryArenaStats()
+{
+	this->numberOfAllocations = 0;
+
+	this->vertexBytesCapacity = 0;
+	this->vertexBytesUsed = 0;
+	this->largestFreeVertexBytes = 0;
+
+	this->indexBytesCapacity = 0;
+	this->indexBytesUsed = 0;
+	this->largestFreeIndexBytes = 0;
+
+	this->vertexFragmentation = 0.0f;
+	this->indexFragmentation = 0.0f;
+
+	this->numberOfGrowths = 0;
+	this->numberOfCompactions = 0;
+}
+
+//-------------------cRangeAllocator-----------------
+
+cGeometryArena::cRangeAllocator::cRangeAllocator()
+{
+	this->m_capacity = 0;
+}
+
+void cGeometryArena::cRangeAllocator::Reset(unsigned int capacity, unsigned int usedSize)
+{
+	this->m_capacity = capacity;
+	this->m_vecFreeRanges.clear();
+
+	if (usedSize < capacity)
+	{
+		sRange freeRange;
+		freeRange.offset = usedSize;
+		freeRange.size = capacity - usedSize;
+
+		this->m_vecFreeRanges.push_back(freeRange);
+	}
+
+	return;
+}
+
+bool cGeometryArena::cRangeAllocator::Allocate(unsigned int size, unsigned int& offset)
+{
+	for (unsigned int rangeIndex = 0; rangeIndex != this->m_vecFreeRanges.size(); rangeIndex++)
+	{
+		sRange& freeRange = this->m_vecFreeRanges[rangeIndex];
+
+		if (freeRange.size < size)
+			continue;
+
+		offset = freeRange.offset;
+
+		freeRange.offset += size;
+		freeRange.size -= size;
+
+		if (freeRange.size == 0)
+			this->m_vecFreeRanges.erase(this->m_vecFreeRanges.begin() + rangeIndex);
+
+		return true;
+	}
+
+	return false;
+}
+
+void cGeometryArena::cRangeAllocator::Free(unsigned int offset, unsigned int size)
+{
+	if (size == 0)
+		return;
+
+	sRange newRange;
+	newRange.offset = offset;
+	newRange.size = size;
+
+	std::vector<sRange>::iterator itNext = std::lower_bound(this->m_vecFreeRanges.begin(), this->m_vecFreeRanges.end(), newRange,
+		[](const sRange& first, const sRange& second) { return first.offset < second.offset; });
+
+	itNext = this->m_vecFreeRanges.insert(itNext, newRange);
+
+	// Merge with the range after, then with the one before
+	std::vector<sRange>::iterator itAfter = itNext + 1;
+
+	if (itAfter != this->m_vecFreeRanges.end() && itNext->offset + itNext->size == itAfter->offset)
+	{
+		itNext->size += itAfter->size;
+		itNext = this->m_vecFreeRanges.erase(itAfter) - 1;
+	}
+
+	if (itNext != this->m_vecFreeRanges.begin())
+	{
+		std::vector<sRange>::iterator itBefore = itNext - 1;
+
+		if (itBefore->offset + itBefore->size == itNext->offset)
+		{
+			itBefore->size += itNext->size;
+			this->m_vecFreeRanges.erase(itNext);
+		}
+	}
+
+	return;
+}
+
+unsigned int cGeometryArena::cRangeAllocator::getCapacity(void) const
+{
+	return this->m_capacity;
+}
+
+unsigned int cGeometryArena::cRangeAllocator::getFreeSize(void) const
+{
+	unsigned int freeSize = 0;
+
+	for (unsigned int rangeIndex = 0; rangeIndex != this->m_vecFreeRanges.size(); rangeIndex++)
+		freeSize += this->m_vecFreeRanges[rangeIndex].size;
+
+	return freeSize;
+}
+
+unsigned int cGeometryArena::cRangeAllocator::getLargestFreeSize(void) const
+{
+	unsigned int largestSize = 0;
+
+	for (unsigned int rangeIndex = 0; rangeIndex != this->m_vecFreeRanges.size(); rangeIndex++)
+		largestSize = std::max(largestSize, this->m_vecFreeRanges[rangeIndex].size);
+
+	return largestSize;
+}
+
+//-------------------cGeometryArena-----------------
+
+cGeometryArena::cGeometryArena()
+{
+	this->m_vertexFormat = VERTEX_FORMAT_FLOAT;
+	this->m_vertexStride = 0;
+	this->m_shaderProgramID = 0;
+
+	this->m_nextAllocationID = INVALID_ALLOCATION + 1;
+	this->m_generation = 0;
+
+	this->m_numberOfGrowths = 0;
+	this->m_numberOfCompactions = 0;
+}
+
+unsigned int cGeometryArena::Allocate(eVertexFormat vertexFormat, unsigned int shaderProgramID,
+	const void* pVertexData, unsigned int numberOfVertices,
+	const void* pIndexData, unsigned int numberOfIndexBytes)
+{
+	//-----------------------------Buffers on first use----------------------------------------
+
+	if (this->m_vertexArray.getID() == 0)
+	{
+		this->m_vertexFormat = vertexFormat;
+		this->m_vertexStride = cVertexFormat::getStride(vertexFormat);
+		this->m_shaderProgramID = shaderProgramID;
+
+		this->m_vertexArray.Create();
+
+		this->m_Rebuild(std::max(DEFAULT_VERTEX_CAPACITY, numberOfVertices),
+			std::max(DEFAULT_INDEX_CAPACITY, numberOfIndexBytes + ARENA_INDEX_ALIGNMENT));
+	}
+
+	if (vertexFormat != this->m_vertexFormat)
+		return INVALID_ALLOCATION;
+
+	unsigned int alignedIndexBytes = (numberOfIndexBytes + ARENA_INDEX_ALIGNMENT - 1) / ARENA_INDEX_ALIGNMENT * ARENA_INDEX_ALIGNMENT;
+
+	//-----------------------------Find space (compact or grow if needed)----------------------
+
+	sAllocation newAllocation;
+	newAllocation.numberOfVertices = numberOfVertices;
+	newAllocation.numberOfIndexBytes = numberOfIndexBytes;
+
+	bool bHasVertexSpace = this->m_vertexAllocator.getLargestFreeSize() >= numberOfVertices;
+	bool bHasIndexSpace = this->m_indexAllocator.getLargestFreeSize() >= alignedIndexBytes;
+
+	if (!bHasVertexSpace || !bHasIndexSpace)
+	{
+		unsigned int usedVertices = this->m_vertexAllocator.getCapacity() - this->m_vertexAllocator.getFreeSize();
+		unsigned int usedIndexBytes = this->m_indexAllocator.getCapacity() - this->m_indexAllocator.getFreeSize();
+
+		unsigned int vertexCapacity = this->m_vertexAllocator.getCapacity();
+		unsigned int indexByteCapacity = this->m_indexAllocator.getCapacity();
+
+		// Double until it fits once packed
+		while (usedVertices + numberOfVertices > vertexCapacity)
+			vertexCapacity *= 2;
+
+		while (usedIndexBytes + alignedIndexBytes > indexByteCapacity)
+			indexByteCapacity *= 2;
+
+		if (vertexCapacity != this->m_vertexAllocator.getCapacity() || indexByteCapacity != this->m_indexAllocator.getCapacity())
+			this->m_numberOfGrowths++;
+		else
+			this->m_numberOfCompactions++;
+
+		this->m_Rebuild(vertexCapacity, indexByteCapacity);
+	}
+
+	if (!this->m_vertexAllocator.Allocate(numberOfVertices, newAllocation.firstVertex))
+		return INVALID_ALLOCATION;
+
+	if (!this->m_indexAllocator.Allocate(alignedIndexBytes, newAllocation.firstIndexByte))
+	{
+		this->m_vertexAllocator.Free(newAllocation.firstVertex, numberOfVertices);
+		return INVALID_ALLOCATION;
+	}
+
+	//-----------------------------Upload------------------------------------------------------
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->m_vertexBuffer.getID());
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)newAllocation.firstVertex * this->m_vertexStride,
+		(GLsizeiptr)numberOfVertices * this->m_vertexStride, pVertexData);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// The element binding is VAO state, so go through GL_COPY_WRITE_BUFFER
+	glBindBuffer(GL_COPY_WRITE_BUFFER, this->m_indexBuffer.getID());
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)newAllocation.firstIndexByte, (GLsizeiptr)numberOfIndexBytes, pIndexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	unsigned int allocationID = this->m_nextAllocationID;
+	this->m_nextAllocationID++;
+
+	this->m_map_ID_to_Allocation[allocationID] = newAllocation;
+
+	return allocationID;
+}
+
+void cGeometryArena::Free(unsigned int allocationID)
+{
+	std::map< unsigned int, sAllocation >::iterator itAllocation = this->m_map_ID_to_Allocation.find(allocationID);
+
+	if (itAllocation == this->m_map_ID_to_Allocation.end())
+		return;
+
+	const sAllocation& allocation = itAllocation->second;
+
+	unsigned int alignedIndexBytes = (allocation.numberOfIndexBytes + ARENA_INDEX_ALIGNMENT - 1) / ARENA_INDEX_ALIGNMENT * ARENA_INDEX_ALIGNMENT;
+
+	this->m_vertexAllocator.Free(allocation.firstVertex, allocation.numberOfVertices);
+	this->m_indexAllocator.Free(allocation.firstIndexByte, alignedIndexBytes);
+
+	this->m_map_ID_to_Allocation.erase(itAllocation);
+
+	return;
+}
+
+bool cGeometryArena::getAllocation(unsigned int allocationID, sAllocation& allocation) const
+{
+	std::map< unsigned int, sAllocation >::const_iterator itAllocation = this->m_map_ID_to_Allocation.find(allocationID);
+
+	if (itAllocation == this->m_map_ID_to_Allocation.end())
+		return false;
+
+	allocation = itAllocation->second;
+
+	return true;
+}
+
+void cGeometryArena::Compact(void)
+{
+	if (this->m_vertexArray.getID() == 0)
+		return;
+
+	this->m_numberOfCompactions++;
+
+	this->m_Rebuild(this->m_vertexAllocator.getCapacity(), this->m_indexAllocator.getCapacity());
+
+	return;
+}
+
+bool cGeometryArena::CompactIfFragmented(float minFragmentation, std::size_t minWastedBytes)
+{
+	sGeometryArenaStats arenaStats = this->getStats();
+
+	// Free space a packed arena would add to the largest free block
+	std::size_t wastedVertexBytes = (arenaStats.vertexBytesCapacity - arenaStats.vertexBytesUsed) - arenaStats.largestFreeVertexBytes;
+	std::size_t wastedIndexBytes = (arenaStats.indexBytesCapacity - arenaStats.indexBytesUsed) - arenaStats.largestFreeIndexBytes;
+
+	bool bVerticesFragmented = arenaStats.vertexFragmentation >= minFragmentation && wastedVertexBytes >= minWastedBytes;
+	bool bIndicesFragmented = arenaStats.indexFragmentation >= minFragmentation && wastedIndexBytes >= minWastedBytes;
+
+	if (!bVerticesFragmented && !bIndicesFragmented)
+		return false;
+
+	this->Compact();
+
+	return true;
+}
+
+unsigned int cGeometryArena::getGeneration(void) const
+{
+	return this->m_generation;
+}
+
+unsigned int cGeometryArena::getVAO(void) const
+{
+	return this->m_vertexArray.getID();
+}
+
+unsigned int cGeometryArena::getVertexBufferID(void) const
+{
+	return this->m_vertexBuffer.getID();
+}
+
+unsigned int cGeometryArena::getIndexBufferID(void) const
+{
+	return this->m_indexBuffer.getID();
+}
+
+sGeometryArenaStats cGeometryArena::getStats(void) const
+{
+	sGeometryArenaStats arenaStats;
+
+	arenaStats.numberOfAllocations = (unsigned int)this->m_map_ID_to_Allocation.size();
+
+	unsigned int freeVertices = this->m_vertexAllocator.getFreeSize();
+	unsigned int freeIndexBytes = this->m_indexAllocator.getFreeSize();
+
+	arenaStats.vertexBytesCapacity = (std::size_t)this->m_vertexAllocator.getCapacity() * this->m_vertexStride;
+	arenaStats.vertexBytesUsed = arenaStats.vertexBytesCapacity - (std::size_t)freeVertices * this->m_vertexStride;
+	arenaStats.largestFreeVertexBytes = (std::size_t)this->m_vertexAllocator.getLargestFreeSize() * this->m_vertexStride;
+
+	arenaStats.indexBytesCapacity = this->m_indexAllocator.getCapacity();
+	arenaStats.indexBytesUsed = arenaStats.indexBytesCapacity - freeIndexBytes;
+	arenaStats.largestFreeIndexBytes = this->m_indexAllocator.getLargestFreeSize();
+
+	if (freeVertices != 0)
+		arenaStats.vertexFragmentation = 1.0f - (float)this->m_vertexAllocator.getLargestFreeSize() / (float)freeVertices;
+
+	if (freeIndexBytes != 0)
+		arenaStats.indexFragmentation = 1.0f - (float)this->m_indexAllocator.getLargestFreeSize() / (float)freeIndexBytes;
+
+	arenaStats.numberOfGrowths = this->m_numberOfGrowths;
+	arenaStats.numberOfCompactions = this->m_numberOfCompactions;
+
+	return arenaStats;
+}
+
+void cGeometryArena::m_Rebuild(unsigned int vertexCapacity, unsigned int indexByteCapacity)
+{
+	cGLBuffer newVertexBuffer;
+	cGLBuffer newIndexBuffer;
+
+	newVertexBuffer.Create();
+	newIndexBuffer.Create();
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer.getID());
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)vertexCapacity * this->m_vertexStride, NULL, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer.getID());
+	glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)indexByteCapacity, NULL, GL_STATIC_DRAW);
+
+	//-----------------------------Copy the allocations packed, in offset order----------------
+
+	std::vector<sAllocation*> vecAllocations;
+
+	for (std::map< unsigned int, sAllocation >::iterator itAllocation = this->m_map_ID_to_Allocation.begin();
+		itAllocation != this->m_map_ID_to_Allocation.end(); itAllocation++)
+		vecAllocations.push_back(&(itAllocation->second));
+
+	unsigned int packedVertices = 0;
+	unsigned int packedIndexBytes = 0;
+
+	if (!vecAllocations.empty())
+	{
+		std::sort(vecAllocations.begin(), vecAllocations.end(),
+			[](const sAllocation* pFirst, const sAllocation* pSecond) { return pFirst->firstVertex < pSecond->firstVertex; });
+
+		glBindBuffer(GL_COPY_READ_BUFFER, this->m_vertexBuffer.getID());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer.getID());
+
+		for (unsigned int index = 0; index != vecAllocations.size(); index++)
+		{
+			sAllocation* pAllocation = vecAllocations[index];
+
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+				(GLintptr)pAllocation->firstVertex * this->m_vertexStride,
+				(GLintptr)packedVertices * this->m_vertexStride,
+				(GLsizeiptr)pAllocation->numberOfVertices * this->m_vertexStride);
+
+			pAllocation->firstVertex = packedVertices;
+			packedVertices += pAllocation->numberOfVertices;
+		}
+
+		std::sort(vecAllocations.begin(), vecAllocations.end(),
+			[](const sAllocation* pFirst, const sAllocation* pSecond) { return pFirst->firstIndexByte < pSecond->firstIndexByte; });
+
+		glBindBuffer(GL_COPY_READ_BUFFER, this->m_indexBuffer.getID());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer.getID());
+
+		for (unsigned int index = 0; index != vecAllocations.size(); index++)
+		{
+			sAllocation* pAllocation = vecAllocations[index];
+
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+				(GLintptr)pAllocation->firstIndexByte,
+				(GLintptr)packedIndexBytes,
+				(GLsizeiptr)pAllocation->numberOfIndexBytes);
+
+			pAllocation->firstIndexByte = packedIndexBytes;
+			packedIndexBytes += (pAllocation->numberOfIndexBytes + ARENA_INDEX_ALIGNMENT - 1) / ARENA_INDEX_ALIGNMENT * ARENA_INDEX_ALIGNMENT;
+		}
+
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// The old buffers are deleted here
+	this->m_vertexBuffer = std::move(newVertexBuffer);
+	this->m_indexBuffer = std::move(newIndexBuffer);
+
+	this->m_vertexAllocator.Reset(vertexCapacity, packedVertices);
+	this->m_indexAllocator.Reset(indexByteCapacity, packedIndexBytes);
+
+	this->m_SetupVAO();
+
+	this->m_generation++;
+
+	return;
+}
+
+void cGeometryArena::m_SetupVAO(void)
+{
+	glBindVertexArray(this->m_vertexArray.getID());
+
+	glBindBuffer(GL_ARRAY_BUFFER, this->m_vertexBuffer.getID());
+
+	cVertexFormat::SetupAttributes(this->m_vertexFormat, this->m_shaderProgramID);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_indexBuffer.getID());
+
+	glBindVertexArray(0);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return;
+}
@@ -0,0 +1,152 @@
+#ifndef _cGeometryArena_HG_
+#define _cGeometryArena_HG_
+
+#include <map>
+#include <vector>
+#include <cstddef>
+
+#include "sModelDrawInfo.h"
+#include "cGLResource.h"
+
+// Totals of one arena (or several added together)
+struct sGeometryArenaStats
+{
+	sGeometryArenaStats();
+
+	unsigned int numberOfAllocations;
+
+	std::size_t vertexBytesCapacity;
+	std::size_t vertexBytesUsed;
+	std::size_t largestFreeVertexBytes;
+
+	std::size_t indexBytesCapacity;
+	std::size_t indexBytesUsed;
+	std::size_t largestFreeIndexBytes;
+
+	// 1 - largest free block / all the free space (0 is one free block, near 1 is many small holes)
+	float vertexFragmentation;
+	float indexFragmentation;
+
+	unsigned int numberOfGrowths;
+	unsigned int numberOfCompactions;
+};
+
+// Static meshes of one vertex format sub-allocated from one big vertex buffer and
+//	one big index buffer, behind a single VAO. A mesh is drawn with
+//	glDrawElementsBaseVertex from its firstVertex / firstIndexByte, so drawing
+//	many meshes doesn't need any VAO or buffer rebinds.
+// 16 and 32 bit indices share the index buffer (every range starts 4 byte aligned).
+// When a mesh doesn't fit, the buffers are copied into bigger ones with the meshes
+//	packed together (the same copy, without growing, is the compaction).
+// Main thread only (GL calls).
+class cGeometryArena
+{
+public:
+
+	static const unsigned int INVALID_ALLOCATION = 0;
+
+	static const unsigned int DEFAULT_VERTEX_CAPACITY = 64 * 1024;		// Vertices
+	static const unsigned int DEFAULT_INDEX_CAPACITY = 1024 * 1024;		// Bytes
+
+	struct sAllocation
+	{
+		unsigned int firstVertex;
+		unsigned int numberOfVertices;
+		unsigned int firstIndexByte;
+		unsigned int numberOfIndexBytes;
+	};
+
+	cGeometryArena();
+
+	// Copies the data into the buffers (created on first use) and returns the
+	//	allocation's ID, or INVALID_ALLOCATION. Any allocation's offsets can change
+	//	here (growth / compaction), see getGeneration.
+	unsigned int Allocate(eVertexFormat vertexFormat, unsigned int shaderProgramID,
+		const void* pVertexData, unsigned int numberOfVertices,
+		const void* pIndexData, unsigned int numberOfIndexBytes);
+
+	// The space is reused by later allocations (neighbouring free ranges are merged)
+	void Free(unsigned int allocationID);
+
+	bool getAllocation(unsigned int allocationID, sAllocation& allocation) const;
+
+	// Packs every allocation to the start of the buffers
+	void Compact(void);
+
+	// Compacts if the free space is at least minFragmentation fragmented and at least
+	//	minWastedBytes of it are outside the largest free block (so one small hole isn't
+	//	worth copying the whole arena for)
+	bool CompactIfFragmented(float minFragmentation, std::size_t minWastedBytes);
+
+	// Changes whenever allocations move
+	unsigned int getGeneration(void) const;
+
+	unsigned int getVAO(void) const;
+	unsigned int getVertexBufferID(void) const;
+	unsigned int getIndexBufferID(void) const;
+
+	sGeometryArenaStats getStats(void) const;
+
+private:
+
+	cGeometryArena(const cGeometryArena&);
+	cGeometryArena& operator=(const cGeometryArena&);
+
+	// First fit allocator of [offset, offset + size) ranges, sorted free list
+	class cRangeAllocator
+	{
+	public:
+
+		cRangeAllocator();
+
+		// Everything free except [0, usedSize)
+		void Reset(unsigned int capacity, unsigned int usedSize);
+
+		bool Allocate(unsigned int size, unsigned int& offset);
+
+		void Free(unsigned int offset, unsigned int size);
+
+		unsigned int getCapacity(void) const;
+		unsigned int getFreeSize(void) const;
+		unsigned int getLargestFreeSize(void) const;
+
+	private:
+
+		struct sRange
+		{
+			unsigned int offset;
+			unsigned int size;
+		};
+
+		std::vector<sRange> m_vecFreeRanges;
+
+		unsigned int m_capacity;
+	};
+
+	// New buffers of the given capacity holding every allocation packed together
+	void m_Rebuild(unsigned int vertexCapacity, unsigned int indexByteCapacity);
+
+	// Binds the buffers to the VAO and sets up its attributes
+	void m_SetupVAO(void);
+
+	eVertexFormat m_vertexFormat;
+	unsigned int m_vertexStride;
+	unsigned int m_shaderProgramID;
+
+	cGLVertexArray m_vertexArray;
+	cGLBuffer m_vertexBuffer;
+	cGLBuffer m_indexBuffer;
+
+	cRangeAllocator m_vertexAllocator;		// In vertices
+	cRangeAllocator m_indexAllocator;		// In bytes
+
+	std::map< unsigned int, sAllocation > m_map_ID_to_Allocation;
+
+	unsigned int m_nextAllocationID;
+	unsigned int m_generation;
+
+	unsigned int m_numberOfGrowths;
+	unsigned int m_numberOfCompactions;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef _cHandleTable_HG_
+#define _cHandleTable_HG_
+
+#include <cstddef>
+#include <vector>
+
+// Objects kept in slots and addressed by handles : the slot in the low bits, the slot's
+//	generation in the high bits. Removing an object bumps its slot's generation, so an old
+//	handle stops working instead of pointing at whatever is put in the slot next.
+// Handles don't change when other objects are added or removed. Lookups are an index and
+//	a compare.
+template <class T>
+class cHandleTable
+{
+public:
+
+	static const unsigned int INVALID_HANDLE = ~0u;
+
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+	// The last index is never used, so no handle is INVALID_HANDLE
+	static const unsigned int MAX_OBJECTS = INDEX_MASK;
+
+	cHandleTable()
+	{
+		this->m_numberOfObjects = 0;
+	}
+
+	// INVALID_HANDLE if the table is full
+	unsigned int Add(const T& newObject)
+	{
+		unsigned int slot;
+
+		if (!this->m_vecFreeSlots.empty())
+		{
+			slot = this->m_vecFreeSlots.back();
+			this->m_vecFreeSlots.pop_back();
+		}
+		else
+		{
+			if (this->m_vecObjects.size() == MAX_OBJECTS)
+				return INVALID_HANDLE;
+
+			slot = (unsigned int)this->m_vecObjects.size();
+
+			this->m_vecObjects.push_back(T());
+			this->m_vecGenerations.push_back(0);
+			this->m_vecInUse.push_back(false);
+		}
+
+		this->m_vecObjects[slot] = newObject;
+		this->m_vecInUse[slot] = true;
+		this->m_numberOfObjects++;
+
+		return this->getHandle(slot);
+	}
+
+	// False if the handle is stale (already removed) or was never handed out
+	bool Remove(unsigned int handle)
+	{
+		if (this->Get(handle) == NULL)
+			return false;
+
+		unsigned int slot = handle & INDEX_MASK;
+
+		this->m_vecObjects[slot] = T();
+		this->m_vecInUse[slot] = false;
+		this->m_vecGenerations[slot] = (this->m_vecGenerations[slot] + 1) & GENERATION_MASK;
+		this->m_vecFreeSlots.push_back(slot);
+		this->m_numberOfObjects--;
+
+		return true;
+	}
+
+	// NULL for a stale or invalid handle. Stays valid until the next Add.
+	T* Get(unsigned int handle)
+	{
+		unsigned int slot = handle & INDEX_MASK;
+
+		if (slot >= this->m_vecObjects.size() || !this->m_vecInUse[slot] || this->m_vecGenerations[slot] != (handle >> INDEX_BITS))
+			return NULL;
+
+		return &this->m_vecObjects[slot];
+	}
+
+	const T* Get(unsigned int handle) const
+	{
+		return const_cast<cHandleTable*>(this)->Get(handle);
+	}
+
+	unsigned int getNumberOfObjects(void) const
+	{
+		return this->m_numberOfObjects;
+	}
+
+	//-------------------Walking every object-----------------
+
+	// Slots in use and free ones in between
+	unsigned int getNumberOfSlots(void) const
+	{
+		return (unsigned int)this->m_vecObjects.size();
+	}
+
+	bool isSlotInUse(unsigned int slot) const
+	{
+		return this->m_vecInUse[slot];
+	}
+
+	T& getSlot(unsigned int slot)
+	{
+		return this->m_vecObjects[slot];
+	}
+
+	const T& getSlot(unsigned int slot) const
+	{
+		return this->m_vecObjects[slot];
+	}
+
+	// Of the object in the slot now
+	unsigned int getHandle(unsigned int slot) const
+	{
+		return slot | (this->m_vecGenerations[slot] << INDEX_BITS);
+	}
+
+	static unsigned int getSlotOfHandle(unsigned int handle)
+	{
+		return handle & INDEX_MASK;
+	}
+
+private:
+
+	std::vector< T > m_vecObjects;
+	std::vector< unsigned int > m_vecGenerations;
+	std::vector< bool > m_vecInUse;
+	std::vector< unsigned int > m_vecFreeSlots;
+	unsigned int m_numberOfObjects;
+};
+
+#endif
@@ -0,0 +1,417 @@
+#include "cLightClusterGrid.h"
+#include "cLightHelper.h"
+
+#include "OpenGLCommon.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+cLightClusterGrid::cLightClusterGrid()
+{
+	this->m_fieldOfView = 0.0f;
+	this->m_viewportWidth = 0;
+	this->m_viewportHeight = 0;
+	this->m_nearPlane = 0.0f;
+	this->m_farPlane = 0.0f;
+	this->m_tanHalfFovY = 0.0f;
+	this->m_aspectRatio = 1.0f;
+	this->m_bBoundsValid = false;
+
+	this->m_lightIndexCapacity = 0;
+
+	this->m_vecClusterTable.resize(NUMBER_OF_CLUSTERS * 2, 0);
+}
+
+void cLightClusterGrid::setProjection(float fieldOfView, int viewportWidth, int viewportHeight, float nearPlane, float farPlane)
+{
+	// Minimised window
+	if (viewportWidth <= 0 || viewportHeight <= 0)
+		return;
+
+	if (this->m_bBoundsValid && fieldOfView == this->m_fieldOfView && nearPlane == this->m_nearPlane && farPlane == this->m_farPlane &&
+		viewportWidth == this->m_viewportWidth && viewportHeight == this->m_viewportHeight)
+		return;
+
+	this->m_fieldOfView = fieldOfView;
+	this->m_viewportWidth = viewportWidth;
+	this->m_viewportHeight = viewportHeight;
+	this->m_nearPlane = nearPlane;
+	this->m_farPlane = farPlane;
+
+	this->m_tanHalfFovY = tanf(fieldOfView * 0.5f);
+	this->m_aspectRatio = viewportWidth / (float)viewportHeight;
+
+	this->m_BuildClusterBounds();
+
+	this->m_bBoundsValid = true;
+
+	return;
+}
+
+void cLightClusterGrid::Build(const glm::mat4& matView, const sLightBlockEntry* pLights, unsigned int numberOfLights, cThreadPool* pThreadPool)
+{
+	std::chrono::steady_clock::time_point buildStart = std::chrono::steady_clock::now();
+
+	this->m_lastStats = sLightClusterStats();
+	this->m_lastStats.numberOfLights = numberOfLights;
+	this->m_lastStats.numberOfThreads = (pThreadPool != NULL) ? pThreadPool->getNumberOfThreads() : 1;
+
+	// No cluster bounds until setProjection gets a real viewport (e.g. the window started
+	//	minimised). Every cluster is left empty; nothing is drawn at that size anyway.
+	if (!this->m_bBoundsValid)
+	{
+		std::fill(this->m_vecClusterTable.begin(), this->m_vecClusterTable.end(), 0u);
+		this->m_vecLightIndices.clear();
+
+		this->m_lastStats.buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+		return;
+	}
+
+	this->m_vecLights.resize(numberOfLights);
+
+	//------------------------Lights into view space, radius and cluster range------------------------
+
+	if (pThreadPool != NULL && numberOfLights > 0)
+	{
+		unsigned int lightsPerTask = (numberOfLights + this->m_lastStats.numberOfThreads - 1) / this->m_lastStats.numberOfThreads;
+
+		for (unsigned int firstLight = 0; firstLight < numberOfLights; firstLight += lightsPerTask)
+		{
+			unsigned int lastLight = std::min(firstLight + lightsPerTask, numberOfLights);
+
+			pThreadPool->AddTask([this, &matView, pLights, firstLight, lastLight]()
+				{
+					this->m_PrepareLights(matView, pLights, firstLight, lastLight);
+				});
+		}
+
+		pThreadPool->WaitForAllTasks();
+	}
+	else
+		this->m_PrepareLights(matView, pLights, 0, numberOfLights);
+
+	//------------------------Bin each depth slice------------------------------------------------
+
+	if (pThreadPool != NULL)
+	{
+		for (unsigned int slice = 0; slice != CLUSTERS_Z; slice++)
+			pThreadPool->AddTask([this, slice]()
+				{
+					this->m_BinSlice(slice);
+				});
+
+		pThreadPool->WaitForAllTasks();
+	}
+	else
+	{
+		for (unsigned int slice = 0; slice != CLUSTERS_Z; slice++)
+			this->m_BinSlice(slice);
+	}
+
+	//------------------------Merge into one table------------------------------------------------
+
+	unsigned int numberOfIndices = 0;
+
+	for (unsigned int slice = 0; slice != CLUSTERS_Z; slice++)
+		numberOfIndices += (unsigned int)this->m_sliceLists[slice].vecLightIndices.size();
+
+	this->m_vecLightIndices.resize(numberOfIndices);
+
+	unsigned int clusterOffset = 0;
+
+	for (unsigned int slice = 0; slice != CLUSTERS_Z; slice++)
+	{
+		const sSliceLists& sliceLists = this->m_sliceLists[slice];
+
+		unsigned int clusterCursor[CLUSTERS_X * CLUSTERS_Y];
+
+		for (unsigned int tile = 0; tile != CLUSTERS_X * CLUSTERS_Y; tile++)
+		{
+			unsigned int clusterIndex = slice * CLUSTERS_X * CLUSTERS_Y + tile;
+
+			this->m_vecClusterTable[clusterIndex * 2 + 0] = clusterOffset;
+			this->m_vecClusterTable[clusterIndex * 2 + 1] = sliceLists.clusterCounts[tile];
+
+			clusterCursor[tile] = clusterOffset;
+			clusterOffset += sliceLists.clusterCounts[tile];
+
+			this->m_lastStats.maxLightsInACluster = std::max(this->m_lastStats.maxLightsInACluster, sliceLists.clusterCounts[tile]);
+		}
+
+		// Entries are in light order, so each cluster's lights stay in light buffer order
+		for (unsigned int entry = 0; entry != sliceLists.vecLightIndices.size(); entry++)
+			this->m_vecLightIndices[clusterCursor[sliceLists.vecClusterOfEntry[entry]]++] = sliceLists.vecLightIndices[entry];
+	}
+
+	this->m_lastStats.numberOfLightIndices = numberOfIndices;
+
+	this->m_lastStats.buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count();
+
+	return;
+}
+
+void cLightClusterGrid::UploadAndBind(void)
+{
+	if (this->m_clusterTableBuffer.getID() == 0)
+		this->m_clusterTableBuffer.Create();
+
+	GLsizeiptr tableBytes = (GLsizeiptr)this->m_vecClusterTable.size() * sizeof(unsigned int);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->m_clusterTableBuffer.getID());
+	glBufferData(GL_SHADER_STORAGE_BUFFER, tableBytes, this->m_vecClusterTable.data(), GL_STREAM_DRAW);
+
+	//----------------------------Light indices (grows)-------------------------------------
+
+	unsigned int numberOfIndices = (unsigned int)this->m_vecLightIndices.size();
+
+	if (this->m_lightIndexBuffer.getID() == 0)
+		this->m_lightIndexBuffer.Create();
+
+	if (numberOfIndices > this->m_lightIndexCapacity || this->m_lightIndexCapacity == 0)
+	{
+		if (this->m_lightIndexCapacity == 0)
+			this->m_lightIndexCapacity = 1024;
+
+		while (this->m_lightIndexCapacity < numberOfIndices)
+			this->m_lightIndexCapacity *= 2;
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->m_lightIndexBuffer.getID());
+
+	// Orphaned, last frame's draws keep their copy
+	glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)this->m_lightIndexCapacity * sizeof(unsigned int), NULL, GL_STREAM_DRAW);
+
+	if (numberOfIndices > 0)
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)numberOfIndices * sizeof(unsigned int), this->m_vecLightIndices.data());
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTERS, this->m_clusterTableBuffer.getID());
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_LIGHTS, this->m_lightIndexBuffer.getID());
+
+	this->m_lastStats.bytesUploaded = (unsigned int)tableBytes + numberOfIndices * sizeof(unsigned int);
+
+	return;
+}
+
+void cLightClusterGrid::FillPerFrameBlock(sPerFrameBlock& perFrameBlock) const
+{
+	// No projection yet (near plane 0). Every fragment lands in cluster 0, which is empty.
+	if (!this->m_bBoundsValid)
+	{
+		perFrameBlock.clusterDepthParams = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		perFrameBlock.clusterTileSize = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+		perFrameBlock.clusterCounts = glm::ivec4(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z, 0);
+
+		return;
+	}
+
+	float logDepthRange = logf(this->m_farPlane / this->m_nearPlane);
+
+	perFrameBlock.clusterDepthParams = glm::vec4(this->m_nearPlane, CLUSTERS_Z / logDepthRange, 0.0f, 0.0f);
+
+	perFrameBlock.clusterTileSize = glm::vec4(this->m_viewportWidth / (float)CLUSTERS_X, this->m_viewportHeight / (float)CLUSTERS_Y, 0.0f, 0.0f);
+
+	perFrameBlock.clusterCounts = glm::ivec4(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z, 0);
+
+	return;
+}
+
+sLightClusterStats cLightClusterGrid::getLastStats(void) const
+{
+	return this->m_lastStats;
+}
+
+void cLightClusterGrid::m_BuildClusterBounds(void)
+{
+	this->m_vecClusterMin.resize(NUMBER_OF_CLUSTERS);
+	this->m_vecClusterMax.resize(NUMBER_OF_CLUSTERS);
+
+	float depthRatio = this->m_farPlane / this->m_nearPlane;
+
+	for (unsigned int slice = 0; slice != CLUSTERS_Z; slice++)
+	{
+		float sliceNear = this->m_nearPlane * powf(depthRatio, slice / (float)CLUSTERS_Z);
+		float sliceFar = this->m_nearPlane * powf(depthRatio, (slice + 1) / (float)CLUSTERS_Z);
+
+		for (unsigned int tileY = 0; tileY != CLUSTERS_Y; tileY++)
+		{
+			// NDC, -1 at the bottom (gl_FragCoord's origin)
+			float ndcMinY = -1.0f + 2.0f * tileY / CLUSTERS_Y;
+			float ndcMaxY = -1.0f + 2.0f * (tileY + 1) / CLUSTERS_Y;
+
+			for (unsigned int tileX = 0; tileX != CLUSTERS_X; tileX++)
+			{
+				float ndcMinX = -1.0f + 2.0f * tileX / CLUSTERS_X;
+				float ndcMaxX = -1.0f + 2.0f * (tileX + 1) / CLUSTERS_X;
+
+				float scaleX = this->m_tanHalfFovY * this->m_aspectRatio;
+				float scaleY = this->m_tanHalfFovY;
+
+				// The tile's edges spread out with depth, so the box spans both ends of the slice
+				glm::vec3 clusterMin, clusterMax;
+
+				clusterMin.x = std::min(ndcMinX * sliceNear, ndcMinX * sliceFar) * scaleX;
+				clusterMax.x = std::max(ndcMaxX * sliceNear, ndcMaxX * sliceFar) * scaleX;
+				clusterMin.y = std::min(ndcMinY * sliceNear, ndcMinY * sliceFar) * scaleY;
+				clusterMax.y = std::max(ndcMaxY * sliceNear, ndcMaxY * sliceFar) * scaleY;
+				clusterMin.z = -sliceFar;
+				clusterMax.z = -sliceNear;
+
+				unsigned int clusterIndex = tileX + CLUSTERS_X * (tileY + CLUSTERS_Y * slice);
+
+				this->m_vecClusterMin[clusterIndex] = clusterMin;
+				this->m_vecClusterMax[clusterIndex] = clusterMax;
+			}
+		}
+	}
+
+	return;
+}
+
+void cLightClusterGrid::m_PrepareLights(const glm::mat4& matView, const sLightBlockEntry* pLights, unsigned int firstLight, unsigned int lastLight)
+{
+	for (unsigned int index = firstLight; index != lastLight; index++)
+	{
+		const sLightBlockEntry& theLight = pLights[index];
+		sClusterLight& clusterLight = this->m_vecLights[index];
+
+		clusterLight.bCulled = false;
+		clusterLight.bEverywhere = false;
+
+		clusterLight.tileMinX = 0;
+		clusterLight.tileMaxX = CLUSTERS_X - 1;
+		clusterLight.tileMinY = 0;
+		clusterLight.tileMaxY = CLUSTERS_Y - 1;
+		clusterLight.sliceMin = 0;
+		clusterLight.sliceMax = CLUSTERS_Z - 1;
+
+		clusterLight.viewCentre = glm::vec3(0.0f);
+		clusterLight.radius = 0.0f;
+
+		// 2 = directional light, no position
+		if ((int)theLight.param1.x == 2)
+		{
+			clusterLight.bEverywhere = true;
+			continue;
+		}
+
+		clusterLight.viewCentre = glm::vec3(matView * glm::vec4(glm::vec3(theLight.position), 1.0f));
+
+		// Solved by cLightManager when the attenuation last changed
+		clusterLight.radius = theLight.atten.w;
+
+		if (clusterLight.radius >= cLightHelper::DEFAULTINFINITEDISTANCE)
+		{
+			clusterLight.bEverywhere = true;
+			continue;
+		}
+
+		//------------------------Depth slices------------------------------------
+
+		float nearestDepth = -clusterLight.viewCentre.z - clusterLight.radius;
+		float furthestDepth = -clusterLight.viewCentre.z + clusterLight.radius;
+
+		if (furthestDepth < this->m_nearPlane || nearestDepth > this->m_farPlane)
+		{
+			clusterLight.bCulled = true;
+			continue;
+		}
+
+		clusterLight.sliceMin = this->m_SliceOfDepth(nearestDepth);
+		clusterLight.sliceMax = this->m_SliceOfDepth(furthestDepth);
+
+		// Reaches behind the near plane, the projection below doesn't hold
+		if (nearestDepth <= this->m_nearPlane)
+			continue;
+
+		//------------------------Screen tiles------------------------------------
+
+		// Projected corners of the sphere's box, the sphere's projection is inside them
+		float ndcMinX = 1.0f, ndcMaxX = -1.0f, ndcMinY = 1.0f, ndcMaxY = -1.0f;
+
+		const float cornerDepths[2] = { nearestDepth, furthestDepth };
+
+		for (unsigned int depthIndex = 0; depthIndex != 2; depthIndex++)
+		{
+			float scaleX = 1.0f / (cornerDepths[depthIndex] * this->m_tanHalfFovY * this->m_aspectRatio);
+			float scaleY = 1.0f / (cornerDepths[depthIndex] * this->m_tanHalfFovY);
+
+			ndcMinX = std::min(ndcMinX, (clusterLight.viewCentre.x - clusterLight.radius) * scaleX);
+			ndcMaxX = std::max(ndcMaxX, (clusterLight.viewCentre.x + clusterLight.radius) * scaleX);
+			ndcMinY = std::min(ndcMinY, (clusterLight.viewCentre.y - clusterLight.radius) * scaleY);
+			ndcMaxY = std::max(ndcMaxY, (clusterLight.viewCentre.y + clusterLight.radius) * scaleY);
+		}
+
+		if (ndcMaxX < -1.0f || ndcMinX > 1.0f || ndcMaxY < -1.0f || ndcMinY > 1.0f)
+		{
+			clusterLight.bCulled = true;
+			continue;
+		}
+
+		clusterLight.tileMinX = (unsigned int)std::max(0.0f, floorf((ndcMinX + 1.0f) * 0.5f * CLUSTERS_X));
+		clusterLight.tileMaxX = std::min(CLUSTERS_X - 1, (unsigned int)std::max(0.0f, floorf((ndcMaxX + 1.0f) * 0.5f * CLUSTERS_X)));
+		clusterLight.tileMinY = (unsigned int)std::max(0.0f, floorf((ndcMinY + 1.0f) * 0.5f * CLUSTERS_Y));
+		clusterLight.tileMaxY = std::min(CLUSTERS_Y - 1, (unsigned int)std::max(0.0f, floorf((ndcMaxY + 1.0f) * 0.5f * CLUSTERS_Y)));
+	}
+
+	return;
+}
+
+void cLightClusterGrid::m_BinSlice(unsigned int slice)
+{
+	sSliceLists& sliceLists = this->m_sliceLists[slice];
+
+	memset(sliceLists.clusterCounts, 0, sizeof(sliceLists.clusterCounts));
+	sliceLists.vecClusterOfEntry.clear();
+	sliceLists.vecLightIndices.clear();
+
+	for (unsigned int lightIndex = 0; lightIndex != this->m_vecLights.size(); lightIndex++)
+	{
+		const sClusterLight& clusterLight = this->m_vecLights[lightIndex];
+
+		if (clusterLight.bCulled || slice < clusterLight.sliceMin || slice > clusterLight.sliceMax)
+			continue;
+
+		float radiusSquared = clusterLight.radius * clusterLight.radius;
+
+		for (unsigned int tileY = clusterLight.tileMinY; tileY <= clusterLight.tileMaxY; tileY++)
+		{
+			for (unsigned int tileX = clusterLight.tileMinX; tileX <= clusterLight.tileMaxX; tileX++)
+			{
+				unsigned int tile = tileX + CLUSTERS_X * tileY;
+
+				if (!clusterLight.bEverywhere)
+				{
+					// Sphere against the cluster's box
+					unsigned int clusterIndex = tile + CLUSTERS_X * CLUSTERS_Y * slice;
+
+					glm::vec3 closestPoint = glm::clamp(clusterLight.viewCentre, this->m_vecClusterMin[clusterIndex], this->m_vecClusterMax[clusterIndex]);
+					glm::vec3 toCentre = clusterLight.viewCentre - closestPoint;
+
+					if (glm::dot(toCentre, toCentre) > radiusSquared)
+						continue;
+				}
+
+				sliceLists.vecClusterOfEntry.push_back(tile);
+				sliceLists.vecLightIndices.push_back(lightIndex);
+				sliceLists.clusterCounts[tile]++;
+			}
+		}
+	}
+
+	return;
+}
+
+unsigned int cLightClusterGrid::m_SliceOfDepth(float viewDepth) const
+{
+	if (viewDepth <= this->m_nearPlane)
+		return 0;
+
+	float slice = logf(viewDepth / this->m_nearPlane) / logf(this->m_farPlane / this->m_nearPlane) * CLUSTERS_Z;
+
+	return std::min(CLUSTERS_Z - 1, (unsigned int)slice);
+}
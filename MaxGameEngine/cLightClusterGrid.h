@@ -0,0 +1,117 @@
+#ifndef _cLightClusterGrid_HG_
+#define _cLightClusterGrid_HG_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "cGLResource.h"
+#include "cThreadPool.h"
+#include "sShaderBlocks.h"
+
+// What the last Build / UploadAndBind did
+struct sLightClusterStats
+{
+	unsigned int numberOfLights = 0;
+	unsigned int numberOfLightIndices = 0;		// Sum over the clusters of their light counts
+	unsigned int maxLightsInACluster = 0;
+	unsigned int numberOfThreads = 0;			// 1 = built on the main thread
+
+	double buildTime = 0.0;						// Seconds, wall clock
+	unsigned int bytesUploaded = 0;
+};
+
+// Clustered forward lighting. The view frustum is cut into CLUSTERS_X * CLUSTERS_Y screen
+//	tiles and CLUSTERS_Z depth slices (exponentially thicker with distance), and each frame
+//	every light is binned into the clusters its sphere of influence touches. The fragment
+//	shader finds its cluster from gl_FragCoord and its view depth and only walks that
+//	cluster's lights.
+// The light indices are into the packed light buffer (cLightManager::getActiveLights).
+class cLightClusterGrid
+{
+public:
+
+	static const unsigned int CLUSTERS_X = 16;
+	static const unsigned int CLUSTERS_Y = 9;
+	static const unsigned int CLUSTERS_Z = 24;
+	static const unsigned int NUMBER_OF_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+	cLightClusterGrid();
+
+	// The projection the grid is cut from. The cluster bounds are only rebuilt when it changes.
+	void setProjection(float fieldOfView, int viewportWidth, int viewportHeight, float nearPlane, float farPlane);
+
+	// Bins the lights for this view, atten.w being each light's radius (cLight::radius). The binning is split across pThreadPool's workers
+	//	(NULL = all on this thread); no GL calls, the upload is UploadAndBind.
+	//	Before setProjection has had a non-zero viewport every cluster is empty.
+	void Build(const glm::mat4& matView, const sLightBlockEntry* pLights, unsigned int numberOfLights, cThreadPool* pThreadPool);
+
+	// Uploads the cluster table and light index list and binds them to
+	//	STORAGE_BINDING_CLUSTERS / STORAGE_BINDING_CLUSTER_LIGHTS
+	void UploadAndBind(void);
+
+	// The cluster values of the per frame block
+	void FillPerFrameBlock(sPerFrameBlock& perFrameBlock) const;
+
+	sLightClusterStats getLastStats(void) const;
+
+private:
+
+	// A light as the binning sees it, in view space
+	struct sClusterLight
+	{
+		glm::vec3 viewCentre;
+		float radius;
+
+		bool bEverywhere;				// Directional (or too big to bother)
+		bool bCulled;					// Can't reach the frustum
+
+		unsigned int tileMinX, tileMaxX;
+		unsigned int tileMinY, tileMaxY;
+		unsigned int sliceMin, sliceMax;
+	};
+
+	// Per depth slice output, merged into the cluster table after every slice is done
+	struct sSliceLists
+	{
+		unsigned int clusterCounts[CLUSTERS_X * CLUSTERS_Y];
+		std::vector<unsigned int> vecClusterOfEntry;
+		std::vector<unsigned int> vecLightIndices;
+	};
+
+	void m_BuildClusterBounds(void);
+
+	void m_PrepareLights(const glm::mat4& matView, const sLightBlockEntry* pLights, unsigned int firstLight, unsigned int lastLight);
+
+	void m_BinSlice(unsigned int slice);
+
+	unsigned int m_SliceOfDepth(float viewDepth) const;
+
+	// Projection
+	float m_fieldOfView;
+	int m_viewportWidth;
+	int m_viewportHeight;
+	float m_nearPlane;
+	float m_farPlane;
+	float m_tanHalfFovY;
+	float m_aspectRatio;
+	bool m_bBoundsValid;
+
+	// View space AABB of every cluster (x fastest, then y, then slice)
+	std::vector<glm::vec3> m_vecClusterMin;
+	std::vector<glm::vec3> m_vecClusterMax;
+
+	std::vector<sClusterLight> m_vecLights;
+	sSliceLists m_sliceLists[CLUSTERS_Z];
+
+	// What goes to the GPU: (offset, count) per cluster, then the indices
+	std::vector<unsigned int> m_vecClusterTable;
+	std::vector<unsigned int> m_vecLightIndices;
+
+	cGLBuffer m_clusterTableBuffer;
+	cGLBuffer m_lightIndexBuffer;
+	unsigned int m_lightIndexCapacity;
+
+	sLightClusterStats m_lastStats;
+};
+
+#endif
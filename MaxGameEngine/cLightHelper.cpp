@@ -1,5 +1,8 @@
 #include "cLightHelper.h"
 
+#include <cmath>
+
+#include "SSECommon.h"
 
 //static 
 const float cLightHelper::DEFAULT_ATTEN_CONST = 0.1f;
@@ -27,10 +30,11 @@ float cLightHelper::calcApproxDistFromAtten(float targetLightLevel)	// Uses the
 float cLightHelper::calcApproxDistFromAtten(float targetLightLevel, float accuracy)	// Uses the defaults
 {
 	return this->calcApproxDistFromAtten(targetLightLevel, accuracy,
+		cLightHelper::DEFAULTINFINITEDISTANCE,
 		cLightHelper::DEFAULT_ATTEN_CONST,
 		cLightHelper::DEFAULT_ATTEN_LINEAR,
 		cLightHelper::DEFAULT_ATTEN_QUADRATIC,
-		cLightHelper::DEFAULTINFINITEDISTANCE, cLightHelper::DEFAULTMAXITERATIONS);
+		cLightHelper::DEFAULTMAXITERATIONS);
 }
 
 float cLightHelper::calcApproxDistFromAtten(float targetLightLevel, float accuracy,
@@ -96,7 +100,7 @@ float cLightHelper::calcApproxDistFromAtten(float targetLightLevel, float accura
 	}// while ( iterationCount < maxIterations )
 	// If we are here, then we ran out of iterations.
 	// Pick a distance between the low and high
-	float distance = (distanceGuessHigh - distanceGuessLow) / 2.0f;
+	float distance = ((distanceGuessHigh - distanceGuessLow) / 2.0f) + distanceGuessLow;
 
 	return distance;
 }
@@ -131,4 +135,76 @@ float cLightHelper::calcDiffuseFromAttenByDistance(
 		}
 	}//if ( denominator <= zeroThreshold )
 	return diffuse;
-}
\ No newline at end of file
+}
+
+//static
+const float cLightHelper::LIGHT_RADIUS_LEVEL = 0.01f;
+
+//static
+float cLightHelper::calcDistFromAtten(float targetLightLevel,
+	float constAttenuation, float linearAttenuation, float quadraticAttenuation,
+	float infiniteDistance /*= DEFAULTINFINITEDISTANCE*/)
+{
+	// What's left once the constant part is taken out
+	float remainder = (1.0f / targetLightLevel) - constAttenuation;
+
+	if (remainder <= 0.0f)
+		return 0.0f;
+
+	// The quadratic's positive root, written so it doesn't cancel (and still works
+	//	when quadratic or linear is 0)
+	float denominator = linearAttenuation + sqrtf(linearAttenuation * linearAttenuation + 4.0f * quadraticAttenuation * remainder);
+
+	float distance = (2.0f * remainder) / denominator;
+
+	// Never gets there (no linear or quadratic part), or garbage in
+	if (!(distance < infiniteDistance))
+		return infiniteDistance;
+
+	return (distance > 0.0f) ? distance : 0.0f;
+}
+
+//static
+void cLightHelper::calcDistsFromAtten(float targetLightLevel,
+	const float* pConstAttenuations, const float* pLinearAttenuations, const float* pQuadraticAttenuations,
+	unsigned int numberOfLights, float* pDistances,
+	float infiniteDistance /*= DEFAULTINFINITEDISTANCE*/)
+{
+	unsigned int lightIndex = 0;
+
+#if ENGINE_USE_SSE
+	const __m128 inverseLevel = _mm_set1_ps(1.0f / targetLightLevel);
+	const __m128 infinite = _mm_set1_ps(infiniteDistance);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 four = _mm_set1_ps(4.0f);
+
+	for (; lightIndex + 4 <= numberOfLights; lightIndex += 4)
+	{
+		__m128 constAtten = _mm_loadu_ps(pConstAttenuations + lightIndex);
+		__m128 linearAtten = _mm_loadu_ps(pLinearAttenuations + lightIndex);
+		__m128 quadraticAtten = _mm_loadu_ps(pQuadraticAttenuations + lightIndex);
+
+		__m128 remainder = _mm_sub_ps(inverseLevel, constAtten);
+
+		__m128 root = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(linearAtten, linearAtten), _mm_mul_ps(four, _mm_mul_ps(quadraticAtten, remainder))));
+
+		__m128 distance = _mm_div_ps(_mm_mul_ps(two, remainder), _mm_add_ps(linearAtten, root));
+
+		// min returns its second operand for NaN, so 0/0 and friends end up infinite too
+		distance = _mm_min_ps(distance, infinite);
+		distance = _mm_max_ps(distance, zero);
+
+		// Dimmer than the level from the start
+		distance = _mm_and_ps(distance, _mm_cmpgt_ps(remainder, zero));
+
+		_mm_storeu_ps(pDistances + lightIndex, distance);
+	}
+#endif
+
+	for (; lightIndex < numberOfLights; lightIndex++)
+		pDistances[lightIndex] = calcDistFromAtten(targetLightLevel, pConstAttenuations[lightIndex],
+			pLinearAttenuations[lightIndex], pQuadraticAttenuations[lightIndex], infiniteDistance);
+
+	return;
+}
@@ -42,6 +42,23 @@ public:
 		float linearAttenuation,
 		float quadraticAttenuation,
 		float zeroThreshold = DEFAULTZEROTHRESHOLD);
+
+	// Light level a light's radius (cLight::radius) is measured to, 1%
+	static const float LIGHT_RADIUS_LEVEL;
+
+	// Same as calcApproxDistFromAtten but exact and without iterating : solves
+	//	const + linear * d + quadratic * d^2 = 1 / targetLightLevel for d.
+	//	0 if the light is dimmer than that from the start, infiniteDistance if it never gets there.
+	//	The attenuation values are expected to be >= 0.
+	static float calcDistFromAtten(float targetLightLevel,
+		float constAttenuation, float linearAttenuation, float quadraticAttenuation,
+		float infiniteDistance = DEFAULTINFINITEDISTANCE);
+
+	// calcDistFromAtten for numberOfLights lights at once (4 at a time with SSE)
+	static void calcDistsFromAtten(float targetLightLevel,
+		const float* pConstAttenuations, const float* pLinearAttenuations, const float* pQuadraticAttenuations,
+		unsigned int numberOfLights, float* pDistances,
+		float infiniteDistance = DEFAULTINFINITEDISTANCE);
 };
 
 #endif // cLightHelper
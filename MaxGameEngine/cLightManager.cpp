@@ -1,5 +1,7 @@
 #include "cLightManager.h"
+#include "cLightHelper.h"
 #include <sstream>
+#include <cstring>
 
 cLight::cLight()
 {
@@ -7,7 +9,7 @@ cLight::cLight()
 	this->diffuse = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 	this->specular = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 
-	// x = constant, y = linear, z = quadratic, w = DistanceCutOff
+	// x = constant, y = linear, z = quadratic, w = not used
 	this->atten = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
 	// Spot, directional lights
 	// (Default is stright down)
@@ -21,15 +23,9 @@ cLight::cLight()
 // x = 0 for off, 1 for on
 	this->param2 = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
-
-	this->position_UL = -1;
-	this->diffuse_UL = -1;
-	this->specular_UL = -1;
-	this->atten_UL = -1;
-	this->direction_UL = -1;
-	this->param1_UL = -1;
-	this->param2_UL = -1;
-
+	// Not solved yet (attenuation is never negative)
+	this->radius = 0.0f;
+	this->radiusAtten = glm::vec3(-1.0f);
 }
 
 void cLight::TurnOn(void)
@@ -46,104 +42,241 @@ void cLight::TurnOff(void)
 	return;
 }
 
-void cLightManager::SetUniformLocations(GLuint shaderID, int lightId)
+unsigned int cLightManager::AddLight(void)
 {
-	std::string lightAttributes = "theLights[" + std::to_string(lightId) + "].position";
-	const GLchar* glLightAttributes = lightAttributes.c_str();
+	return this->m_lightTable.Add(cLight());
+}
 
-	this->theLights[lightId].position_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 diffuse;	// Colour of the light (used for diffuse)
+void cLightManager::RemoveLight(unsigned int lightHandle)
+{
+	this->m_lightTable.Remove(lightHandle);
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].diffuse";
-	glLightAttributes = lightAttributes.c_str();
+	return;
+}
 
-	this->theLights[lightId].diffuse_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 specular;	// rgb = highlight colour, w = power
+cLight* cLightManager::getLight(unsigned int lightHandle)
+{
+	return this->m_lightTable.Get(lightHandle);
+}
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].specular";
-	glLightAttributes = lightAttributes.c_str();
+unsigned int cLightManager::getNumberOfLights(void) const
+{
+	return this->m_lightTable.getNumberOfObjects();
+}
 
-	this->theLights[lightId].specular_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 atten;		// x = constant, y = linear, z = quadratic, w = DistanceCutOff
+unsigned int cLightManager::getNextLight(unsigned int lightHandle) const
+{
+	unsigned int numberOfSlots = this->m_lightTable.getNumberOfSlots();
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].atten";
-	glLightAttributes = lightAttributes.c_str();
+	unsigned int startSlot = cHandleTable<cLight>::getSlotOfHandle(lightHandle);
 
-	this->theLights[lightId].atten_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 direction;	// Spot, directional lights
+	if (startSlot >= numberOfSlots)
+		startSlot = numberOfSlots - 1;
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].direction";
-	glLightAttributes = lightAttributes.c_str();
+	for (unsigned int step = 1; step <= numberOfSlots; step++)
+	{
+		unsigned int nextSlot = (startSlot + step) % numberOfSlots;
+
+		if (this->m_lightTable.isSlotInUse(nextSlot))
+			return this->m_lightTable.getHandle(nextSlot);
+	}
+
+	return INVALID_LIGHT_HANDLE;
+}
 
-	this->theLights[lightId].direction_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 param1;	// x = lightType, y = inner angle, z = outer angle, w = TBD
+void cLightManager::m_UpdateRadii(void)
+{
+	this->m_vecRadiusSlots.clear();
+	this->m_vecRadiusConstAtten.clear();
+	this->m_vecRadiusLinearAtten.clear();
+	this->m_vecRadiusQuadraticAtten.clear();
+
+	for (unsigned int slot = 0; slot != this->m_lightTable.getNumberOfSlots(); slot++)
+	{
+		if (!this->m_lightTable.isSlotInUse(slot))
+			continue;
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].param1";
-	glLightAttributes = lightAttributes.c_str();
+		const cLight& theLight = this->m_lightTable.getSlot(slot);
 
-	this->theLights[lightId].param1_UL = glGetUniformLocation(shaderID, glLightAttributes);
-	//        vec4 param2;	// x = 0 for off, 1 for on
+		if (glm::vec3(theLight.atten) == theLight.radiusAtten)
+			continue;
+
+		this->m_vecRadiusSlots.push_back(slot);
+		this->m_vecRadiusConstAtten.push_back(theLight.atten.x);
+		this->m_vecRadiusLinearAtten.push_back(theLight.atten.y);
+		this->m_vecRadiusQuadraticAtten.push_back(theLight.atten.z);
+	}
 
-	lightAttributes = "theLights[" + std::to_string(lightId) + "].param2";
-	glLightAttributes = lightAttributes.c_str();
+	unsigned int numberOfRadii = (unsigned int)this->m_vecRadiusSlots.size();
 
-	this->theLights[lightId].param2_UL = glGetUniformLocation(shaderID, glLightAttributes);
+	if (numberOfRadii == 0)
+		return;
+
+	this->m_vecRadii.resize(numberOfRadii);
+
+	cLightHelper::calcDistsFromAtten(cLightHelper::LIGHT_RADIUS_LEVEL,
+		this->m_vecRadiusConstAtten.data(), this->m_vecRadiusLinearAtten.data(), this->m_vecRadiusQuadraticAtten.data(),
+		numberOfRadii, this->m_vecRadii.data());
+
+	for (unsigned int index = 0; index != numberOfRadii; index++)
+	{
+		cLight& theLight = this->m_lightTable.getSlot(this->m_vecRadiusSlots[index]);
+
+		theLight.radius = this->m_vecRadii[index];
+		theLight.radiusAtten = glm::vec3(theLight.atten);
+	}
+
+	this->m_lastUploadStats.numberOfRadiiSolved = numberOfRadii;
 
 	return;
 }
 
-void cLightManager::UpdateUniformValues(GLuint shaderID)
+void cLightManager::UpdateLightBuffer(void)
 {
-	for (unsigned int index = 0; index != cLightManager::NUMBER_OF_LIGHTS_IM_USING; index++)
+	this->m_lastUploadStats = sLightUploadStats();
+
+	this->m_UpdateRadii();
+
+	//--------------------------Pack the lights that are on------------------------------
+
+	unsigned int activeLights = 0;
+
+	for (unsigned int lightSlot = 0; lightSlot != this->m_lightTable.getNumberOfSlots(); lightSlot++)
+	{
+		// x = 0 for off, 1 for on
+		if (!this->m_lightTable.isSlotInUse(lightSlot) || this->m_lightTable.getSlot(lightSlot).param2.x == 0.0f)
+			continue;
+
+		const cLight& theLight = this->m_lightTable.getSlot(lightSlot);
+
+		sLightBlockEntry lightEntry;
+
+		lightEntry.position = theLight.position;
+		lightEntry.diffuse = theLight.diffuse;
+		lightEntry.specular = theLight.specular;
+		lightEntry.atten = glm::vec4(glm::vec3(theLight.atten), theLight.radius);
+		lightEntry.direction = theLight.direction;
+		lightEntry.param1 = theLight.param1;
+		lightEntry.param2 = theLight.param2;
+
+		if (activeLights == this->m_vecUploadedLights.size())
+		{
+			this->m_vecUploadedLights.push_back(lightEntry);
+			this->m_vecSlotDirty.push_back(true);
+		}
+		else
+		{
+			sLightBlockEntry& uploadedEntry = this->m_vecUploadedLights[activeLights];
+
+			bool bSlotDirty = this->m_bAllDirty || (memcmp(&uploadedEntry, &lightEntry, sizeof(sLightBlockEntry)) != 0);
+
+			if (bSlotDirty)
+				uploadedEntry = lightEntry;
+
+			this->m_vecSlotDirty[activeLights] = bSlotDirty;
+		}
+
+		if (this->m_vecSlotDirty[activeLights])
+			this->m_lastUploadStats.numberOfDirtyLights++;
+
+		activeLights++;
+	}
+
+	//--------------------------Grow the buffer------------------------------------------
+
+	if (this->m_lightBuffer.getID() == 0 || activeLights > this->m_bufferCapacity)
 	{
-		glUniform4f(theLights[index].position_UL,
-			theLights[index].position.x,
-			theLights[index].position.y,
-			theLights[index].position.z,
-			theLights[index].position.w);
-
-		glUniform4f(theLights[index].diffuse_UL,
-			theLights[index].diffuse.x,
-			theLights[index].diffuse.y,
-			theLights[index].diffuse.z,
-			theLights[index].diffuse.w);
-
-		glUniform4f(theLights[index].specular_UL,
-			theLights[index].specular.x,
-			theLights[index].specular.y,
-			theLights[index].specular.z,
-			theLights[index].specular.w);
-
-		glUniform4f(theLights[index].atten_UL,
-			theLights[index].atten.x,
-			theLights[index].atten.y,
-			theLights[index].atten.z,
-			theLights[index].atten.w);
-
-		glUniform4f(theLights[index].direction_UL,
-			theLights[index].direction.x,
-			theLights[index].direction.y,
-			theLights[index].direction.z,
-			theLights[index].direction.w);
-
-		glUniform4f(theLights[index].param1_UL,
-			theLights[index].param1.x,
-			theLights[index].param1.y,
-			theLights[index].param1.z,
-			theLights[index].param1.w);
-
-		glUniform4f(theLights[index].param2_UL,
-			theLights[index].param2.x,
-			theLights[index].param2.y,
-			theLights[index].param2.z,
-			theLights[index].param2.w);
+		unsigned int newCapacity = (this->m_bufferCapacity > 0) ? this->m_bufferCapacity : 16;
+
+		while (newCapacity < activeLights)
+			newCapacity *= 2;
+
+		this->m_bufferCapacity = newCapacity;
+
+		this->m_lightBuffer.Create();
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->m_lightBuffer.getID());
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(sLightBufferHeader) + (GLsizeiptr)newCapacity * sizeof(sLightBlockEntry), NULL, GL_DYNAMIC_DRAW);
+
+		// New buffer, nothing in it yet
+		this->m_bAllDirty = true;
+
+		for (unsigned int slot = 0; slot != activeLights; slot++)
+			this->m_vecSlotDirty[slot] = true;
+
+		this->m_lastUploadStats.numberOfDirtyLights = activeLights;
 	}
+	else
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->m_lightBuffer.getID());
+
+	//--------------------------Upload what changed--------------------------------------
+
+	// Slots past the count aren't read by the shader, so they're left as they are
+	if (this->m_bAllDirty || this->m_uploadedHeader.lightCount.x != (int)activeLights)
+	{
+		this->m_uploadedHeader.lightCount = glm::ivec4((int)activeLights, 0, 0, 0);
+
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(sLightBufferHeader), &this->m_uploadedHeader);
+
+		this->m_lastUploadStats.numberOfUploads++;
+		this->m_lastUploadStats.bytesUploaded += sizeof(sLightBufferHeader);
+	}
+
+	unsigned int slot = 0;
+
+	while (slot < activeLights)
+	{
+		if (!this->m_vecSlotDirty[slot])
+		{
+			slot++;
+			continue;
+		}
+
+		unsigned int firstSlot = slot;
 
+		while (slot < activeLights && this->m_vecSlotDirty[slot])
+			slot++;
+
+		GLsizeiptr rangeBytes = (GLsizeiptr)(slot - firstSlot) * sizeof(sLightBlockEntry);
+
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(sLightBufferHeader) + (GLintptr)firstSlot * sizeof(sLightBlockEntry),
+			rangeBytes, &this->m_vecUploadedLights[firstSlot]);
+
+		this->m_lastUploadStats.numberOfUploads++;
+		this->m_lastUploadStats.bytesUploaded += (unsigned int)rangeBytes;
+	}
+
+	this->m_lastUploadStats.numberOfActiveLights = activeLights;
+
+	this->m_bAllDirty = false;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_LIGHTS, this->m_lightBuffer.getID());
+
+	return;
+}
+
+void cLightManager::MarkAllDirty(void)
+{
+	this->m_bAllDirty = true;
 
 	return;
 }
 
+sLightUploadStats cLightManager::getLastUploadStats(void) const
+{
+	return this->m_lastUploadStats;
+}
+
+const sLightBlockEntry* cLightManager::getActiveLights(unsigned int& numberOfActiveLights) const
+{
+	numberOfActiveLights = (unsigned int)this->m_uploadedHeader.lightCount.x;
+
+	return this->m_vecUploadedLights.empty() ? NULL : this->m_vecUploadedLights.data();
+}
 
 cLightManager::cLightManager()
 {
-}
\ No newline at end of file
+	this->m_uploadedHeader.lightCount = glm::ivec4(0);
+}
@@ -3,8 +3,13 @@
 #include "OpenGLCommon.h"
 #include <glm/glm.hpp>
 #include <glm/vec4.hpp>
+#include <vector>
 
-// This structure matches what's in the shader
+#include "sShaderBlocks.h"
+#include "cGLResource.h"
+#include "cHandleTable.h"
+
+// This structure matches what's in the shader (sLightBlockEntry)
 class cLight
 {
 public:
@@ -13,7 +18,7 @@ public:
     glm::vec4 position;
     glm::vec4 diffuse;	// Colour of the light (used for diffuse)
     glm::vec4 specular;	// rgb = highlight colour, w = power
-    glm::vec4 atten;		// x = constant, y = linear, z = quadratic, w = DistanceCutOff
+    glm::vec4 atten;		// x = constant, y = linear, z = quadratic, w = not used (radius goes there in the buffer)
     glm::vec4 direction;	// Spot, directional lights
     glm::vec4 param1;	// x = lightType, y = inner angle, z = outer angle, w = TBD
     // 0 = pointlight
@@ -21,31 +26,84 @@ public:
     // 2 = directional light
     glm::vec4 param2;	// x = 0 for off, 1 for on
 
+    // Distance at which the light drops to cLightHelper::LIGHT_RADIUS_LEVEL. Set by
+    //	UpdateLightBuffer, only re-solved when atten changes (radiusAtten is what it was solved for).
+    float radius;
+    glm::vec3 radiusAtten;
+
     void TurnOn(void);
     void TurnOff(void);
+};
 
-    // These are the uniform locations for this light in the shader
-    GLint position_UL;
-    GLint diffuse_UL;
-    GLint specular_UL;
-    GLint atten_UL;
-    GLint direction_UL;
-    GLint param1_UL;
-    GLint param2_UL;
+// What the last UpdateLightBuffer did
+struct sLightUploadStats
+{
+    unsigned int numberOfActiveLights = 0;
+    unsigned int numberOfDirtyLights = 0;     // Slots that differed from what the buffer held
+    unsigned int numberOfUploads = 0;         // glBufferSubData calls (dirty slots next to each other go up together)
+    unsigned int bytesUploaded = 0;
+    unsigned int numberOfRadiiSolved = 0;     // Lights whose attenuation changed
 };
 
+// Any number of lights, kept in a shader storage buffer ("Lights", STORAGE_BINDING_LIGHTS).
+// A light is addressed by the handle AddLight returns. Handles don't change when other
+//	lights are added or removed; a removed light's handle stops working (cHandleTable).
 class cLightManager
 {
 public:
     cLightManager();
 
-    // This is called once
-    void SetUniformLocations(GLuint shaderID, int lightId);
+    static const unsigned int INVALID_LIGHT_HANDLE = cHandleTable<cLight>::INVALID_HANDLE;
 
-    // This is called every frame
-    void UpdateUniformValues(GLuint shaderID);
+    // New light with cLight's defaults (off)
+    unsigned int AddLight(void);
 
-    static const unsigned int NUMBER_OF_LIGHTS_IM_USING = 15;
-    cLight theLights[NUMBER_OF_LIGHTS_IM_USING];
-};
+    void RemoveLight(unsigned int lightHandle);
+
+    // NULL if there is no such light (or it was removed). Can be written directly, UpdateLightBuffer picks it up.
+    //	Stays valid until the next AddLight.
+    cLight* getLight(unsigned int lightHandle);
+
+    unsigned int getNumberOfLights(void) const;
+
+    // Handle of the next light after lightHandle (wraps, INVALID_LIGHT_HANDLE to start),
+    //	INVALID_LIGHT_HANDLE if there are no lights
+    unsigned int getNextLight(unsigned int lightHandle) const;
+
+    // This is called every frame : the lights that are on are packed at the front of the
+    //	light buffer and only the slots that changed since the last call are uploaded.
+    //	Changes are found by comparing against what the buffer holds.
+    void UpdateLightBuffer(void);
+
+    // Uploads everything on the next UpdateLightBuffer
+    void MarkAllDirty(void);
 
+    sLightUploadStats getLastUploadStats(void) const;
+
+    // The lights that are on as the last UpdateLightBuffer packed them (light buffer order)
+    const sLightBlockEntry* getActiveLights(unsigned int& numberOfActiveLights) const;
+
+private:
+
+    cHandleTable< cLight > m_lightTable;
+
+    cGLBuffer m_lightBuffer;
+    unsigned int m_bufferCapacity = 0;       // In lights
+
+    // Copy of the buffer's contents, packed
+    sLightBufferHeader m_uploadedHeader;
+    std::vector< sLightBlockEntry > m_vecUploadedLights;
+    std::vector< bool > m_vecSlotDirty;
+    bool m_bAllDirty = true;
+
+    sLightUploadStats m_lastUploadStats;
+
+    // Lights whose radius is being re-solved, by attenuation part (cLightHelper::calcDistsFromAtten)
+    std::vector< unsigned int > m_vecRadiusSlots;
+    std::vector< float > m_vecRadiusConstAtten;
+    std::vector< float > m_vecRadiusLinearAtten;
+    std::vector< float > m_vecRadiusQuadraticAtten;
+    std::vector< float > m_vecRadii;
+
+    void m_UpdateRadii(void);
+};
@@ -0,0 +1,151 @@
+#include "cMappedFile.h"
+
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+cMappedFile::cMappedFile()
+{
+	this->m_pData = NULL;
+	this->m_size = 0;
+
+#ifdef _WIN32
+	this->m_hFile = INVALID_HANDLE_VALUE;
+	this->m_hMapping = NULL;
+#else
+	this->m_fileDescriptor = -1;
+#endif
+}
+
+cMappedFile::~cMappedFile()
+{
+	this->Close();
+}
+
+bool cMappedFile::Open(const std::string& fileName)
+{
+	this->Close();
+
+#ifdef _WIN32
+	HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (hMapping == NULL)
+	{
+		CloseHandle(hFile);
+		return false;
+	}
+
+	void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (pView == NULL)
+	{
+		CloseHandle(hMapping);
+		CloseHandle(hFile);
+		return false;
+	}
+
+	this->m_hFile = hFile;
+	this->m_hMapping = hMapping;
+	this->m_pData = static_cast<const unsigned char*>(pView);
+	this->m_size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+	int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+
+	if (fileDescriptor < 0)
+		return false;
+
+	struct stat fileInfo;
+
+	if (fstat(fileDescriptor, &fileInfo) != 0 || fileInfo.st_size == 0)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	void* pView = mmap(NULL, static_cast<std::size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+	if (pView == MAP_FAILED)
+	{
+		close(fileDescriptor);
+		return false;
+	}
+
+	madvise(pView, static_cast<std::size_t>(fileInfo.st_size), MADV_SEQUENTIAL);
+
+	this->m_fileDescriptor = fileDescriptor;
+	this->m_pData = static_cast<const unsigned char*>(pView);
+	this->m_size = static_cast<std::size_t>(fileInfo.st_size);
+#endif
+
+	return true;
+}
+
+void cMappedFile::Close(void)
+{
+#ifdef _WIN32
+	if (this->m_pData != NULL)
+		UnmapViewOfFile(this->m_pData);
+
+	if (this->m_hMapping != NULL)
+		CloseHandle(this->m_hMapping);
+
+	if (this->m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(this->m_hFile);
+
+	this->m_hFile = INVALID_HANDLE_VALUE;
+	this->m_hMapping = NULL;
+#else
+	if (this->m_pData != NULL)
+		munmap(const_cast<unsigned char*>(this->m_pData), this->m_size);
+
+	if (this->m_fileDescriptor >= 0)
+		close(this->m_fileDescriptor);
+
+	this->m_fileDescriptor = -1;
+#endif
+
+	this->m_pData = NULL;
+	this->m_size = 0;
+
+	return;
+}
+
+bool cMappedFile::isOpen(void) const
+{
+	return this->m_pData != NULL;
+}
+
+const unsigned char* cMappedFile::getData(void) const
+{
+	return this->m_pData;
+}
+
+std::size_t cMappedFile::getSize(void) const
+{
+	return this->m_size;
+}
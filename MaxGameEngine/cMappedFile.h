@@ -0,0 +1,43 @@
+#ifndef _cMappedFile_HG_
+#define _cMappedFile_HG_
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents stay valid until
+//	Close() is called or the object goes out of scope.
+class cMappedFile
+{
+public:
+
+	cMappedFile();
+	~cMappedFile();
+
+	bool Open(const std::string& fileName);
+
+	void Close(void);
+
+	bool isOpen(void) const;
+
+	const unsigned char* getData(void) const;
+
+	std::size_t getSize(void) const;
+
+private:
+
+	// Not copyable (owns the OS handles)
+	cMappedFile(const cMappedFile&);
+	cMappedFile& operator=(const cMappedFile&);
+
+	const unsigned char* m_pData;
+	std::size_t m_size;
+
+#ifdef _WIN32
+	void* m_hFile;
+	void* m_hMapping;
+#else
+	int m_fileDescriptor;
+#endif
+};
+
+#endif
@@ -1,10 +1,24 @@
 #include "cMesh.h"
+#include "sModelDrawInfo.h"
+#include "cTransformHierarchy.h"
 #include <iostream>	
+#include <cmath>
+#include <algorithm>
 
 unsigned int cMesh::m_nextUniqueID = cMesh::FIRST_UNIQUE_ID;
 
 cMesh::cMesh()
 {
+	this->m_bLocalMatrixDirty = true;
+	this->m_bWorldMatrixDirty = true;
+	this->m_matLocal = this->m_matLocalNormal = glm::mat4(1.0f);
+	this->m_matWorld = this->m_matWorldNormal = glm::mat4(1.0f);
+	this->m_worldVersion = 0;
+
+	this->m_pHierarchy = NULL;
+	this->m_hierarchyNode = 0;
+	this->m_pParent = NULL;
+
 	this->drawPosition = glm::vec3(0.0f, 0.0f, 0.0f);
 	this->drawOrientation = glm::vec3(0.0f, 0.0f, 0.0f);
 	this->setRotationFromEuler(glm::vec3(0.0f, 0.0f, 0.0f));
@@ -16,6 +30,15 @@ cMesh::cMesh()
 	this->bIsVisible = true;
 	this->bUseManualColours = false;
 
+	this->pModelDrawInfo = NULL;
+
+	this->currentLOD = 0;
+
+	this->m_bWorldBoundsValid = false;
+	this->m_boundsWorldVersion = 0;
+	this->m_pBoundsModel = NULL;
+	this->m_worldSphereRadius = 0.0f;
+
 	this->m_UniqueID = cMesh::m_nextUniqueID;
 
 	cMesh::m_nextUniqueID++;
@@ -34,6 +57,7 @@ unsigned int cMesh::getUniqueID(void)
 void cMesh::setUniformDrawScale(float scale)
 {
 	this->drawScale.x = this->drawScale.y = this->drawScale.z = scale;
+	this->m_MarkTransformDirty();
 	return;
 }
 
@@ -45,6 +69,7 @@ glm::vec3 cMesh::getDrawPosition(void)
 void cMesh::setDrawPosition(const glm::vec3& newPosition)
 {
 	this->drawPosition = newPosition;
+	this->m_MarkTransformDirty();
 	return;
 }
 
@@ -62,7 +87,165 @@ void cMesh::setDrawOrientation(const glm::vec3& newOrientation)
 void cMesh::setDrawOrientation(const glm::quat& newOrientation)
 {
 	this->m_qOrientation = newOrientation;
+	this->m_MarkTransformDirty();
+	return;
+}
+
+const glm::mat4& cMesh::getLocalMatrix(void)
+{
+	this->m_UpdateLocalMatrix();
+
+	return this->m_matLocal;
+}
+
+const glm::mat4& cMesh::getLocalNormalMatrix(void)
+{
+	this->m_UpdateLocalMatrix();
+
+	return this->m_matLocalNormal;
+}
+
+const glm::mat4& cMesh::getWorldMatrix(void)
+{
+	// In a hierarchy it's only changed by cTransformHierarchy::Update
+	if (this->m_pHierarchy == NULL && this->m_bWorldMatrixDirty)
+	{
+		this->m_UpdateLocalMatrix();
+
+		this->m_bWorldMatrixDirty = false;
+
+		this->m_matWorld = this->m_matLocal;
+		this->m_matWorldNormal = this->m_matLocalNormal;
+		this->m_worldVersion++;
+	}
+
+	return this->m_matWorld;
+}
+
+const glm::mat4& cMesh::getWorldNormalMatrix(void)
+{
+	this->getWorldMatrix();
+
+	return this->m_matWorldNormal;
+}
+
+cMesh* cMesh::getParent(void) const
+{
+	return this->m_pParent;
+}
+
+void cMesh::m_MarkTransformDirty(void)
+{
+	this->m_bLocalMatrixDirty = true;
+	this->m_bWorldMatrixDirty = true;
+
+	if (this->m_pHierarchy != NULL)
+		this->m_pHierarchy->m_MarkNodeDirty(this->m_hierarchyNode);
+
+	return;
+}
+
+void cMesh::m_UpdateLocalMatrix(void)
+{
+	if (!this->m_bLocalMatrixDirty)
+		return;
+
+	this->m_bLocalMatrixDirty = false;
+
+	glm::mat3 matRotation = glm::mat3_cast(this->m_qOrientation);
+
+	// Same as translate * rotation * scale, without the matrix multiplies
+	this->m_matLocal[0] = glm::vec4(matRotation[0] * this->drawScale.x, 0.0f);
+	this->m_matLocal[1] = glm::vec4(matRotation[1] * this->drawScale.y, 0.0f);
+	this->m_matLocal[2] = glm::vec4(matRotation[2] * this->drawScale.z, 0.0f);
+	this->m_matLocal[3] = glm::vec4(this->drawPosition, 1.0f);
+
+	// The translation doesn't touch the normals (the shader uses the xyz it gets)
+	if (this->drawScale.x == this->drawScale.y && this->drawScale.y == this->drawScale.z)
+	{
+		// (R * s)^-T = R / s, a rotation's inverse being its transpose
+		this->m_matLocalNormal = glm::mat4(matRotation * (1.0f / this->drawScale.x));
+	}
+	else
+	{
+		this->m_matLocalNormal = glm::mat4(glm::transpose(glm::inverse(glm::mat3(this->m_matLocal))));
+	}
+
 	return;
 }
 
+void cMesh::getWorldAABB(glm::vec3& minXYZ, glm::vec3& maxXYZ)
+{
+	this->m_UpdateWorldBounds();
+
+	minXYZ = this->m_worldMinXYZ;
+	maxXYZ = this->m_worldMaxXYZ;
+
+	return;
+}
+
+void cMesh::getWorldBoundingSphere(glm::vec3& centre, float& radius)
+{
+	this->m_UpdateWorldBounds();
+
+	centre = this->m_worldSphereCentre;
+	radius = this->m_worldSphereRadius;
+
+	return;
+}
+
+void cMesh::m_UpdateWorldBounds(void)
+{
+	const glm::mat4& matWorld = this->getWorldMatrix();
 
+	if (this->m_bWorldBoundsValid &&
+		this->m_pBoundsModel == this->pModelDrawInfo &&
+		this->m_boundsWorldVersion == this->m_worldVersion)
+	{
+		return;
+	}
+
+	this->m_bWorldBoundsValid = true;
+	this->m_pBoundsModel = this->pModelDrawInfo;
+	this->m_boundsWorldVersion = this->m_worldVersion;
+
+	glm::vec3 worldPosition = glm::vec3(matWorld[3]);
+
+	if (this->pModelDrawInfo == NULL)
+	{
+		this->m_worldMinXYZ = this->m_worldMaxXYZ = this->m_worldSphereCentre = worldPosition;
+		this->m_worldSphereRadius = 0.0f;
+		return;
+	}
+
+	// Rotation * scale (the parents' included)
+	glm::mat3 matRotationScale = glm::mat3(matWorld);
+
+	//-------------------Box-----------------
+
+	// Transformed centre, and the half size pushed through the absolute matrix
+	//	(Arvo, "Transforming Axis-Aligned Bounding Boxes")
+	glm::vec3 localCentre = (this->pModelDrawInfo->minExtents_XYZ + this->pModelDrawInfo->maxExtents_XYZ) * 0.5f;
+	glm::vec3 localHalfSize = this->pModelDrawInfo->deltaExtents_XYZ * 0.5f;
+
+	glm::mat3 matAbsolute;
+
+	for (unsigned int column = 0; column != 3; column++)
+		matAbsolute[column] = glm::abs(matRotationScale[column]);
+
+	glm::vec3 worldCentre = worldPosition + matRotationScale * localCentre;
+	glm::vec3 worldHalfSize = matAbsolute * localHalfSize;
+
+	this->m_worldMinXYZ = worldCentre - worldHalfSize;
+	this->m_worldMaxXYZ = worldCentre + worldHalfSize;
+
+	//-------------------Sphere-----------------
+
+	// Longest of the scaled axes
+	float largestScale = std::max(glm::length(matRotationScale[0]), std::max(glm::length(matRotationScale[1]), glm::length(matRotationScale[2])));
+
+	this->m_worldSphereCentre = worldPosition + matRotationScale * this->pModelDrawInfo->boundingSphereCentre;
+	this->m_worldSphereRadius = this->pModelDrawInfo->boundingSphereRadius * largestScale;
+
+	return;
+}
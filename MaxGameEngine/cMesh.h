@@ -9,6 +9,9 @@
 
 #include "iPhysicsMeshTransformAccess.h"
 
+struct sModelDrawInfo;
+class cTransformHierarchy;
+
 class cMesh : public iPhysicsMeshTransformAccess
 {
 private:
@@ -18,6 +21,42 @@ private:
 	static const unsigned int FIRST_UNIQUE_ID = 1000;
 	static unsigned int m_nextUniqueID;
 
+	// What the world bounds were last calculated from
+	bool m_bWorldBoundsValid;
+	unsigned int m_boundsWorldVersion;
+	const sModelDrawInfo* m_pBoundsModel;
+
+	glm::vec3 m_worldMinXYZ;
+	glm::vec3 m_worldMaxXYZ;
+	glm::vec3 m_worldSphereCentre;
+	float m_worldSphereRadius;
+
+	// Recalculates the world bounds if the world matrix or the model changed
+	void m_UpdateWorldBounds(void);
+
+	// Set by the transform setters, cleared once the local matrices are rebuilt
+	bool m_bLocalMatrixDirty;
+	glm::mat4 m_matLocal;
+	glm::mat4 m_matLocalNormal;
+
+	// The local matrices with the parents' applied (cTransformHierarchy::Update)
+	//	The world flag is separate, the local getters clear the local one
+	bool m_bWorldMatrixDirty;
+	glm::mat4 m_matWorld;
+	glm::mat4 m_matWorldNormal;
+	unsigned int m_worldVersion;		// Goes up every time m_matWorld changes
+
+	// The hierarchy this mesh is in (NULL = none) and where it is in its flattened array
+	friend class cTransformHierarchy;
+	cTransformHierarchy* m_pHierarchy;
+	unsigned int m_hierarchyNode;
+	cMesh* m_pParent;
+
+	void m_UpdateLocalMatrix(void);
+
+	// Local and world matrices dirty, and the hierarchy told
+	void m_MarkTransformDirty(void);
+
 public:
 
 	cMesh();
@@ -30,8 +69,20 @@ public:
 
 	std::string meshName;
 
+	// Shared by every mesh loaded from the same file (owned by cVAOManager)
+	sModelDrawInfo* pModelDrawInfo;
+
 	std::string friendlyName;
 
+	// Screen size (fraction of the viewport height) below which LOD 1, 2, ... is drawn.
+	//	Empty uses the engine's defaults.
+	std::vector<float> vecLODScreenSizes;
+
+	// Level picked last frame (kept for the hysteresis)
+	unsigned int currentLOD;
+
+	// Change these through the setters below, they keep the cached matrices up to date.
+	//	Relative to the parent for a child mesh.
 	glm::vec3 drawPosition;
 
 	glm::vec3 drawOrientation;
@@ -40,17 +91,20 @@ public:
 
 	glm::vec4 wholeObjectManualColourRGBA;
 
+	// Kept by cTransformHierarchy::setParent, don't change directly
 	std::vector<cMesh*> vec_pChildMeshes;
 
 	void setRotationFromEuler(glm::vec3 newEulerAngleXYZ)
 	{
 		this->m_qOrientation = glm::quat(newEulerAngleXYZ);
+		this->m_MarkTransformDirty();
 	}
 
 	void adjustRoationAngleFromEuler(glm::vec3 EulerAngleXYZ_Adjust)
 	{
 		glm::quat qChange = glm::quat(EulerAngleXYZ_Adjust);
 		this->m_qOrientation *= qChange;
+		this->m_MarkTransformDirty();
 	}
 
 	void setUniformDrawScale(float scale);
@@ -69,6 +123,33 @@ public:
 	virtual glm::vec3 getDrawOrientation(void);
 
 	unsigned int getUniqueID(void);
+
+	//-------------------Matrices-----------------
+
+	// translate * rotation * scale, only rebuilt after one of the setters was called
+	const glm::mat4& getLocalMatrix(void);
+
+	// Inverse transpose of the local matrix (for the normals). With a uniform scale that's
+	//	just the rotation over the scale, no inverse needed.
+	const glm::mat4& getLocalNormalMatrix(void);
+
+	// The parent's world matrix * the local matrix, as of the last cTransformHierarchy::Update.
+	//	Just the local matrix for a mesh that isn't in a hierarchy.
+	const glm::mat4& getWorldMatrix(void);
+
+	const glm::mat4& getWorldNormalMatrix(void);
+
+	// NULL for a root (or a mesh that isn't in a hierarchy)
+	cMesh* getParent(void) const;
+
+	//-------------------World Bounds-----------------
+
+	// The model's bounds (sModelDrawInfo extents / bounding sphere) through the world matrix.
+	// Only recalculated when it (or pModelDrawInfo) changed since the last call.
+	// Zero sized at the mesh's origin if the mesh has no model.
+	void getWorldAABB(glm::vec3& minXYZ, glm::vec3& maxXYZ);
+
+	void getWorldBoundingSphere(glm::vec3& centre, float& radius);
 };
 
 #endif
@@ -0,0 +1,599 @@
+#include "cMeshOptimizer.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+
+const float cMeshOptimizer::OVERDRAW_THRESHOLD = 1.05f;
+
+// Forsyth's scoring constants (from the paper)
+static const float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static const float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static const float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static const float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// Valence scores are looked up below this, worked out above it
+static const unsigned int FORSYTH_MAX_TABLE_VALENCE = 64;
+
+sVertexCacheStats cMeshOptimizer::CalcVertexCacheStats(const unsigned int* pIndices, unsigned int numberOfIndices,
+	unsigned int numberOfVertices, unsigned int cacheSize)
+{
+	sVertexCacheStats cacheStats;
+	cacheStats.ACMR = 0.0f;
+	cacheStats.ATVR = 0.0f;
+
+	if (pIndices == NULL || numberOfIndices < 3 || numberOfVertices == 0)
+		return cacheStats;
+
+	// FIFO cache : a vertex is still cached if fewer than cacheSize misses happened since it was loaded
+	std::vector<unsigned int> vecLoadTime(numberOfVertices, 0);
+
+	unsigned int currentTime = cacheSize + 1;
+	unsigned int numberOfMisses = 0;
+	unsigned int numberOfUsedVertices = 0;
+
+	for (unsigned int index = 0; index != numberOfIndices; index++)
+	{
+		unsigned int vertexIndex = pIndices[index];
+
+		if (vecLoadTime[vertexIndex] == 0)
+			numberOfUsedVertices++;
+
+		if (currentTime - vecLoadTime[vertexIndex] > cacheSize)
+		{
+			vecLoadTime[vertexIndex] = currentTime;
+			currentTime++;
+			numberOfMisses++;
+		}
+	}
+
+	cacheStats.ACMR = (float)numberOfMisses / (float)(numberOfIndices / 3);
+	cacheStats.ATVR = (float)numberOfMisses / (float)numberOfUsedVertices;
+
+	return cacheStats;
+}
+
+void cMeshOptimizer::OptimizeVertexCache(unsigned int* pIndices, unsigned int numberOfIndices, unsigned int numberOfVertices)
+{
+	unsigned int numberOfTriangles = numberOfIndices / 3;
+
+	if (pIndices == NULL || numberOfTriangles == 0)
+		return;
+
+	//-----------------------------Score tables------------------------------------------------
+
+	float cachePositionScore[OPTIMIZE_CACHE_SIZE];
+
+	for (unsigned int position = 0; position != OPTIMIZE_CACHE_SIZE; position++)
+	{
+		if (position < 3)
+			cachePositionScore[position] = FORSYTH_LAST_TRIANGLE_SCORE;
+		else
+			cachePositionScore[position] = powf(1.0f - (float)(position - 3) / (float)(OPTIMIZE_CACHE_SIZE - 3), FORSYTH_CACHE_DECAY_POWER);
+	}
+
+	float valenceScore[FORSYTH_MAX_TABLE_VALENCE];
+
+	valenceScore[0] = 0.0f;
+
+	for (unsigned int valence = 1; valence != FORSYTH_MAX_TABLE_VALENCE; valence++)
+		valenceScore[valence] = FORSYTH_VALENCE_BOOST_SCALE * powf((float)valence, -FORSYTH_VALENCE_BOOST_POWER);
+
+	//-----------------------------Vertex -> triangle lists------------------------------------
+
+	// Each vertex's list keeps the triangles still to be added at the front
+	std::vector<unsigned int> vecActiveTriangles(numberOfVertices, 0);
+	std::vector<unsigned int> vecAdjacencyOffset(numberOfVertices + 1, 0);
+	std::vector<unsigned int> vecAdjacency(numberOfIndices);
+
+	for (unsigned int index = 0; index != numberOfIndices; index++)
+		vecActiveTriangles[pIndices[index]]++;
+
+	for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+		vecAdjacencyOffset[vertexIndex + 1] = vecAdjacencyOffset[vertexIndex] + vecActiveTriangles[vertexIndex];
+
+	{
+		std::vector<unsigned int> vecFillPosition(vecAdjacencyOffset.begin(), vecAdjacencyOffset.end() - 1);
+
+		for (unsigned int index = 0; index != numberOfIndices; index++)
+			vecAdjacency[vecFillPosition[pIndices[index]]++] = index / 3;
+	}
+
+	//-----------------------------Initial scores----------------------------------------------
+
+	std::vector<int> vecCachePosition(numberOfVertices, -1);
+	std::vector<float> vecVertexScore(numberOfVertices, -1.0f);
+
+	for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+	{
+		unsigned int valence = vecActiveTriangles[vertexIndex];
+
+		if (valence != 0)
+			vecVertexScore[vertexIndex] = (valence < FORSYTH_MAX_TABLE_VALENCE) ? valenceScore[valence] :
+				FORSYTH_VALENCE_BOOST_SCALE * powf((float)valence, -FORSYTH_VALENCE_BOOST_POWER);
+	}
+
+	std::vector<float> vecTriangleScore(numberOfTriangles);
+	std::vector<char> vecTriangleAdded(numberOfTriangles, 0);
+
+	int bestTriangle = -1;
+	float bestScore = -1.0f;
+
+	for (unsigned int triangle = 0; triangle != numberOfTriangles; triangle++)
+	{
+		const unsigned int* pTriangle = &(pIndices[triangle * 3]);
+
+		vecTriangleScore[triangle] = vecVertexScore[pTriangle[0]] + vecVertexScore[pTriangle[1]] + vecVertexScore[pTriangle[2]];
+
+		if (vecTriangleScore[triangle] > bestScore)
+		{
+			bestScore = vecTriangleScore[triangle];
+			bestTriangle = (int)triangle;
+		}
+	}
+
+	//-----------------------------Greedy triangle order---------------------------------------
+
+	std::vector<unsigned int> vecNewIndices;
+	vecNewIndices.reserve(numberOfIndices);
+
+	unsigned int cache[OPTIMIZE_CACHE_SIZE + 3];
+	unsigned int cacheUsed = 0;
+
+	unsigned int nextUnaddedTriangle = 0;
+
+	for (unsigned int step = 0; step != numberOfTriangles; step++)
+	{
+		// Nothing left around the cache, carry on from the first triangle not drawn yet
+		if (bestTriangle < 0)
+		{
+			while (vecTriangleAdded[nextUnaddedTriangle])
+				nextUnaddedTriangle++;
+
+			bestTriangle = (int)nextUnaddedTriangle;
+		}
+
+		vecTriangleAdded[bestTriangle] = 1;
+
+		const unsigned int* pTriangle = &(pIndices[bestTriangle * 3]);
+
+		vecNewIndices.push_back(pTriangle[0]);
+		vecNewIndices.push_back(pTriangle[1]);
+		vecNewIndices.push_back(pTriangle[2]);
+
+		// The triangle's vertices move to the front of the LRU cache
+		unsigned int newCache[OPTIMIZE_CACHE_SIZE + 3];
+		unsigned int newCacheUsed = 0;
+
+		for (unsigned int corner = 0; corner != 3; corner++)
+		{
+			unsigned int vertexIndex = pTriangle[corner];
+
+			if (std::find(newCache, newCache + newCacheUsed, vertexIndex) == newCache + newCacheUsed)
+				newCache[newCacheUsed++] = vertexIndex;
+
+			// Take the triangle out of the vertex's active list
+			unsigned int* pList = &(vecAdjacency[vecAdjacencyOffset[vertexIndex]]);
+			unsigned int listSize = vecActiveTriangles[vertexIndex];
+
+			for (unsigned int listIndex = 0; listIndex != listSize; listIndex++)
+			{
+				if (pList[listIndex] == (unsigned int)bestTriangle)
+				{
+					std::swap(pList[listIndex], pList[listSize - 1]);
+					vecActiveTriangles[vertexIndex]--;
+					break;
+				}
+			}
+		}
+
+		for (unsigned int cacheIndex = 0; cacheIndex != cacheUsed; cacheIndex++)
+		{
+			if (cache[cacheIndex] != pTriangle[0] && cache[cacheIndex] != pTriangle[1] && cache[cacheIndex] != pTriangle[2])
+				newCache[newCacheUsed++] = cache[cacheIndex];
+		}
+
+		// Rescore everything in (or just pushed out of) the cache
+		for (unsigned int cacheIndex = 0; cacheIndex != newCacheUsed; cacheIndex++)
+		{
+			unsigned int vertexIndex = newCache[cacheIndex];
+			unsigned int valence = vecActiveTriangles[vertexIndex];
+
+			vecCachePosition[vertexIndex] = (cacheIndex < OPTIMIZE_CACHE_SIZE) ? (int)cacheIndex : -1;
+
+			if (valence == 0)
+			{
+				vecVertexScore[vertexIndex] = -1.0f;
+				continue;
+			}
+
+			float score = (vecCachePosition[vertexIndex] >= 0) ? cachePositionScore[vecCachePosition[vertexIndex]] : 0.0f;
+
+			score += (valence < FORSYTH_MAX_TABLE_VALENCE) ? valenceScore[valence] :
+				FORSYTH_VALENCE_BOOST_SCALE * powf((float)valence, -FORSYTH_VALENCE_BOOST_POWER);
+
+			vecVertexScore[vertexIndex] = score;
+		}
+
+		cacheUsed = std::min(newCacheUsed, OPTIMIZE_CACHE_SIZE);
+		std::copy(newCache, newCache + cacheUsed, cache);
+
+		// Next triangle is the best one touching those vertices
+		bestTriangle = -1;
+		bestScore = -1.0f;
+
+		for (unsigned int cacheIndex = 0; cacheIndex != newCacheUsed; cacheIndex++)
+		{
+			unsigned int vertexIndex = newCache[cacheIndex];
+
+			const unsigned int* pList = &(vecAdjacency[vecAdjacencyOffset[vertexIndex]]);
+
+			for (unsigned int listIndex = 0; listIndex != vecActiveTriangles[vertexIndex]; listIndex++)
+			{
+				unsigned int triangle = pList[listIndex];
+				const unsigned int* pCandidate = &(pIndices[triangle * 3]);
+
+				float score = vecVertexScore[pCandidate[0]] + vecVertexScore[pCandidate[1]] + vecVertexScore[pCandidate[2]];
+
+				vecTriangleScore[triangle] = score;
+
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = (int)triangle;
+				}
+			}
+		}
+	}
+
+	std::copy(vecNewIndices.begin(), vecNewIndices.end(), pIndices);
+
+	return;
+}
+
+void cMeshOptimizer::OptimizeOverdraw(unsigned int* pIndices, unsigned int numberOfIndices, const sVertex* pVertices, unsigned int numberOfVertices)
+{
+	unsigned int numberOfTriangles = numberOfIndices / 3;
+
+	if (pIndices == NULL || pVertices == NULL || numberOfTriangles == 0)
+		return;
+
+	//-----------------------------Split into clusters-----------------------------------------
+
+	// Hard boundaries are where the cache order already restarts (all 3 vertices miss).
+	// Those get cut further once a cluster's ACMR is close to the whole mesh's, so the
+	//	clusters can be moved around without losing much cache efficiency.
+	float meshACMR = cMeshOptimizer::CalcVertexCacheStats(pIndices, numberOfIndices, numberOfVertices, STATS_CACHE_SIZE).ACMR;
+
+	std::vector<unsigned int> vecLoadTime(numberOfVertices, 0);
+	unsigned int currentTime = STATS_CACHE_SIZE + 1;
+
+	std::vector<unsigned int> vecHardStarts;
+
+	for (unsigned int triangle = 0; triangle != numberOfTriangles; triangle++)
+	{
+		unsigned int numberOfMisses = 0;
+
+		for (unsigned int corner = 0; corner != 3; corner++)
+		{
+			unsigned int vertexIndex = pIndices[triangle * 3 + corner];
+
+			if (currentTime - vecLoadTime[vertexIndex] > STATS_CACHE_SIZE)
+			{
+				vecLoadTime[vertexIndex] = currentTime;
+				currentTime++;
+				numberOfMisses++;
+			}
+		}
+
+		if (triangle == 0 || numberOfMisses == 3)
+			vecHardStarts.push_back(triangle);
+	}
+
+	vecHardStarts.push_back(numberOfTriangles);
+
+	std::vector<unsigned int> vecClusterStarts;
+
+	for (unsigned int hardIndex = 0; hardIndex + 1 < vecHardStarts.size(); hardIndex++)
+	{
+		unsigned int clusterEnd = vecHardStarts[hardIndex + 1];
+
+		unsigned int clusterMisses = 0;
+		unsigned int clusterTriangles = 0;
+
+		// Moving the clock past the cache size empties the simulated cache
+		currentTime += STATS_CACHE_SIZE + 1;
+
+		vecClusterStarts.push_back(vecHardStarts[hardIndex]);
+
+		for (unsigned int triangle = vecHardStarts[hardIndex]; triangle != clusterEnd; triangle++)
+		{
+			for (unsigned int corner = 0; corner != 3; corner++)
+			{
+				unsigned int vertexIndex = pIndices[triangle * 3 + corner];
+
+				if (currentTime - vecLoadTime[vertexIndex] > STATS_CACHE_SIZE)
+				{
+					vecLoadTime[vertexIndex] = currentTime;
+					currentTime++;
+					clusterMisses++;
+				}
+			}
+
+			clusterTriangles++;
+
+			if (triangle + 1 != clusterEnd && (float)clusterMisses <= OVERDRAW_THRESHOLD * meshACMR * (float)clusterTriangles)
+			{
+				vecClusterStarts.push_back(triangle + 1);
+
+				clusterMisses = 0;
+				clusterTriangles = 0;
+				currentTime += STATS_CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	vecClusterStarts.push_back(numberOfTriangles);
+
+	unsigned int numberOfClusters = (unsigned int)vecClusterStarts.size() - 1;
+
+	if (numberOfClusters < 2)
+		return;
+
+	//-----------------------------Sort clusters outside-in------------------------------------
+
+	// Clusters facing away from the middle of the mesh are drawn first, they're the
+	//	ones most likely to hide the rest
+	std::vector<glm::vec3> vecClusterCentroid(numberOfClusters, glm::vec3(0.0f));
+	std::vector<glm::vec3> vecClusterNormal(numberOfClusters, glm::vec3(0.0f));
+	std::vector<float> vecClusterArea(numberOfClusters, 0.0f);
+
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+
+	for (unsigned int cluster = 0; cluster != numberOfClusters; cluster++)
+	{
+		for (unsigned int triangle = vecClusterStarts[cluster]; triangle != vecClusterStarts[cluster + 1]; triangle++)
+		{
+			const sVertex& vertex0 = pVertices[pIndices[triangle * 3 + 0]];
+			const sVertex& vertex1 = pVertices[pIndices[triangle * 3 + 1]];
+			const sVertex& vertex2 = pVertices[pIndices[triangle * 3 + 2]];
+
+			glm::vec3 position0 = glm::vec3(vertex0.x, vertex0.y, vertex0.z);
+			glm::vec3 position1 = glm::vec3(vertex1.x, vertex1.y, vertex1.z);
+			glm::vec3 position2 = glm::vec3(vertex2.x, vertex2.y, vertex2.z);
+
+			glm::vec3 faceNormal = glm::cross(position1 - position0, position2 - position0);
+
+			float area = glm::length(faceNormal) * 0.5f;
+
+			glm::vec3 weightedCentroid = (position0 + position1 + position2) * (area / 3.0f);
+
+			vecClusterCentroid[cluster] += weightedCentroid;
+			vecClusterNormal[cluster] += faceNormal;
+			vecClusterArea[cluster] += area;
+
+			meshCentroid += weightedCentroid;
+			meshArea += area;
+		}
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	std::vector<float> vecClusterSortKey(numberOfClusters, 0.0f);
+	std::vector<unsigned int> vecClusterOrder(numberOfClusters);
+
+	for (unsigned int cluster = 0; cluster != numberOfClusters; cluster++)
+	{
+		vecClusterOrder[cluster] = cluster;
+
+		float normalLength = glm::length(vecClusterNormal[cluster]);
+
+		if (vecClusterArea[cluster] > 0.0f && normalLength > 0.0f)
+		{
+			glm::vec3 clusterCentroid = vecClusterCentroid[cluster] / vecClusterArea[cluster];
+
+			vecClusterSortKey[cluster] = glm::dot(clusterCentroid - meshCentroid, vecClusterNormal[cluster] / normalLength);
+		}
+	}
+
+	std::stable_sort(vecClusterOrder.begin(), vecClusterOrder.end(),
+		[&vecClusterSortKey](unsigned int clusterA, unsigned int clusterB)
+		{
+			return vecClusterSortKey[clusterA] > vecClusterSortKey[clusterB];
+		});
+
+	std::vector<unsigned int> vecNewIndices;
+	vecNewIndices.reserve(numberOfIndices);
+
+	for (unsigned int orderIndex = 0; orderIndex != numberOfClusters; orderIndex++)
+	{
+		unsigned int cluster = vecClusterOrder[orderIndex];
+
+		vecNewIndices.insert(vecNewIndices.end(), pIndices + vecClusterStarts[cluster] * 3, pIndices + vecClusterStarts[cluster + 1] * 3);
+	}
+
+	std::copy(vecNewIndices.begin(), vecNewIndices.end(), pIndices);
+
+	return;
+}
+
+void cMeshOptimizer::OptimizeVertexFetch(unsigned int* pIndices, unsigned int numberOfIndices, sVertex* pVertices, unsigned int numberOfVertices)
+{
+	if (pIndices == NULL || pVertices == NULL || numberOfVertices == 0)
+		return;
+
+	// Vertices are renumbered in the order the index buffer first uses them
+	std::vector<unsigned int> vecRemap(numberOfVertices, UINT_MAX);
+	unsigned int nextVertex = 0;
+
+	for (unsigned int index = 0; index != numberOfIndices; index++)
+	{
+		unsigned int& vertexIndex = pIndices[index];
+
+		if (vecRemap[vertexIndex] == UINT_MAX)
+			vecRemap[vertexIndex] = nextVertex++;
+
+		vertexIndex = vecRemap[vertexIndex];
+	}
+
+	// Unused vertices go on the end
+	for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+	{
+		if (vecRemap[vertexIndex] == UINT_MAX)
+			vecRemap[vertexIndex] = nextVertex++;
+	}
+
+	std::vector<sVertex> vecReordered(numberOfVertices);
+
+	for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+		vecReordered[vecRemap[vertexIndex]] = pVertices[vertexIndex];
+
+	std::copy(vecReordered.begin(), vecReordered.end(), pVertices);
+
+	return;
+}
+
+void cMeshOptimizer::SplitFor16BitIndices(sModelDrawInfo& drawInfo)
+{
+	const unsigned int MAX_BLOCK_VERTICES = 65536;
+
+	if (drawInfo.pIndices == NULL || drawInfo.pVertices == NULL || drawInfo.numberOfVertices <= MAX_BLOCK_VERTICES)
+		return;
+
+	std::vector<sVertex> vecNewVertices;
+	vecNewVertices.reserve(drawInfo.numberOfVertices + drawInfo.numberOfVertices / 16);
+
+	// Where each vertex went in the current block (only valid if its block id matches)
+	std::vector<unsigned int> vecNewIndex(drawInfo.numberOfVertices, 0);
+	std::vector<unsigned int> vecBlockID(drawInfo.numberOfVertices, UINT_MAX);
+
+	unsigned int blockID = 0;
+	unsigned int blockStart = 0;
+
+	// Moves one triangle into the current block (or a new one if it doesn't fit)
+	auto AddTriangleToBlock = [&](unsigned int* pTriangle)
+	{
+		unsigned int numberOfNewVertices = 0;
+
+		for (unsigned int corner = 0; corner != 3; corner++)
+		{
+			if (vecBlockID[pTriangle[corner]] != blockID &&
+				(corner == 0 || pTriangle[corner] != pTriangle[0]) && (corner != 2 || pTriangle[2] != pTriangle[1]))
+				numberOfNewVertices++;
+		}
+
+		if ((unsigned int)vecNewVertices.size() - blockStart + numberOfNewVertices > MAX_BLOCK_VERTICES)
+		{
+			blockID++;
+			blockStart = (unsigned int)vecNewVertices.size();
+		}
+
+		for (unsigned int corner = 0; corner != 3; corner++)
+		{
+			unsigned int vertexIndex = pTriangle[corner];
+
+			if (vecBlockID[vertexIndex] != blockID)
+			{
+				vecBlockID[vertexIndex] = blockID;
+				vecNewIndex[vertexIndex] = (unsigned int)vecNewVertices.size();
+				vecNewVertices.push_back(drawInfo.pVertices[vertexIndex]);
+			}
+
+			pTriangle[corner] = vecNewIndex[vertexIndex];
+		}
+	};
+
+	unsigned int lod0End = (drawInfo.vecLODs.size() > 1) ? drawInfo.vecLODs[1].firstIndex : drawInfo.numberOfIndices;
+
+	for (unsigned int index = 0; index + 2 < lod0End; index += 3)
+		AddTriangleToBlock(&(drawInfo.pIndices[index]));
+
+	// Simplified levels : a triangle whose vertices all already sit in one block reuses
+	//	them. Those are grouped by block (keeping their order within it) so each group
+	//	becomes one sub mesh; the rest go into new blocks after them.
+	for (unsigned int lodIndex = 1; lodIndex < drawInfo.vecLODs.size(); lodIndex++)
+	{
+		unsigned int* pLODIndices = &(drawInfo.pIndices[drawInfo.vecLODs[lodIndex].firstIndex]);
+		unsigned int numberOfLODTriangles = drawInfo.vecLODs[lodIndex].numberOfIndices / 3;
+
+		std::vector<unsigned int> vecTriangleBlock(numberOfLODTriangles);
+		std::vector<unsigned int> vecTriangleOrder(numberOfLODTriangles);
+
+		for (unsigned int triangle = 0; triangle != numberOfLODTriangles; triangle++)
+		{
+			const unsigned int* pTriangle = &(pLODIndices[triangle * 3]);
+
+			unsigned int triangleBlock = vecBlockID[pTriangle[0]];
+
+			if (vecBlockID[pTriangle[1]] != triangleBlock || vecBlockID[pTriangle[2]] != triangleBlock)
+				triangleBlock = UINT_MAX;
+
+			vecTriangleBlock[triangle] = triangleBlock;
+			vecTriangleOrder[triangle] = triangle;
+		}
+
+		std::stable_sort(vecTriangleOrder.begin(), vecTriangleOrder.end(),
+			[&vecTriangleBlock](unsigned int first, unsigned int second) { return vecTriangleBlock[first] < vecTriangleBlock[second]; });
+
+		std::vector<unsigned int> vecSortedIndices(numberOfLODTriangles * 3);
+
+		for (unsigned int triangle = 0; triangle != numberOfLODTriangles; triangle++)
+		{
+			for (unsigned int corner = 0; corner != 3; corner++)
+				vecSortedIndices[triangle * 3 + corner] = pLODIndices[vecTriangleOrder[triangle] * 3 + corner];
+		}
+
+		std::copy(vecSortedIndices.begin(), vecSortedIndices.end(), pLODIndices);
+
+		blockID++;
+		blockStart = (unsigned int)vecNewVertices.size();
+
+		for (unsigned int triangle = 0; triangle != numberOfLODTriangles; triangle++)
+		{
+			unsigned int* pTriangle = &(pLODIndices[triangle * 3]);
+
+			if (vecTriangleBlock[vecTriangleOrder[triangle]] == UINT_MAX)
+			{
+				AddTriangleToBlock(pTriangle);
+				continue;
+			}
+
+			for (unsigned int corner = 0; corner != 3; corner++)
+				pTriangle[corner] = vecNewIndex[pTriangle[corner]];
+		}
+	}
+
+	delete[] drawInfo.pVertices;
+
+	drawInfo.numberOfVertices = (unsigned int)vecNewVertices.size();
+	drawInfo.pVertices = new sVertex[drawInfo.numberOfVertices];
+
+	std::copy(vecNewVertices.begin(), vecNewVertices.end(), drawInfo.pVertices);
+
+	return;
+}
+
+void cMeshOptimizer::Optimize(sModelDrawInfo& drawInfo)
+{
+	if (drawInfo.pIndices == NULL || drawInfo.pVertices == NULL || drawInfo.numberOfIndices < 3)
+		return;
+
+	drawInfo.cacheStatsBefore = cMeshOptimizer::CalcVertexCacheStats(drawInfo.pIndices, drawInfo.numberOfIndices, drawInfo.numberOfVertices);
+
+	cMeshOptimizer::OptimizeVertexCache(drawInfo.pIndices, drawInfo.numberOfIndices, drawInfo.numberOfVertices);
+
+	cMeshOptimizer::OptimizeOverdraw(drawInfo.pIndices, drawInfo.numberOfIndices, drawInfo.pVertices, drawInfo.numberOfVertices);
+
+	cMeshOptimizer::OptimizeVertexFetch(drawInfo.pIndices, drawInfo.numberOfIndices, drawInfo.pVertices, drawInfo.numberOfVertices);
+
+	drawInfo.cacheStatsAfter = cMeshOptimizer::CalcVertexCacheStats(drawInfo.pIndices, drawInfo.numberOfIndices, drawInfo.numberOfVertices);
+
+	drawInfo.bIsOptimized = true;
+
+	return;
+}
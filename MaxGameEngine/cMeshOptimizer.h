@@ -0,0 +1,46 @@
+#ifndef _cMeshOptimizer_HG_
+#define _cMeshOptimizer_HG_
+
+#include "sModelDrawInfo.h"
+
+// Load time reordering of a mesh's index and vertex arrays, run before the
+//	mesh is cooked so it only costs anything the first time.
+//	1. Triangle order for the post-transform vertex cache (Tom Forsyth's
+//	   "Linear-Speed Vertex Cache Optimisation")
+//	2. Clusters of that order sorted outside-in to cut overdraw (Sander, Nehab
+//	   and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+//	3. Vertices renumbered in the order they're first used (vertex fetch locality)
+class cMeshOptimizer
+{
+public:
+
+	// Size of the LRU cache the triangle order is tuned for
+	static const unsigned int OPTIMIZE_CACHE_SIZE = 32;
+
+	// FIFO cache simulated for the ACMR / ATVR numbers
+	static const unsigned int STATS_CACHE_SIZE = 32;
+
+	// A cluster is cut once its ACMR gets within this factor of the whole mesh's
+	static const float OVERDRAW_THRESHOLD;		// = 1.05f
+
+	// Fills cacheStatsBefore / cacheStatsAfter and sets bIsOptimized
+	static void Optimize(sModelDrawInfo& drawInfo);
+
+	static sVertexCacheStats CalcVertexCacheStats(const unsigned int* pIndices, unsigned int numberOfIndices,
+		unsigned int numberOfVertices, unsigned int cacheSize = STATS_CACHE_SIZE);
+
+	static void OptimizeVertexCache(unsigned int* pIndices, unsigned int numberOfIndices, unsigned int numberOfVertices);
+
+	static void OptimizeOverdraw(unsigned int* pIndices, unsigned int numberOfIndices, const sVertex* pVertices, unsigned int numberOfVertices);
+
+	// For meshes with more than 65536 vertices : regroups the vertices so the triangles,
+	//	taken in order, fall into runs that each use one contiguous block of at most
+	//	65536 vertices. Vertices shared between two runs are duplicated. This is what
+	//	lets cVertexFormat::PackIndices draw them as 16 bit sub meshes.
+	// Simplified LODs (vecLODs) reuse LOD 0's blocks where they can.
+	static void SplitFor16BitIndices(sModelDrawInfo& drawInfo);
+
+	static void OptimizeVertexFetch(unsigned int* pIndices, unsigned int numberOfIndices, sVertex* pVertices, unsigned int numberOfVertices);
+};
+
+#endif
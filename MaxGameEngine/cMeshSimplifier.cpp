@@ -0,0 +1,449 @@
+#include "cMeshSimplifier.h"
+#include "cMeshOptimizer.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+const float cMeshSimplifier::LOD_TRIANGLE_RATIO = 0.5f;
+const float cMeshSimplifier::MAX_LOD_ERROR = 0.05f;
+
+// A collapse is refused if it turns a neighbouring triangle's normal by more
+//	than about 75 degrees (cosine of the angle)
+static const float SIMPLIFY_MIN_NORMAL_DOT = 0.25f;
+
+// A level that only got rid of this few of the previous level's triangles isn't kept
+static const float SIMPLIFY_MIN_REDUCTION = 0.85f;
+
+//-------------------sQuadric-----------------
+
+cMeshSimplifier::sQuadric::sQuadric()
+{
+	this->a00 = this->a01 = this->a02 = this->a11 = this->a12 = this->a22 = 0.0;
+	this->b0 = this->b1 = this->b2 = 0.0;
+	this->c = 0.0;
+}
+
+void cMeshSimplifier::sQuadric::AddPlane(double a, double b, double c, double d)
+{
+	// Plane ax + by + cz + d = 0 with (a, b, c) normalized
+	this->a00 += a * a; this->a01 += a * b; this->a02 += a * c;
+	this->a11 += b * b; this->a12 += b * c;
+	this->a22 += c * c;
+
+	this->b0 += a * d; this->b1 += b * d; this->b2 += c * d;
+
+	this->c += d * d;
+
+	return;
+}
+
+void cMeshSimplifier::sQuadric::Add(const sQuadric& other)
+{
+	this->a00 += other.a00; this->a01 += other.a01; this->a02 += other.a02;
+	this->a11 += other.a11; this->a12 += other.a12;
+	this->a22 += other.a22;
+
+	this->b0 += other.b0; this->b1 += other.b1; this->b2 += other.b2;
+
+	this->c += other.c;
+
+	return;
+}
+
+double cMeshSimplifier::sQuadric::Evaluate(double x, double y, double z) const
+{
+	// v' A v + 2 b.v + c
+	double error = x * (this->a00 * x + this->a01 * y + this->a02 * z)
+		+ y * (this->a01 * x + this->a11 * y + this->a12 * z)
+		+ z * (this->a02 * x + this->a12 * y + this->a22 * z)
+		+ 2.0 * (this->b0 * x + this->b1 * y + this->b2 * z)
+		+ this->c;
+
+	return (error > 0.0) ? error : 0.0;
+}
+
+//-------------------cMeshSimplifier-----------------
+
+float cMeshSimplifier::Simplify(const sVertex* pVertices, unsigned int numberOfVertices,
+	std::vector<unsigned int>& vecIndices, unsigned int targetNumberOfIndices, float maxError)
+{
+	if (pVertices == NULL || numberOfVertices == 0 || vecIndices.size() <= targetNumberOfIndices)
+		return 0.0f;
+
+	//-----------------------------Vertices sharing a position---------------------------------
+
+	// vecPositionID[vertex] is the first vertex with the same position
+	std::vector<unsigned int> vecSortedVertices(numberOfVertices);
+
+	for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+		vecSortedVertices[vertexIndex] = vertexIndex;
+
+	std::sort(vecSortedVertices.begin(), vecSortedVertices.end(),
+		[pVertices](unsigned int first, unsigned int second)
+		{
+			if (pVertices[first].x != pVertices[second].x) return pVertices[first].x < pVertices[second].x;
+			if (pVertices[first].y != pVertices[second].y) return pVertices[first].y < pVertices[second].y;
+			if (pVertices[first].z != pVertices[second].z) return pVertices[first].z < pVertices[second].z;
+			return first < second;
+		});
+
+	std::vector<unsigned int> vecPositionID(numberOfVertices);
+
+	// Vertices that must stay where they are (seams and borders)
+	std::vector<char> vecIsLocked(numberOfVertices, 0);
+
+	for (unsigned int sortedIndex = 0; sortedIndex != numberOfVertices; )
+	{
+		unsigned int groupEnd = sortedIndex + 1;
+
+		const sVertex& groupVertex = pVertices[vecSortedVertices[sortedIndex]];
+
+		while (groupEnd != numberOfVertices &&
+			pVertices[vecSortedVertices[groupEnd]].x == groupVertex.x &&
+			pVertices[vecSortedVertices[groupEnd]].y == groupVertex.y &&
+			pVertices[vecSortedVertices[groupEnd]].z == groupVertex.z)
+			groupEnd++;
+
+		for (unsigned int groupIndex = sortedIndex; groupIndex != groupEnd; groupIndex++)
+		{
+			vecPositionID[vecSortedVertices[groupIndex]] = vecSortedVertices[sortedIndex];
+
+			if (groupEnd - sortedIndex > 1)
+				vecIsLocked[vecSortedVertices[groupIndex]] = 1;
+		}
+
+		sortedIndex = groupEnd;
+	}
+
+	//-----------------------------Border edges------------------------------------------------
+
+	// An edge (between positions) used by only one triangle is on a border
+	{
+		std::vector<unsigned long long> vecEdges;
+		vecEdges.reserve(vecIndices.size());
+
+		for (std::size_t index = 0; index + 2 < vecIndices.size(); index += 3)
+		{
+			for (unsigned int corner = 0; corner != 3; corner++)
+			{
+				unsigned int firstPosition = vecPositionID[vecIndices[index + corner]];
+				unsigned int secondPosition = vecPositionID[vecIndices[index + (corner + 1) % 3]];
+
+				if (firstPosition > secondPosition)
+					std::swap(firstPosition, secondPosition);
+
+				vecEdges.push_back(((unsigned long long)firstPosition << 32) | secondPosition);
+			}
+		}
+
+		std::sort(vecEdges.begin(), vecEdges.end());
+
+		for (std::size_t edgeIndex = 0; edgeIndex != vecEdges.size(); )
+		{
+			std::size_t runEnd = edgeIndex + 1;
+
+			while (runEnd != vecEdges.size() && vecEdges[runEnd] == vecEdges[edgeIndex])
+				runEnd++;
+
+			if (runEnd - edgeIndex == 1)
+			{
+				vecIsLocked[(unsigned int)(vecEdges[edgeIndex] >> 32)] = 1;
+				vecIsLocked[(unsigned int)(vecEdges[edgeIndex] & 0xFFFFFFFF)] = 1;
+			}
+
+			edgeIndex = runEnd;
+		}
+
+		// Spread the lock to the other vertices at the same position
+		for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+		{
+			if (vecIsLocked[vecPositionID[vertexIndex]])
+				vecIsLocked[vertexIndex] = 1;
+		}
+	}
+
+	//-----------------------------Quadrics (one per position)---------------------------------
+
+	std::vector<sQuadric> vecQuadrics(numberOfVertices);
+
+	for (std::size_t index = 0; index + 2 < vecIndices.size(); index += 3)
+	{
+		const sVertex& vertex0 = pVertices[vecIndices[index]];
+		const sVertex& vertex1 = pVertices[vecIndices[index + 1]];
+		const sVertex& vertex2 = pVertices[vecIndices[index + 2]];
+
+		glm::dvec3 position0(vertex0.x, vertex0.y, vertex0.z);
+
+		glm::dvec3 normal = glm::cross(glm::dvec3(vertex1.x, vertex1.y, vertex1.z) - position0,
+			glm::dvec3(vertex2.x, vertex2.y, vertex2.z) - position0);
+
+		double length = glm::length(normal);
+
+		if (length <= 0.0)
+			continue;
+
+		normal /= length;
+
+		for (unsigned int corner = 0; corner != 3; corner++)
+			vecQuadrics[vecPositionID[vecIndices[index + corner]]].AddPlane(normal.x, normal.y, normal.z, -glm::dot(normal, position0));
+	}
+
+	//-----------------------------Collapse passes---------------------------------------------
+
+	// Each pass sorts every possible collapse by cost and does the cheapest ones whose
+	//	neighbourhoods don't overlap, then the triangle list is rebuilt
+	double maxCost = (double)maxError * (double)maxError;
+	double errorReached = 0.0;
+
+	std::vector<sCollapse> vecCollapses;
+	std::vector<unsigned int> vecTriangleStart(numberOfVertices + 1);
+	std::vector<unsigned int> vecVertexTriangles;
+	std::vector<unsigned int> vecRemap(numberOfVertices);
+	std::vector<char> vecIsTouched(numberOfVertices);
+
+	while (vecIndices.size() > targetNumberOfIndices)
+	{
+		unsigned int numberOfTriangles = (unsigned int)(vecIndices.size() / 3);
+
+		//----------------Candidates----------------
+
+		vecCollapses.clear();
+
+		for (std::size_t index = 0; index + 2 < vecIndices.size(); index += 3)
+		{
+			for (unsigned int corner = 0; corner != 3; corner++)
+			{
+				unsigned int firstVertex = vecIndices[index + corner];
+				unsigned int secondVertex = vecIndices[index + (corner + 1) % 3];
+
+				// Each interior edge shows up in both of its triangles, once per direction is enough
+				if (firstVertex > secondVertex)
+					continue;
+
+				sQuadric edgeQuadric = vecQuadrics[vecPositionID[firstVertex]];
+				edgeQuadric.Add(vecQuadrics[vecPositionID[secondVertex]]);
+
+				sCollapse collapse;
+
+				if (!vecIsLocked[firstVertex])
+				{
+					collapse.fromVertex = firstVertex;
+					collapse.toVertex = secondVertex;
+					collapse.cost = edgeQuadric.Evaluate(pVertices[secondVertex].x, pVertices[secondVertex].y, pVertices[secondVertex].z);
+					vecCollapses.push_back(collapse);
+				}
+
+				if (!vecIsLocked[secondVertex])
+				{
+					collapse.fromVertex = secondVertex;
+					collapse.toVertex = firstVertex;
+					collapse.cost = edgeQuadric.Evaluate(pVertices[firstVertex].x, pVertices[firstVertex].y, pVertices[firstVertex].z);
+					vecCollapses.push_back(collapse);
+				}
+			}
+		}
+
+		if (vecCollapses.empty())
+			break;
+
+		std::sort(vecCollapses.begin(), vecCollapses.end(),
+			[](const sCollapse& first, const sCollapse& second) { return first.cost < second.cost; });
+
+		//----------------Triangles around each vertex----------------
+
+		std::fill(vecTriangleStart.begin(), vecTriangleStart.end(), 0);
+
+		for (std::size_t index = 0; index != vecIndices.size(); index++)
+			vecTriangleStart[vecIndices[index] + 1]++;
+
+		for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+			vecTriangleStart[vertexIndex + 1] += vecTriangleStart[vertexIndex];
+
+		vecVertexTriangles.resize(vecIndices.size());
+
+		{
+			std::vector<unsigned int> vecFillPosition(vecTriangleStart.begin(), vecTriangleStart.end() - 1);
+
+			for (std::size_t index = 0; index != vecIndices.size(); index++)
+				vecVertexTriangles[vecFillPosition[vecIndices[index]]++] = (unsigned int)(index / 3);
+		}
+
+		//----------------Pick and apply----------------
+
+		for (unsigned int vertexIndex = 0; vertexIndex != numberOfVertices; vertexIndex++)
+			vecRemap[vertexIndex] = vertexIndex;
+
+		std::fill(vecIsTouched.begin(), vecIsTouched.end(), 0);
+
+		unsigned int numberOfRemovedTriangles = 0;
+		unsigned int numberOfCollapses = 0;
+
+		for (std::size_t collapseIndex = 0; collapseIndex != vecCollapses.size(); collapseIndex++)
+		{
+			const sCollapse& collapse = vecCollapses[collapseIndex];
+
+			if (collapse.cost > maxCost)
+				break;
+
+			if ((numberOfTriangles - numberOfRemovedTriangles) * 3 <= targetNumberOfIndices)
+				break;
+
+			if (vecIsTouched[collapse.fromVertex] || vecIsTouched[collapse.toVertex])
+				continue;
+
+			glm::vec3 fromPosition(pVertices[collapse.fromVertex].x, pVertices[collapse.fromVertex].y, pVertices[collapse.fromVertex].z);
+			glm::vec3 toPosition(pVertices[collapse.toVertex].x, pVertices[collapse.toVertex].y, pVertices[collapse.toVertex].z);
+
+			unsigned int toPositionID = vecPositionID[collapse.toVertex];
+
+			// The triangles around fromVertex that survive mustn't flip or fold over
+			bool bIsValid = true;
+			unsigned int numberOfCollapsingTriangles = 0;
+
+			for (unsigned int adjacent = vecTriangleStart[collapse.fromVertex]; adjacent != vecTriangleStart[collapse.fromVertex + 1]; adjacent++)
+			{
+				const unsigned int* pTriangle = &(vecIndices[vecVertexTriangles[adjacent] * 3]);
+
+				if (vecPositionID[pTriangle[0]] == toPositionID || vecPositionID[pTriangle[1]] == toPositionID || vecPositionID[pTriangle[2]] == toPositionID)
+				{
+					numberOfCollapsingTriangles++;
+					continue;
+				}
+
+				glm::vec3 corners[3];
+				glm::vec3 movedCorners[3];
+
+				for (unsigned int corner = 0; corner != 3; corner++)
+				{
+					corners[corner] = glm::vec3(pVertices[pTriangle[corner]].x, pVertices[pTriangle[corner]].y, pVertices[pTriangle[corner]].z);
+					movedCorners[corner] = (pTriangle[corner] == collapse.fromVertex) ? toPosition : corners[corner];
+				}
+
+				glm::vec3 normalBefore = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				glm::vec3 normalAfter = glm::cross(movedCorners[1] - movedCorners[0], movedCorners[2] - movedCorners[0]);
+
+				float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+
+				if (lengths <= 0.0f || glm::dot(normalBefore, normalAfter) < SIMPLIFY_MIN_NORMAL_DOT * lengths)
+				{
+					bIsValid = false;
+					break;
+				}
+			}
+
+			if (!bIsValid)
+				continue;
+
+			// Nothing around this collapse moves again in this pass
+			for (unsigned int adjacent = vecTriangleStart[collapse.fromVertex]; adjacent != vecTriangleStart[collapse.fromVertex + 1]; adjacent++)
+			{
+				const unsigned int* pTriangle = &(vecIndices[vecVertexTriangles[adjacent] * 3]);
+
+				vecIsTouched[pTriangle[0]] = 1;
+				vecIsTouched[pTriangle[1]] = 1;
+				vecIsTouched[pTriangle[2]] = 1;
+			}
+
+			vecRemap[collapse.fromVertex] = collapse.toVertex;
+
+			vecQuadrics[toPositionID].Add(vecQuadrics[vecPositionID[collapse.fromVertex]]);
+
+			errorReached = std::max(errorReached, collapse.cost);
+
+			numberOfRemovedTriangles += numberOfCollapsingTriangles;
+			numberOfCollapses++;
+		}
+
+		if (numberOfCollapses == 0)
+			break;
+
+		//----------------Rebuild the triangle list----------------
+
+		std::size_t newSize = 0;
+
+		for (std::size_t index = 0; index + 2 < vecIndices.size(); index += 3)
+		{
+			unsigned int vertex0 = vecRemap[vecIndices[index]];
+			unsigned int vertex1 = vecRemap[vecIndices[index + 1]];
+			unsigned int vertex2 = vecRemap[vecIndices[index + 2]];
+
+			if (vecPositionID[vertex0] == vecPositionID[vertex1] || vecPositionID[vertex1] == vecPositionID[vertex2] ||
+				vecPositionID[vertex2] == vecPositionID[vertex0])
+				continue;
+
+			vecIndices[newSize++] = vertex0;
+			vecIndices[newSize++] = vertex1;
+			vecIndices[newSize++] = vertex2;
+		}
+
+		vecIndices.resize(newSize);
+	}
+
+	return (float)sqrt(errorReached);
+}
+
+void cMeshSimplifier::BuildLODChain(sModelDrawInfo& drawInfo)
+{
+	drawInfo.vecLODs.clear();
+
+	if (drawInfo.pIndices == NULL || drawInfo.pVertices == NULL || drawInfo.numberOfIndices / 3 < MIN_LOD_TRIANGLES * 2)
+		return;
+
+	sMeshLOD lod;
+	lod.firstIndex = 0;
+	lod.numberOfIndices = drawInfo.numberOfIndices;
+	lod.error = 0.0f;
+	lod.firstSubMesh = 0;
+	lod.numberOfSubMeshes = 0;
+
+	std::vector<sMeshLOD> vecLODs;
+	vecLODs.push_back(lod);
+
+	std::vector<unsigned int> vecAllIndices(drawInfo.pIndices, drawInfo.pIndices + drawInfo.numberOfIndices);
+	std::vector<unsigned int> vecLevelIndices(vecAllIndices);
+
+	float maxError = MAX_LOD_ERROR * drawInfo.maxExtent;
+
+	// Each level starts from the one before (cheaper, and the levels stay nested)
+	for (unsigned int level = 1; level != MAX_LODS; level++)
+	{
+		std::size_t previousSize = vecLevelIndices.size();
+
+		unsigned int targetNumberOfIndices = (unsigned int)(previousSize / 3 * LOD_TRIANGLE_RATIO) * 3;
+
+		if (targetNumberOfIndices / 3 < MIN_LOD_TRIANGLES)
+			break;
+
+		float levelError = cMeshSimplifier::Simplify(drawInfo.pVertices, drawInfo.numberOfVertices, vecLevelIndices, targetNumberOfIndices, maxError);
+
+		if (vecLevelIndices.size() > previousSize * SIMPLIFY_MIN_REDUCTION || vecLevelIndices.size() / 3 < MIN_LOD_TRIANGLES)
+			break;
+
+		cMeshOptimizer::OptimizeVertexCache(vecLevelIndices.data(), (unsigned int)vecLevelIndices.size(), drawInfo.numberOfVertices);
+
+		lod.firstIndex = (unsigned int)vecAllIndices.size();
+		lod.numberOfIndices = (unsigned int)vecLevelIndices.size();
+		lod.error = vecLODs.back().error + levelError;
+
+		vecLODs.push_back(lod);
+
+		vecAllIndices.insert(vecAllIndices.end(), vecLevelIndices.begin(), vecLevelIndices.end());
+	}
+
+	if (vecLODs.size() == 1)
+		return;
+
+	delete[] drawInfo.pIndices;
+
+	drawInfo.numberOfIndices = (unsigned int)vecAllIndices.size();
+	drawInfo.pIndices = new unsigned int[drawInfo.numberOfIndices];
+
+	std::copy(vecAllIndices.begin(), vecAllIndices.end(), drawInfo.pIndices);
+
+	drawInfo.vecLODs = vecLODs;
+
+	return;
+}
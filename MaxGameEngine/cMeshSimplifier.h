@@ -0,0 +1,66 @@
+#ifndef _cMeshSimplifier_HG_
+#define _cMeshSimplifier_HG_
+
+#include <vector>
+
+#include "sModelDrawInfo.h"
+
+// Builds the levels of detail of a mesh at load time, before it's cooked.
+// Each level is made by quadric error edge collapse (Garland and Heckbert,
+//	"Surface Simplification Using Quadric Error Metrics"), collapsing a vertex
+//	onto one of its neighbours so only the index list changes and every level
+//	can share the vertex buffer.
+// Vertices on a border or a seam (same position, different normal / colour)
+//	are never moved, so levels keep their outline and don't tear.
+class cMeshSimplifier
+{
+public:
+
+	// LOD 0 (the mesh itself) plus up to 3 simplified levels
+	static const unsigned int MAX_LODS = 4;
+
+	// No level is made with fewer triangles than this
+	static const unsigned int MIN_LOD_TRIANGLES = 32;
+
+	// Each level aims for this fraction of the previous one's triangles
+	static const float LOD_TRIANGLE_RATIO;		// = 0.5f
+
+	// Collapses stop once the error would pass this fraction of maxExtent
+	static const float MAX_LOD_ERROR;			// = 0.05f
+
+	// Appends the simplified levels to pIndices and fills vecLODs.
+	//	Needs maxExtent (calcExtents), leaves the vertices alone.
+	static void BuildLODChain(sModelDrawInfo& drawInfo);
+
+	// Collapses edges of vecIndices until it's down to targetNumberOfIndices or the next
+	//	collapse would cost more than maxError. Returns the error reached (model units).
+	static float Simplify(const sVertex* pVertices, unsigned int numberOfVertices,
+		std::vector<unsigned int>& vecIndices, unsigned int targetNumberOfIndices, float maxError);
+
+private:
+
+	// Symmetric 4x4 matrix of the summed squared distances to a set of planes
+	struct sQuadric
+	{
+		sQuadric();
+
+		void AddPlane(double a, double b, double c, double d);
+
+		void Add(const sQuadric& other);
+
+		double Evaluate(double x, double y, double z) const;
+
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+	};
+
+	struct sCollapse
+	{
+		unsigned int fromVertex;
+		unsigned int toVertex;
+		double cost;
+	};
+};
+
+#endif
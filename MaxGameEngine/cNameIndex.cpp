@@ -0,0 +1,150 @@
+#include "cNameIndex.h"
+
+cNameIndex::cNameIndex()
+{
+	this->m_numberOfNames = 0;
+}
+
+unsigned int cNameIndex::m_Hash(const std::string& name)
+{
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+
+	for (std::size_t index = 0; index != name.size(); index++)
+	{
+		hash ^= (unsigned char)name[index];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+unsigned int cNameIndex::m_FindSlot(const std::string& name, unsigned int hash) const
+{
+	if (this->m_vecEntries.empty())
+		return NOT_FOUND;
+
+	unsigned int mask = (unsigned int)this->m_vecEntries.size() - 1;
+
+	// There's always an empty entry to stop at (at most half full)
+	for (unsigned int slot = hash & mask; ; slot = (slot + 1) & mask)
+	{
+		const sEntry& theEntry = this->m_vecEntries[slot];
+
+		if (theEntry.handle == NOT_FOUND)
+			return NOT_FOUND;
+
+		if (theEntry.hash == hash && theEntry.name == name)
+			return slot;
+	}
+}
+
+bool cNameIndex::Insert(const std::string& name, unsigned int handle)
+{
+	unsigned int hash = m_Hash(name);
+
+	if (this->m_FindSlot(name, hash) != NOT_FOUND)
+		return false;
+
+	if ((this->m_numberOfNames + 1) * 2 > this->m_vecEntries.size())
+		this->m_Grow();
+
+	unsigned int mask = (unsigned int)this->m_vecEntries.size() - 1;
+	unsigned int slot = hash & mask;
+
+	while (this->m_vecEntries[slot].handle != NOT_FOUND)
+		slot = (slot + 1) & mask;
+
+	this->m_vecEntries[slot].hash = hash;
+	this->m_vecEntries[slot].handle = handle;
+	this->m_vecEntries[slot].name = name;
+
+	this->m_numberOfNames++;
+
+	return true;
+}
+
+unsigned int cNameIndex::Find(const std::string& name) const
+{
+	unsigned int slot = this->m_FindSlot(name, m_Hash(name));
+
+	if (slot == NOT_FOUND)
+		return NOT_FOUND;
+
+	return this->m_vecEntries[slot].handle;
+}
+
+bool cNameIndex::Erase(const std::string& name)
+{
+	unsigned int slot = this->m_FindSlot(name, m_Hash(name));
+
+	if (slot == NOT_FOUND)
+		return false;
+
+	unsigned int mask = (unsigned int)this->m_vecEntries.size() - 1;
+
+	// Move back every entry after the hole that would otherwise not be reached from its home
+	//	slot anymore, until an empty entry
+	unsigned int hole = slot;
+
+	for (unsigned int next = (hole + 1) & mask; this->m_vecEntries[next].handle != NOT_FOUND; next = (next + 1) & mask)
+	{
+		unsigned int home = this->m_vecEntries[next].hash & mask;
+
+		// Whether home lies cyclically in (hole, next]
+		bool bHomeAfterHole = (next > hole) ? (home > hole && home <= next) : (home > hole || home <= next);
+
+		if (bHomeAfterHole)
+			continue;
+
+		this->m_vecEntries[hole] = std::move(this->m_vecEntries[next]);
+		hole = next;
+	}
+
+	this->m_vecEntries[hole].hash = 0;
+	this->m_vecEntries[hole].handle = NOT_FOUND;
+	this->m_vecEntries[hole].name.clear();
+
+	this->m_numberOfNames--;
+
+	return true;
+}
+
+void cNameIndex::Clear(void)
+{
+	this->m_vecEntries.clear();
+	this->m_numberOfNames = 0;
+}
+
+unsigned int cNameIndex::getNumberOfNames(void) const
+{
+	return this->m_numberOfNames;
+}
+
+void cNameIndex::m_Grow(void)
+{
+	std::vector< sEntry > vecOldEntries;
+
+	vecOldEntries.swap(this->m_vecEntries);
+
+	std::size_t newCapacity = vecOldEntries.empty() ? MIN_CAPACITY : vecOldEntries.size() * 2;
+
+	this->m_vecEntries.resize(newCapacity);
+
+	unsigned int mask = (unsigned int)newCapacity - 1;
+
+	for (std::size_t index = 0; index != vecOldEntries.size(); index++)
+	{
+		if (vecOldEntries[index].handle == NOT_FOUND)
+			continue;
+
+		unsigned int slot = vecOldEntries[index].hash & mask;
+
+		while (this->m_vecEntries[slot].handle != NOT_FOUND)
+			slot = (slot + 1) & mask;
+
+		this->m_vecEntries[slot] = std::move(vecOldEntries[index]);
+	}
+
+	return;
+}
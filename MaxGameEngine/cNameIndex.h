@@ -0,0 +1,55 @@
+#ifndef _cNameIndex_HG_
+#define _cNameIndex_HG_
+
+#include <string>
+#include <vector>
+
+// Name -> handle lookups. Open addressing with linear probing in one flat array, the
+//	table kept at most half full. Each entry keeps its name's hash, so a probe only
+//	compares strings when the hashes match.
+// Erase shifts the entries after it back instead of leaving tombstones, so lookups
+//	don't slow down as names come and go.
+class cNameIndex
+{
+public:
+
+	static const unsigned int NOT_FOUND = ~0u;
+
+	cNameIndex();
+
+	// False if the name is already in (its handle is left as it was)
+	bool Insert(const std::string& name, unsigned int handle);
+
+	// NOT_FOUND if the name isn't in
+	unsigned int Find(const std::string& name) const;
+
+	bool Erase(const std::string& name);
+
+	void Clear(void);
+
+	unsigned int getNumberOfNames(void) const;
+
+private:
+
+	struct sEntry
+	{
+		unsigned int hash = 0;
+		unsigned int handle = NOT_FOUND;		// NOT_FOUND = empty
+		std::string name;
+	};
+
+	static const unsigned int MIN_CAPACITY = 16;
+
+	// Power of two
+	std::vector< sEntry > m_vecEntries;
+	unsigned int m_numberOfNames;
+
+	static unsigned int m_Hash(const std::string& name);
+
+	// Slot holding the name, or NOT_FOUND
+	unsigned int m_FindSlot(const std::string& name, unsigned int hash) const;
+
+	void m_Grow(void);
+};
+
+#endif
@@ -80,7 +80,15 @@ bool cPhysics::CheckForPlaneCollision(sModelDrawInfo* drawInfo, cMesh* groundMes
 
 	/*if (checkMesh->FindDrawInfoByModelName(filename, *drawInfo))
 	{*/
-		for (unsigned int index = 0; index < drawInfo->numberOfIndices; index += 3)
+		// Full detail only (the simplified LODs follow it in pIndices)
+		unsigned int numberOfIndices = drawInfo->getLOD(0).numberOfIndices;
+
+		//----------------Convert to world space------------------------------
+
+		// Parents included (the caller brings it up to date)
+		const glm::mat4& matModel = groundMesh->getWorldMatrix();
+
+		for (unsigned int index = 0; index < numberOfIndices; index += 3)
 		{
 			//---------------Calculate vertex position-----------------------------
 
@@ -102,40 +110,6 @@ bool cPhysics::CheckForPlaneCollision(sModelDrawInfo* drawInfo, cMesh* groundMes
 			verts[2].y = drawInfo->pVertices[triangleIndex_2].y;
 			verts[2].z = drawInfo->pVertices[triangleIndex_2].z;
 
-			//----------------Convert to world space------------------------------
-
-			glm::mat4 matModel = glm::mat4(1.0f);
-
-			glm::mat4 matTranslate = glm::translate(glm::mat4(1.0f),
-				glm::vec3(groundMesh->drawPosition.x,
-					groundMesh->drawPosition.y,
-					groundMesh->drawPosition.z));
-
-			glm::mat4 matRotateX = glm::rotate(glm::mat4(1.0f),
-				groundMesh->drawOrientation.x,
-				glm::vec3(1.0f, 0.0, 0.0f));
-
-			glm::mat4 matRotateY = glm::rotate(glm::mat4(1.0f),
-				groundMesh->drawOrientation.y,
-				glm::vec3(0.0f, 1.0, 0.0f));
-
-			glm::mat4 matRotateZ = glm::rotate(glm::mat4(1.0f),
-				groundMesh->drawOrientation.z,
-				glm::vec3(0.0f, 0.0, 1.0f));
-
-			glm::mat4 matScale = glm::scale(glm::mat4(1.0f),
-				glm::vec3(groundMesh->drawScale.x,
-					groundMesh->drawScale.y,
-					groundMesh->drawScale.z));
-
-			matModel = matModel * matTranslate;
-
-			matModel = matModel * matRotateX;
-			matModel = matModel * matRotateY;
-			matModel = matModel * matRotateZ;
-
-			matModel = matModel * matScale;
-
 			glm::vec4 vertsWorld[3];
 
 			vertsWorld[0] = (matModel * glm::vec4(verts[0], 1.0f));
@@ -0,0 +1,1139 @@
+#include "cPlyFileReader.h"
+
+#include <charconv>
+#include <cstring>
+#include <cmath>
+#include <sstream>
+
+cPlyFileReader::sProperty::sProperty()
+{
+	this->type = TYPE_UNKNOWN;
+	this->bIsList = false;
+	this->listCountType = TYPE_UNKNOWN;
+}
+
+cPlyFileReader::sElement::sElement()
+{
+	this->count = 0;
+}
+
+cPlyFileReader::cPlyFileReader()
+{
+	this->m_pFileData = NULL;
+	this->m_fileSize = 0;
+	this->m_dataOffset = 0;
+	this->m_format = FORMAT_UNKNOWN;
+	this->m_bSwapBytes = false;
+}
+
+cPlyFileReader::eFormat cPlyFileReader::getFormat(void) const
+{
+	return this->m_format;
+}
+
+const std::vector<cPlyFileReader::sElement>& cPlyFileReader::getElements(void) const
+{
+	return this->m_vecElements;
+}
+
+std::string cPlyFileReader::getLastError(void) const
+{
+	return this->m_lastError;
+}
+
+//static
+cPlyFileReader::ePropertyType cPlyFileReader::TypeFromName(const std::string& typeName)
+{
+	// Both the original and the sized names are allowed by the PLY spec
+	if (typeName == "char" || typeName == "int8")		return TYPE_CHAR;
+	if (typeName == "uchar" || typeName == "uint8")		return TYPE_UCHAR;
+	if (typeName == "short" || typeName == "int16")		return TYPE_SHORT;
+	if (typeName == "ushort" || typeName == "uint16")	return TYPE_USHORT;
+	if (typeName == "int" || typeName == "int32")		return TYPE_INT;
+	if (typeName == "uint" || typeName == "uint32")		return TYPE_UINT;
+	if (typeName == "float" || typeName == "float32")	return TYPE_FLOAT;
+	if (typeName == "double" || typeName == "float64")	return TYPE_DOUBLE;
+
+	return TYPE_UNKNOWN;
+}
+
+//static
+unsigned int cPlyFileReader::SizeOfType(ePropertyType type)
+{
+	switch (type)
+	{
+	case TYPE_CHAR:
+	case TYPE_UCHAR:
+		return 1;
+	case TYPE_SHORT:
+	case TYPE_USHORT:
+		return 2;
+	case TYPE_INT:
+	case TYPE_UINT:
+	case TYPE_FLOAT:
+		return 4;
+	case TYPE_DOUBLE:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+//-------------------------------------------------Header-----------------------------------------------------------------------
+
+bool cPlyFileReader::ParseHeader(const unsigned char* pFileData, std::size_t fileSize)
+{
+	this->m_pFileData = pFileData;
+	this->m_fileSize = fileSize;
+	this->m_dataOffset = 0;
+	this->m_format = FORMAT_UNKNOWN;
+	this->m_vecElements.clear();
+
+	const char* pText = reinterpret_cast<const char*>(pFileData);
+
+	std::size_t position = 0;
+	bool bFoundMagic = false;
+
+	while (position < fileSize)
+	{
+		//--------------------Pull out the next header line------------------------------------
+
+		std::size_t lineEnd = position;
+
+		while (lineEnd < fileSize && pText[lineEnd] != '\n')
+			lineEnd++;
+
+		std::string line(pText + position, lineEnd - position);
+
+		if (!line.empty() && line[line.size() - 1] == '\r')
+			line.erase(line.size() - 1);
+
+		position = (lineEnd < fileSize) ? lineEnd + 1 : fileSize;
+
+		std::stringstream ssLine(line);
+		std::string keyword;
+
+		ssLine >> keyword;
+
+		//--------------------Interpret the line-----------------------------------------------
+
+		if (!bFoundMagic)
+		{
+			if (keyword != "ply")
+			{
+				this->m_lastError = "missing 'ply' magic number";
+				return false;
+			}
+
+			bFoundMagic = true;
+		}
+		else if (keyword == "format")
+		{
+			std::string formatName;
+			ssLine >> formatName;
+
+			if (formatName == "ascii")
+				this->m_format = FORMAT_ASCII;
+			else if (formatName == "binary_little_endian")
+				this->m_format = FORMAT_BINARY_LITTLE_ENDIAN;
+			else if (formatName == "binary_big_endian")
+				this->m_format = FORMAT_BINARY_BIG_ENDIAN;
+		}
+		else if (keyword == "element")
+		{
+			sElement newElement;
+			ssLine >> newElement.name >> newElement.count;
+
+			this->m_vecElements.push_back(newElement);
+		}
+		else if (keyword == "property")
+		{
+			if (this->m_vecElements.empty())
+			{
+				this->m_lastError = "property declared before any element";
+				return false;
+			}
+
+			sProperty newProperty;
+			std::string typeName;
+
+			ssLine >> typeName;
+
+			if (typeName == "list")
+			{
+				std::string countTypeName;
+				ssLine >> countTypeName >> typeName;
+
+				newProperty.bIsList = true;
+				newProperty.listCountType = cPlyFileReader::TypeFromName(countTypeName);
+			}
+
+			newProperty.type = cPlyFileReader::TypeFromName(typeName);
+			ssLine >> newProperty.name;
+
+			if (newProperty.type == TYPE_UNKNOWN || (newProperty.bIsList && newProperty.listCountType == TYPE_UNKNOWN))
+			{
+				this->m_lastError = "unknown type on property '" + newProperty.name + "'";
+				return false;
+			}
+
+			this->m_vecElements.back().properties.push_back(newProperty);
+		}
+		else if (keyword == "end_header")
+		{
+			this->m_dataOffset = position;
+			break;
+		}
+		// "comment" and "obj_info" lines are ignored
+	}
+
+	if (this->m_dataOffset == 0)
+	{
+		this->m_lastError = "no 'end_header' found";
+		return false;
+	}
+
+	if (this->m_format == FORMAT_UNKNOWN)
+	{
+		this->m_lastError = "unknown format";
+		return false;
+	}
+
+	const unsigned int testValue = 1;
+	unsigned char firstByte = 0;
+	memcpy(&firstByte, &testValue, 1);
+
+	const bool bHostIsLittleEndian = (firstByte == 1);
+
+	this->m_bSwapBytes = (this->m_format == FORMAT_BINARY_LITTLE_ENDIAN && !bHostIsLittleEndian) ||
+		(this->m_format == FORMAT_BINARY_BIG_ENDIAN && bHostIsLittleEndian);
+
+	return true;
+}
+
+//-------------------------------------------------Values-----------------------------------------------------------------------
+
+// Written as masks and shifts so the compiler turns each one into a single bswap
+static inline unsigned char ByteSwap(unsigned char value)
+{
+	return value;
+}
+
+static inline unsigned short ByteSwap(unsigned short value)
+{
+	return (unsigned short)(((value & 0x00FFu) << 8) | ((value & 0xFF00u) >> 8));
+}
+
+static inline unsigned int ByteSwap(unsigned int value)
+{
+	return ((value & 0x000000FFu) << 24) |
+		((value & 0x0000FF00u) << 8) |
+		((value & 0x00FF0000u) >> 8) |
+		((value & 0xFF000000u) >> 24);
+}
+
+static inline unsigned long long ByteSwap(unsigned long long value)
+{
+	return ((unsigned long long)ByteSwap((unsigned int)(value & 0xFFFFFFFFull)) << 32) |
+		(unsigned long long)ByteSwap((unsigned int)(value >> 32));
+}
+
+// Unsigned integer the same size as a PLY type
+template <unsigned int SIZE> struct sUnsignedOfSize;
+template <> struct sUnsignedOfSize<1> { typedef unsigned char type; };
+template <> struct sUnsignedOfSize<2> { typedef unsigned short type; };
+template <> struct sUnsignedOfSize<4> { typedef unsigned int type; };
+template <> struct sUnsignedOfSize<8> { typedef unsigned long long type; };
+
+// One binary value of type T, byte swapped if the file's byte order isn't the host's
+template <typename T, bool bSwapBytes>
+static T LoadBinaryValue(const unsigned char* pSource)
+{
+	typename sUnsignedOfSize<sizeof(T)>::type bits;
+	memcpy(&bits, pSource, sizeof(T));
+
+	if (bSwapBytes)
+		bits = ByteSwap(bits);
+
+	T value;
+	memcpy(&value, &bits, sizeof(T));
+
+	return value;
+}
+
+template <typename T, bool bSwapBytes>
+static float ReadBinaryFloat(const unsigned char* pSource)
+{
+	return (float)LoadBinaryValue<T, bSwapBytes>(pSource);
+}
+
+template <typename T, bool bSwapBytes>
+static long long ReadBinaryInteger(const unsigned char* pSource)
+{
+	return (long long)LoadBinaryValue<T, bSwapBytes>(pSource);
+}
+
+template <typename T>
+static void SetBinaryReader(bool bSwapBytes, unsigned int& size, float (*&pReadFloat)(const unsigned char*), long long (*&pReadInteger)(const unsigned char*))
+{
+	size = sizeof(T);
+
+	pReadFloat = bSwapBytes ? &ReadBinaryFloat<T, true> : &ReadBinaryFloat<T, false>;
+	pReadInteger = bSwapBytes ? &ReadBinaryInteger<T, true> : &ReadBinaryInteger<T, false>;
+}
+
+cPlyFileReader::sBinaryReader cPlyFileReader::m_GetBinaryReader(ePropertyType type) const
+{
+	sBinaryReader theReader;
+
+	theReader.size = 0;
+	theReader.pReadFloat = NULL;
+	theReader.pReadInteger = NULL;
+
+	switch (type)
+	{
+	case TYPE_CHAR:		SetBinaryReader<signed char>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);		break;
+	case TYPE_UCHAR:	SetBinaryReader<unsigned char>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);	break;
+	case TYPE_SHORT:	SetBinaryReader<short>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);			break;
+	case TYPE_USHORT:	SetBinaryReader<unsigned short>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);	break;
+	case TYPE_INT:		SetBinaryReader<int>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);				break;
+	case TYPE_UINT:		SetBinaryReader<unsigned int>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);	break;
+	case TYPE_FLOAT:	SetBinaryReader<float>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);			break;
+	case TYPE_DOUBLE:	SetBinaryReader<double>(this->m_bSwapBytes, theReader.size, theReader.pReadFloat, theReader.pReadInteger);			break;
+	default:
+		break;
+	}
+
+	return theReader;
+}
+
+std::size_t cPlyFileReader::m_MinimumRecordSize(const sElement& element) const
+{
+	std::size_t recordSize = 0;
+
+	for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+	{
+		const sProperty& property = element.properties[propIndex];
+
+		// At least one character per value in an ascii file
+		if (this->m_format == FORMAT_ASCII)
+			recordSize += 1;
+		else
+			recordSize += cPlyFileReader::SizeOfType(property.bIsList ? property.listCountType : property.type);
+	}
+
+	return recordSize;
+}
+
+bool cPlyFileReader::m_ReadAsciiValue(sCursor& cursor, ePropertyType type, double& value)
+{
+	const char* pCurrent = reinterpret_cast<const char*>(cursor.pCurrent);
+	const char* pEnd = reinterpret_cast<const char*>(cursor.pEnd);
+
+	while (pCurrent != pEnd && (*pCurrent == ' ' || *pCurrent == '\t' || *pCurrent == '\r' || *pCurrent == '\n'))
+		pCurrent++;
+
+	if (pCurrent != pEnd && *pCurrent == '+')
+		pCurrent++;
+
+	if (pCurrent == pEnd)
+		return false;
+
+	if (type == TYPE_FLOAT)
+	{
+		float floatValue = 0.0f;
+		std::from_chars_result result = std::from_chars(pCurrent, pEnd, floatValue);
+
+		if (result.ec != std::errc())
+			return false;
+
+		value = floatValue;
+		pCurrent = result.ptr;
+	}
+	else
+	{
+		long long intValue = 0;
+		std::from_chars_result result = std::from_chars(pCurrent, pEnd, intValue);
+
+		// Doubles, or integers written as "255.0" by some exporters
+		if (type == TYPE_DOUBLE || result.ec != std::errc() ||
+			(result.ptr != pEnd && (*result.ptr == '.' || *result.ptr == 'e' || *result.ptr == 'E')))
+		{
+			result = std::from_chars(pCurrent, pEnd, value);
+
+			if (result.ec != std::errc())
+				return false;
+		}
+		else
+		{
+			value = (double)intValue;
+		}
+
+		pCurrent = result.ptr;
+	}
+
+	cursor.pCurrent = reinterpret_cast<const unsigned char*>(pCurrent);
+
+	return true;
+}
+
+bool cPlyFileReader::m_IsListCountValid(const sElement& element, double count)
+{
+	if (count < 0.0)
+	{
+		this->m_lastError = "'" + element.name + "' element has a list with a negative count";
+		return false;
+	}
+
+	// Couldn't fit in the file anyway (and wouldn't fit an unsigned int)
+	if (count > 4294967295.0)
+	{
+		this->m_lastError = "'" + element.name + "' element has a list longer than the file";
+		return false;
+	}
+
+	return true;
+}
+
+bool cPlyFileReader::m_SkipElement(sCursor& cursor, const sElement& element)
+{
+	//--------------------Ascii : value by value-----------------------------------------------
+
+	if (this->m_format == FORMAT_ASCII)
+	{
+		double discard = 0.0;
+
+		for (unsigned int index = 0; index != element.count; index++)
+		{
+			for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+			{
+				const sProperty& property = element.properties[propIndex];
+
+				unsigned int numberOfValues = 1;
+
+				if (property.bIsList)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.listCountType, discard))
+						return false;
+
+					if (!this->m_IsListCountValid(element, discard))
+						return false;
+
+					numberOfValues = (unsigned int)discard;
+				}
+
+				for (unsigned int valueIndex = 0; valueIndex != numberOfValues; valueIndex++)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.type, discard))
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//--------------------Binary : only the list counts are read-------------------------------
+
+	bool bHasLists = false;
+
+	for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+		bHasLists = bHasLists || element.properties[propIndex].bIsList;
+
+	// Every record is the same size (already checked against the file size)
+	if (!bHasLists)
+	{
+		cursor.pCurrent += (std::size_t)element.count * this->m_MinimumRecordSize(element);
+		return true;
+	}
+
+	for (unsigned int index = 0; index != element.count; index++)
+	{
+		for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+		{
+			const sProperty& property = element.properties[propIndex];
+
+			std::size_t numberOfBytes = cPlyFileReader::SizeOfType(property.type);
+
+			if (property.bIsList)
+			{
+				sBinaryReader countReader = this->m_GetBinaryReader(property.listCountType);
+
+				if ((std::size_t)(cursor.pEnd - cursor.pCurrent) < countReader.size)
+					return false;
+
+				long long numberOfValues = countReader.pReadInteger(cursor.pCurrent);
+				cursor.pCurrent += countReader.size;
+
+				if (!this->m_IsListCountValid(element, (double)numberOfValues))
+					return false;
+
+				numberOfBytes *= (std::size_t)numberOfValues;
+			}
+
+			if ((std::size_t)(cursor.pEnd - cursor.pCurrent) < numberOfBytes)
+				return false;
+
+			cursor.pCurrent += numberOfBytes;
+		}
+	}
+
+	return true;
+}
+
+//-------------------------------------------------Mesh-----------------------------------------------------------------------
+
+bool cPlyFileReader::m_IsEngineVertexLayout(const sElement& element) const
+{
+	static const char* const LAYOUT_NAMES[] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue", "alpha" };
+	static const unsigned int NUMBER_OF_LAYOUT_PROPERTIES = 10;
+
+	if (this->m_format == FORMAT_ASCII || element.properties.size() != NUMBER_OF_LAYOUT_PROPERTIES)
+		return false;
+
+	for (unsigned int propIndex = 0; propIndex != NUMBER_OF_LAYOUT_PROPERTIES; propIndex++)
+	{
+		const sProperty& property = element.properties[propIndex];
+
+		ePropertyType layoutType = (propIndex < 6) ? TYPE_FLOAT : TYPE_UCHAR;
+
+		if (property.bIsList || property.type != layoutType || property.name != LAYOUT_NAMES[propIndex])
+			return false;
+	}
+
+	return true;
+}
+
+void cPlyFileReader::m_DecodeEngineVertexLayout(sCursor& cursor, sModelDrawInfo& drawInfo)
+{
+	const unsigned int RECORD_SIZE = 6 * sizeof(float) + 4;
+
+	const unsigned char* pSource = cursor.pCurrent;
+
+	for (unsigned int vertIndex = 0; vertIndex != drawInfo.numberOfVertices; vertIndex++)
+	{
+		sVertex& vertex = drawInfo.pVertices[vertIndex];
+
+		float floats[6];
+
+		for (unsigned int index = 0; index != 6; index++)
+		{
+			floats[index] = this->m_bSwapBytes ? LoadBinaryValue<float, true>(pSource + index * sizeof(float))
+				: LoadBinaryValue<float, false>(pSource + index * sizeof(float));
+		}
+
+		vertex.x = floats[0];	vertex.y = floats[1];	vertex.z = floats[2];	vertex.w = 1.0f;
+		vertex.nx = floats[3];	vertex.ny = floats[4];	vertex.nz = floats[5];	vertex.nw = 1.0f;
+
+		vertex.r = pSource[24] / 255.0f;
+		vertex.g = pSource[25] / 255.0f;
+		vertex.b = pSource[26] / 255.0f;
+		vertex.a = pSource[27] / 255.0f;
+
+		pSource += RECORD_SIZE;
+	}
+
+	cursor.pCurrent = pSource;
+
+	return;
+}
+
+bool cPlyFileReader::m_DecodeVertices(sCursor& cursor, const sElement& element, sModelDrawInfo& drawInfo, bool& bHasNormals)
+{
+	drawInfo.numberOfVertices = element.count;
+	drawInfo.pVertices = new sVertex[drawInfo.numberOfVertices];
+
+	//--------------------The layout the engine writes is copied straight over------------------
+
+	if (this->m_IsEngineVertexLayout(element))
+	{
+		// Record size already checked against the file size
+		this->m_DecodeEngineVertexLayout(cursor, drawInfo);
+
+		bHasNormals = true;
+
+		return true;
+	}
+
+	//--------------------Work out where each property goes in sVertex-------------------------
+
+	struct sPropertySlot
+	{
+		int floatIndex;		// Index into sVertex viewed as float[12], -1 = skip
+		float scale;
+
+		sBinaryReader reader;
+		sBinaryReader countReader;	// Lists
+	};
+
+	const int X = (int)(offsetof(sVertex, x) / sizeof(float));
+	const int R = (int)(offsetof(sVertex, r) / sizeof(float));
+	const int NX = (int)(offsetof(sVertex, nx) / sizeof(float));
+
+	std::vector<sPropertySlot> vecSlots(element.properties.size());
+
+	unsigned int numberOfNormals = 0;
+
+	for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+	{
+		const sProperty& property = element.properties[propIndex];
+		const std::string& name = property.name;
+
+		sPropertySlot& slot = vecSlots[propIndex];
+		slot.floatIndex = -1;
+		slot.scale = 1.0f;
+		slot.reader = this->m_GetBinaryReader(property.type);
+		slot.countReader = this->m_GetBinaryReader(property.listCountType);
+
+		if (property.bIsList)
+			continue;
+
+		if (name == "x")			slot.floatIndex = X + 0;
+		else if (name == "y")		slot.floatIndex = X + 1;
+		else if (name == "z")		slot.floatIndex = X + 2;
+		else if (name == "nx")		slot.floatIndex = NX + 0;
+		else if (name == "ny")		slot.floatIndex = NX + 1;
+		else if (name == "nz")		slot.floatIndex = NX + 2;
+		else if (name == "red" || name == "r" || name == "diffuse_red")			slot.floatIndex = R + 0;
+		else if (name == "green" || name == "g" || name == "diffuse_green")		slot.floatIndex = R + 1;
+		else if (name == "blue" || name == "b" || name == "diffuse_blue")		slot.floatIndex = R + 2;
+		else if (name == "alpha" || name == "a" || name == "diffuse_alpha")		slot.floatIndex = R + 3;
+
+		if (slot.floatIndex >= NX && slot.floatIndex < NX + 3)
+			numberOfNormals++;
+
+		// Integer colours are 0 to "max of the type", floats are already 0 to 1
+		if (slot.floatIndex >= R && slot.floatIndex < R + 4)
+		{
+			if (property.type == TYPE_UCHAR)		slot.scale = 1.0f / 255.0f;
+			else if (property.type == TYPE_USHORT)	slot.scale = 1.0f / 65535.0f;
+		}
+	}
+
+	bHasNormals = (numberOfNormals == 3);
+
+	//--------------------Decode every vertex--------------------------------------------------
+
+	const bool bIsAscii = (this->m_format == FORMAT_ASCII);
+
+	double asciiValue = 0.0;
+
+	for (unsigned int vertIndex = 0; vertIndex != element.count; vertIndex++)
+	{
+		sVertex& vertex = drawInfo.pVertices[vertIndex];
+
+		vertex.x = vertex.y = vertex.z = 0.0f;				vertex.w = 1.0f;
+		vertex.r = vertex.g = vertex.b = vertex.a = 1.0f;
+		vertex.nx = vertex.ny = vertex.nz = 0.0f;			vertex.nw = 1.0f;
+
+		float* pVertexFloats = &(vertex.x);
+
+		for (unsigned int propIndex = 0; propIndex != vecSlots.size(); propIndex++)
+		{
+			const sProperty& property = element.properties[propIndex];
+			const sPropertySlot& slot = vecSlots[propIndex];
+
+			float value = 0.0f;
+
+			if (bIsAscii)
+			{
+				if (property.bIsList)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.listCountType, asciiValue))
+						return false;
+
+					if (!this->m_IsListCountValid(element, asciiValue))
+						return false;
+
+					unsigned int numberOfValues = (unsigned int)asciiValue;
+
+					for (unsigned int valueIndex = 0; valueIndex != numberOfValues; valueIndex++)
+					{
+						if (!this->m_ReadAsciiValue(cursor, property.type, asciiValue))
+							return false;
+					}
+
+					continue;
+				}
+
+				if (!this->m_ReadAsciiValue(cursor, property.type, asciiValue))
+					return false;
+
+				value = (float)asciiValue;
+			}
+			else
+			{
+				std::size_t bytesLeft = (std::size_t)(cursor.pEnd - cursor.pCurrent);
+
+				if (property.bIsList)
+				{
+					if (bytesLeft < slot.countReader.size)
+						return false;
+
+					long long numberOfValues = slot.countReader.pReadInteger(cursor.pCurrent);
+					cursor.pCurrent += slot.countReader.size;
+
+					if (!this->m_IsListCountValid(element, (double)numberOfValues))
+						return false;
+
+					if ((std::size_t)(cursor.pEnd - cursor.pCurrent) < (std::size_t)numberOfValues * slot.reader.size)
+						return false;
+
+					cursor.pCurrent += (std::size_t)numberOfValues * slot.reader.size;
+
+					continue;
+				}
+
+				if (bytesLeft < slot.reader.size)
+					return false;
+
+				value = slot.reader.pReadFloat(cursor.pCurrent);
+				cursor.pCurrent += slot.reader.size;
+			}
+
+			if (slot.floatIndex >= 0)
+				pVertexFloats[slot.floatIndex] = value * slot.scale;
+		}
+	}
+
+	return true;
+}
+
+bool cPlyFileReader::m_DecodeFaces(sCursor& cursor, const sElement& element, unsigned int numberOfVertices, sIndexArray& indices)
+{
+	int indexListProperty = -1;
+
+	for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+	{
+		const sProperty& property = element.properties[propIndex];
+
+		if (property.bIsList && (property.name == "vertex_indices" || property.name == "vertex_index"))
+		{
+			indexListProperty = (int)propIndex;
+			break;
+		}
+	}
+
+	if (indexListProperty < 0)
+	{
+		this->m_lastError = "face element has no vertex_indices list";
+		return false;
+	}
+
+	// Most meshes are all triangles
+	cPlyFileReader::m_ReserveIndices(indices, indices.size + (std::size_t)element.count * 3);
+
+	//--------------------Only "list uchar int vertex_indices" : read straight from the mapping------
+
+	const sProperty& indexList = element.properties[indexListProperty];
+
+	if (this->m_format != FORMAT_ASCII && element.properties.size() == 1 && indexList.listCountType == TYPE_UCHAR &&
+		(indexList.type == TYPE_INT || indexList.type == TYPE_UINT))
+	{
+		return this->m_DecodeIndexOnlyFaces(cursor, element, numberOfVertices, indices);
+	}
+
+	std::vector<unsigned int> vecFaceIndices;
+
+	const bool bIsAscii = (this->m_format == FORMAT_ASCII);
+
+	// Picked once per property rather than once per value
+	std::vector<sBinaryReader> vecReaders(element.properties.size());
+	std::vector<sBinaryReader> vecCountReaders(element.properties.size());
+
+	if (!bIsAscii)
+	{
+		for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+		{
+			vecReaders[propIndex] = this->m_GetBinaryReader(element.properties[propIndex].type);
+			vecCountReaders[propIndex] = this->m_GetBinaryReader(element.properties[propIndex].listCountType);
+		}
+	}
+
+	double asciiValue = 0.0;
+
+	for (unsigned int faceIndex = 0; faceIndex != element.count; faceIndex++)
+	{
+		for (unsigned int propIndex = 0; propIndex != element.properties.size(); propIndex++)
+		{
+			const sProperty& property = element.properties[propIndex];
+
+			const sBinaryReader& reader = vecReaders[propIndex];
+			const sBinaryReader& countReader = vecCountReaders[propIndex];
+
+			long long numberOfValues = 1;
+
+			if (property.bIsList)
+			{
+				if (bIsAscii)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.listCountType, asciiValue))
+					{
+						this->m_lastError = "file is truncated in the face element";
+						return false;
+					}
+
+					if (!this->m_IsListCountValid(element, asciiValue))
+						return false;
+
+					numberOfValues = (long long)asciiValue;
+				}
+				else
+				{
+					if ((std::size_t)(cursor.pEnd - cursor.pCurrent) < countReader.size)
+					{
+						this->m_lastError = "file is truncated in the face element";
+						return false;
+					}
+
+					numberOfValues = countReader.pReadInteger(cursor.pCurrent);
+					cursor.pCurrent += countReader.size;
+
+					if (!this->m_IsListCountValid(element, (double)numberOfValues))
+						return false;
+				}
+			}
+
+			// Binary values are the same size, so the whole list is checked at once
+			if (!bIsAscii && (std::size_t)(cursor.pEnd - cursor.pCurrent) < (std::size_t)numberOfValues * reader.size)
+			{
+				this->m_lastError = "file is truncated in the face element";
+				return false;
+			}
+
+			if ((int)propIndex != indexListProperty)
+			{
+				if (!bIsAscii)
+				{
+					cursor.pCurrent += (std::size_t)numberOfValues * reader.size;
+					continue;
+				}
+
+				for (long long valueIndex = 0; valueIndex != numberOfValues; valueIndex++)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.type, asciiValue))
+					{
+						this->m_lastError = "file is truncated in the face element";
+						return false;
+					}
+				}
+
+				continue;
+			}
+
+			vecFaceIndices.clear();
+
+			for (long long valueIndex = 0; valueIndex != numberOfValues; valueIndex++)
+			{
+				long long vertexIndex = 0;
+
+				if (bIsAscii)
+				{
+					if (!this->m_ReadAsciiValue(cursor, property.type, asciiValue))
+					{
+						this->m_lastError = "file is truncated in the face element";
+						return false;
+					}
+
+					if (asciiValue < 0.0 || asciiValue >= (double)numberOfVertices)
+					{
+						this->m_lastError = "face refers to a vertex that doesn't exist";
+						return false;
+					}
+
+					vertexIndex = (long long)asciiValue;
+				}
+				else
+				{
+					vertexIndex = reader.pReadInteger(cursor.pCurrent);
+					cursor.pCurrent += reader.size;
+
+					if (vertexIndex < 0 || vertexIndex >= (long long)numberOfVertices)
+					{
+						this->m_lastError = "face refers to a vertex that doesn't exist";
+						return false;
+					}
+				}
+
+				vecFaceIndices.push_back((unsigned int)vertexIndex);
+			}
+
+			// Triangle fan: (0, 1, 2), (0, 2, 3), (0, 3, 4)...
+			for (unsigned int corner = 2; corner < vecFaceIndices.size(); corner++)
+			{
+				cPlyFileReader::m_ReserveIndices(indices, indices.size + 3);
+
+				indices.pIndices[indices.size + 0] = vecFaceIndices[0];
+				indices.pIndices[indices.size + 1] = vecFaceIndices[corner - 1];
+				indices.pIndices[indices.size + 2] = vecFaceIndices[corner];
+
+				indices.size += 3;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool cPlyFileReader::m_DecodeIndexOnlyFaces(sCursor& cursor, const sElement& element, unsigned int numberOfVertices, sIndexArray& indices)
+{
+	const unsigned char* pSource = cursor.pCurrent;
+
+	// Already reserved for all triangles, only grows if there are bigger faces
+	unsigned int* pIndices = indices.pIndices;
+	std::size_t numberOfIndices = indices.size;
+
+	for (unsigned int faceIndex = 0; faceIndex != element.count; faceIndex++)
+	{
+		if (pSource == cursor.pEnd)
+		{
+			indices.size = numberOfIndices;
+
+			this->m_lastError = "file is truncated in the face element";
+			return false;
+		}
+
+		unsigned int numberOfCorners = *pSource;
+		pSource++;
+
+		if ((std::size_t)(cursor.pEnd - pSource) < numberOfCorners * sizeof(unsigned int))
+		{
+			indices.size = numberOfIndices;
+
+			this->m_lastError = "file is truncated in the face element";
+			return false;
+		}
+
+		if (numberOfCorners < 3)
+		{
+			pSource += numberOfCorners * sizeof(unsigned int);
+			continue;
+		}
+
+		if (numberOfIndices + (numberOfCorners - 2) * 3 > indices.capacity)
+		{
+			indices.size = numberOfIndices;
+			cPlyFileReader::m_ReserveIndices(indices, numberOfIndices + (numberOfCorners - 2) * 3);
+			pIndices = indices.pIndices;
+		}
+
+		unsigned int firstIndex = 0;
+		unsigned int previousIndex = 0;
+
+		for (unsigned int corner = 0; corner != numberOfCorners; corner++)
+		{
+			unsigned int vertexIndex = this->m_bSwapBytes ? LoadBinaryValue<unsigned int, true>(pSource)
+				: LoadBinaryValue<unsigned int, false>(pSource);
+			pSource += sizeof(unsigned int);
+
+			// A negative int reads as a huge unsigned value, so one compare covers both ends
+			if (vertexIndex >= numberOfVertices)
+			{
+				indices.size = numberOfIndices;
+
+				this->m_lastError = "face refers to a vertex that doesn't exist";
+				return false;
+			}
+
+			// Triangle fan: (0, 1, 2), (0, 2, 3), (0, 3, 4)...
+			if (corner == 0)
+				firstIndex = vertexIndex;
+			else if (corner >= 2)
+			{
+				pIndices[numberOfIndices + 0] = firstIndex;
+				pIndices[numberOfIndices + 1] = previousIndex;
+				pIndices[numberOfIndices + 2] = vertexIndex;
+
+				numberOfIndices += 3;
+			}
+
+			previousIndex = vertexIndex;
+		}
+	}
+
+	indices.size = numberOfIndices;
+
+	cursor.pCurrent = pSource;
+
+	return true;
+}
+
+void cPlyFileReader::m_GenerateNormals(sModelDrawInfo& drawInfo)
+{
+	// Area weighted average of the faces around each vertex
+	for (unsigned int index = 0; index < drawInfo.numberOfIndices; index += 3)
+	{
+		sVertex& v0 = drawInfo.pVertices[drawInfo.pIndices[index + 0]];
+		sVertex& v1 = drawInfo.pVertices[drawInfo.pIndices[index + 1]];
+		sVertex& v2 = drawInfo.pVertices[drawInfo.pIndices[index + 2]];
+
+		glm::vec3 edgeA = glm::vec3(v1.x - v0.x, v1.y - v0.y, v1.z - v0.z);
+		glm::vec3 edgeB = glm::vec3(v2.x - v0.x, v2.y - v0.y, v2.z - v0.z);
+
+		glm::vec3 faceNormal = glm::cross(edgeA, edgeB);
+
+		v0.nx += faceNormal.x;	v0.ny += faceNormal.y;	v0.nz += faceNormal.z;
+		v1.nx += faceNormal.x;	v1.ny += faceNormal.y;	v1.nz += faceNormal.z;
+		v2.nx += faceNormal.x;	v2.ny += faceNormal.y;	v2.nz += faceNormal.z;
+	}
+
+	for (unsigned int vertIndex = 0; vertIndex != drawInfo.numberOfVertices; vertIndex++)
+	{
+		sVertex& vertex = drawInfo.pVertices[vertIndex];
+
+		float length = std::sqrt(vertex.nx * vertex.nx + vertex.ny * vertex.ny + vertex.nz * vertex.nz);
+
+		if (length > 0.0f)
+		{
+			vertex.nx /= length;
+			vertex.ny /= length;
+			vertex.nz /= length;
+		}
+	}
+
+	return;
+}
+
+void cPlyFileReader::m_ReserveIndices(sIndexArray& indices, std::size_t minimumCapacity)
+{
+	if (indices.capacity >= minimumCapacity)
+		return;
+
+	std::size_t newCapacity = indices.capacity * 2;
+
+	if (newCapacity < minimumCapacity)
+		newCapacity = minimumCapacity;
+
+	unsigned int* pNewIndices = new unsigned int[newCapacity];
+
+	if (indices.size > 0)
+		memcpy(pNewIndices, indices.pIndices, sizeof(unsigned int) * indices.size);
+
+	delete[] indices.pIndices;
+
+	indices.pIndices = pNewIndices;
+	indices.capacity = newCapacity;
+
+	return;
+}
+
+void cPlyFileReader::m_FreeVertices(sModelDrawInfo& drawInfo)
+{
+	delete[] drawInfo.pVertices;
+
+	drawInfo.pVertices = NULL;
+	drawInfo.numberOfVertices = 0;
+
+	return;
+}
+
+bool cPlyFileReader::DecodeMesh(sModelDrawInfo& drawInfo)
+{
+	if (this->m_pFileData == NULL || this->m_dataOffset == 0)
+	{
+		this->m_lastError = "header hasn't been parsed";
+		return false;
+	}
+
+	sCursor cursor;
+	cursor.pCurrent = this->m_pFileData + this->m_dataOffset;
+	cursor.pEnd = this->m_pFileData + this->m_fileSize;
+
+	// Set by the decoders for anything more specific than a truncated file
+	this->m_lastError.clear();
+
+	sIndexArray indices;
+	indices.pIndices = NULL;
+	indices.size = 0;
+	indices.capacity = 0;
+
+	bool bFoundVertices = false;
+	bool bHasNormals = false;
+
+	//--------------------Elements are stored in the order they are declared--------------------
+
+	for (unsigned int elementIndex = 0; elementIndex != this->m_vecElements.size(); elementIndex++)
+	{
+		const sElement& element = this->m_vecElements[elementIndex];
+
+		// The header's count is checked against what's left of the file before anything
+		//	is allocated or decoded from it
+		unsigned long long minimumElementSize = (unsigned long long)element.count * this->m_MinimumRecordSize(element);
+
+		if (minimumElementSize > (unsigned long long)(cursor.pEnd - cursor.pCurrent))
+		{
+			this->m_lastError = "the '" + element.name + "' element is larger than the rest of the file";
+
+			cPlyFileReader::m_FreeVertices(drawInfo);
+			delete[] indices.pIndices;
+
+			return false;
+		}
+
+		if (element.name == "vertex" && !bFoundVertices)
+		{
+			if (!this->m_DecodeVertices(cursor, element, drawInfo, bHasNormals))
+			{
+				if (this->m_lastError.empty())
+					this->m_lastError = "file is truncated in the vertex element";
+
+				cPlyFileReader::m_FreeVertices(drawInfo);
+				delete[] indices.pIndices;
+
+				return false;
+			}
+
+			bFoundVertices = true;
+		}
+		else if (element.name == "face" && bFoundVertices)
+		{
+			if (!this->m_DecodeFaces(cursor, element, drawInfo.numberOfVertices, indices))
+			{
+				cPlyFileReader::m_FreeVertices(drawInfo);
+				delete[] indices.pIndices;
+
+				return false;
+			}
+		}
+		else if (!this->m_SkipElement(cursor, element))
+		{
+			if (this->m_lastError.empty())
+				this->m_lastError = "file is truncated in the '" + element.name + "' element";
+
+			cPlyFileReader::m_FreeVertices(drawInfo);
+			delete[] indices.pIndices;
+
+			return false;
+		}
+	}
+
+	if (!bFoundVertices)
+	{
+		this->m_lastError = "no vertex element";
+		return false;
+	}
+
+	//--------------------Hand the triangles over----------------------------------------------
+
+	// Only polygons leave spare room (triangles were reserved exactly)
+	if (indices.pIndices == NULL || indices.size != indices.capacity)
+	{
+		unsigned int* pExactIndices = new unsigned int[indices.size];
+
+		if (indices.size > 0)
+			memcpy(pExactIndices, indices.pIndices, sizeof(unsigned int) * indices.size);
+
+		delete[] indices.pIndices;
+
+		indices.pIndices = pExactIndices;
+	}
+
+	drawInfo.pIndices = indices.pIndices;
+	drawInfo.numberOfIndices = (unsigned int)indices.size;
+	drawInfo.numberOfTriangles = drawInfo.numberOfIndices / 3;
+
+	if (!bHasNormals)
+		this->m_GenerateNormals(drawInfo);
+
+	return true;
+}
@@ -0,0 +1,146 @@
+#ifndef _cPlyFileReader_HG_
+#define _cPlyFileReader_HG_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "sModelDrawInfo.h"
+
+// Reads a PLY file (ascii, binary_little_endian or binary_big_endian) by
+//	building a table of the elements and properties declared in the header,
+//	then decoding the vertex and face elements from that table.
+// Any property order works; unknown properties (texture coords etc.) are skipped.
+class cPlyFileReader
+{
+public:
+
+	enum eFormat
+	{
+		FORMAT_ASCII,
+		FORMAT_BINARY_LITTLE_ENDIAN,
+		FORMAT_BINARY_BIG_ENDIAN,
+		FORMAT_UNKNOWN
+	};
+
+	enum ePropertyType
+	{
+		TYPE_CHAR,		// int8
+		TYPE_UCHAR,		// uint8
+		TYPE_SHORT,		// int16
+		TYPE_USHORT,	// uint16
+		TYPE_INT,		// int32
+		TYPE_UINT,		// uint32
+		TYPE_FLOAT,		// float32
+		TYPE_DOUBLE,	// float64
+		TYPE_UNKNOWN
+	};
+
+	struct sProperty
+	{
+		sProperty();
+
+		std::string name;
+		ePropertyType type;			// Type of the value (or of each list entry)
+
+		bool bIsList;
+		ePropertyType listCountType;	// Only used if bIsList
+	};
+
+	struct sElement
+	{
+		sElement();
+
+		std::string name;
+		unsigned int count;
+		std::vector<sProperty> properties;
+	};
+
+	cPlyFileReader();
+
+	// pFileData must stay valid while the reader is used (e.g. a cMappedFile)
+	bool ParseHeader(const unsigned char* pFileData, std::size_t fileSize);
+
+	// Fills pVertices, pIndices and the counts. Faces with more than 3 vertices are
+	//	triangulated as fans. Missing normals are generated, missing colours are white.
+	bool DecodeMesh(sModelDrawInfo& drawInfo);
+
+	eFormat getFormat(void) const;
+
+	const std::vector<sElement>& getElements(void) const;
+
+	std::string getLastError(void) const;
+
+	static ePropertyType TypeFromName(const std::string& typeName);
+
+	static unsigned int SizeOfType(ePropertyType type);
+
+private:
+
+	// A read position inside the data section (after "end_header")
+	struct sCursor
+	{
+		const unsigned char* pCurrent;
+		const unsigned char* pEnd;
+	};
+
+	// Grows like a vector, but the array is handed straight to sModelDrawInfo::pIndices
+	struct sIndexArray
+	{
+		unsigned int* pIndices;
+		std::size_t size;
+		std::size_t capacity;
+	};
+
+	static void m_ReserveIndices(sIndexArray& indices, std::size_t minimumCapacity);
+
+	// Binary values go through the reader picked for their property's type and the
+	//	file's byte order, so there's no type switch (or double) per value
+	struct sBinaryReader
+	{
+		unsigned int size;
+		float (*pReadFloat)(const unsigned char* pSource);
+		long long (*pReadInteger)(const unsigned char* pSource);
+	};
+
+	sBinaryReader m_GetBinaryReader(ePropertyType type) const;
+
+	// Fewest bytes one record can take up (empty lists, one character per ascii value)
+	std::size_t m_MinimumRecordSize(const sElement& element) const;
+
+	bool m_ReadAsciiValue(sCursor& cursor, ePropertyType type, double& value);
+
+	// False (with m_lastError set) for a negative count or one too big for an unsigned int
+	bool m_IsListCountValid(const sElement& element, double count);
+
+	bool m_SkipElement(sCursor& cursor, const sElement& element);
+
+	// float x y z nx ny nz, uchar red green blue alpha (what the engine's models use)
+	bool m_IsEngineVertexLayout(const sElement& element) const;
+
+	void m_DecodeEngineVertexLayout(sCursor& cursor, sModelDrawInfo& drawInfo);
+
+	bool m_DecodeVertices(sCursor& cursor, const sElement& element, sModelDrawInfo& drawInfo, bool& bHasNormals);
+
+	bool m_DecodeFaces(sCursor& cursor, const sElement& element, unsigned int numberOfVertices, sIndexArray& indices);
+
+	// Faces that are just "list uchar int vertex_indices"
+	bool m_DecodeIndexOnlyFaces(sCursor& cursor, const sElement& element, unsigned int numberOfVertices, sIndexArray& indices);
+
+	void m_GenerateNormals(sModelDrawInfo& drawInfo);
+
+	static void m_FreeVertices(sModelDrawInfo& drawInfo);
+
+	const unsigned char* m_pFileData;
+	std::size_t m_fileSize;
+	std::size_t m_dataOffset;
+
+	eFormat m_format;
+	bool m_bSwapBytes;
+
+	std::vector<sElement> m_vecElements;
+
+	std::string m_lastError;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "cRenderQueue.h"
+#include "cMesh.h"
+#include "sModelDrawInfo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+cRenderQueue::cRenderQueue()
+{
+
+}
+
+//static
+unsigned long long cRenderQueue::MakeSortKey(unsigned int shaderProgramID, const cMesh* pMesh, float viewDepth)
+{
+	const sModelDrawInfo* pModelInfo = pMesh->pModelDrawInfo;
+
+	unsigned long long shaderBits = shaderProgramID & 0xFF;
+	unsigned long long vaoBits = (pModelInfo != NULL) ? (pModelInfo->VAO_ID & 0xFFF) : 0;
+	unsigned long long wireframeBit = pMesh->bIsWireframe ? 1 : 0;
+	unsigned long long modelBits = (pModelInfo != NULL) ? (pModelInfo->getUniqueID() & 0xFFFF) : 0;
+	unsigned long long lodBits = std::min(pMesh->currentLOD, 3u);
+	unsigned long long lightingBits = (pMesh->bDoNotLight ? 2 : 0) | (pMesh->bUseManualColours ? 1 : 0);
+
+	// A positive float's bits sort like the float, the top 23 (of 31) are plenty.
+	//	Behind the eye (a mesh the camera is inside of) goes first.
+	unsigned int depthBits = 0;
+
+	if (viewDepth > 0.0f)
+	{
+		memcpy(&depthBits, &viewDepth, sizeof(float));
+		depthBits >>= 8;
+	}
+
+	return (shaderBits << 56) |
+		(vaoBits << 44) |
+		(wireframeBit << 43) |
+		(modelBits << 27) |
+		(lodBits << 25) |
+		(lightingBits << 23) |
+		(unsigned long long)depthBits;
+}
+
+void cRenderQueue::Clear(void)
+{
+	this->m_vecKeys.clear();
+	this->m_vecItems.clear();
+
+	return;
+}
+
+void cRenderQueue::Add(unsigned long long sortKey, unsigned int item)
+{
+	this->m_vecKeys.push_back(sortKey);
+	this->m_vecItems.push_back(item);
+
+	return;
+}
+
+void cRenderQueue::Sort(void)
+{
+	std::chrono::steady_clock::time_point sortStart = std::chrono::steady_clock::now();
+
+	unsigned int numberOfItems = (unsigned int)this->m_vecKeys.size();
+
+	this->m_lastStats = sRenderQueueStats();
+	this->m_lastStats.numberOfItems = numberOfItems;
+
+	this->m_vecScratchKeys.resize(numberOfItems);
+	this->m_vecScratchItems.resize(numberOfItems);
+
+	for (unsigned int pass = 0; pass != 8; pass++)
+	{
+		unsigned int shift = pass * 8;
+
+		unsigned int digitCounts[256];
+		memset(digitCounts, 0, sizeof(digitCounts));
+
+		for (unsigned int index = 0; index != numberOfItems; index++)
+			digitCounts[(this->m_vecKeys[index] >> shift) & 0xFF]++;
+
+		// Every key has the same digit here (e.g. the one shader), nothing to move
+		if (numberOfItems == 0 || digitCounts[(this->m_vecKeys[0] >> shift) & 0xFF] == numberOfItems)
+			continue;
+
+		unsigned int digitStart = 0;
+
+		for (unsigned int digit = 0; digit != 256; digit++)
+		{
+			unsigned int count = digitCounts[digit];
+			digitCounts[digit] = digitStart;
+			digitStart += count;
+		}
+
+		for (unsigned int index = 0; index != numberOfItems; index++)
+		{
+			unsigned int destination = digitCounts[(this->m_vecKeys[index] >> shift) & 0xFF]++;
+
+			this->m_vecScratchKeys[destination] = this->m_vecKeys[index];
+			this->m_vecScratchItems[destination] = this->m_vecItems[index];
+		}
+
+		this->m_vecKeys.swap(this->m_vecScratchKeys);
+		this->m_vecItems.swap(this->m_vecScratchItems);
+
+		this->m_lastStats.numberOfSortPasses++;
+	}
+
+	this->m_lastStats.sortTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - sortStart).count();
+
+	return;
+}
+
+unsigned int cRenderQueue::getNumberOfItems(void) const
+{
+	return (unsigned int)this->m_vecItems.size();
+}
+
+unsigned int cRenderQueue::getItem(unsigned int index) const
+{
+	return this->m_vecItems[index];
+}
+
+sRenderQueueStats cRenderQueue::getLastStats(void) const
+{
+	return this->m_lastStats;
+}
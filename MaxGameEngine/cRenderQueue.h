@@ -0,0 +1,66 @@
+#ifndef _cRenderQueue_HG_
+#define _cRenderQueue_HG_
+
+#include <vector>
+
+class cMesh;
+
+// What the last Sort did
+struct sRenderQueueStats
+{
+	unsigned int numberOfItems = 0;
+	unsigned int numberOfSortPasses = 0;		// Radix passes actually run (of 8, the rest were all one digit)
+
+	double sortTime = 0.0;						// Seconds, wall clock
+};
+
+// Each frame's draws as 64 bit sort keys, sorted so draws sharing GL state end up next to
+//	each other. From the top bit down:
+//
+//	 8 bits  shader program
+//	12 bits  VAO
+//	 1 bit   wireframe
+//	16 bits  model (sModelDrawInfo unique ID)
+//	 2 bits  LOD
+//	 2 bits  lighting flags (bDoNotLight, bUseManualColours)
+//	23 bits  view depth, front to back
+//
+// Model and LOD come before the lighting flags so a model's instances stay together; the flags
+//	only keep lit and unlit meshes apart inside it. Fields wider than their bits are cut down,
+//	so the key only orders the draws, anything that has to match is compared on the meshes.
+class cRenderQueue
+{
+public:
+
+	cRenderQueue();
+
+	static unsigned long long MakeSortKey(unsigned int shaderProgramID, const cMesh* pMesh, float viewDepth);
+
+	void Clear(void);
+
+	// item is the caller's (e.g. an index into its draw list)
+	void Add(unsigned long long sortKey, unsigned int item);
+
+	// Least significant digit first radix sort, 8 bits a pass. Stable.
+	void Sort(void);
+
+	unsigned int getNumberOfItems(void) const;
+
+	// In key order once sorted
+	unsigned int getItem(unsigned int index) const;
+
+	sRenderQueueStats getLastStats(void) const;
+
+private:
+
+	std::vector<unsigned long long> m_vecKeys;
+	std::vector<unsigned int> m_vecItems;
+
+	// The other half of each pass
+	std::vector<unsigned long long> m_vecScratchKeys;
+	std::vector<unsigned int> m_vecScratchItems;
+
+	sRenderQueueStats m_lastStats;
+};
+
+#endif
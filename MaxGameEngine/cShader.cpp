@@ -1,6 +1,8 @@
 #include "cShaderManager.h"
 #include "../OpenGLCommon.h"
 
+#include <glm/gtc/type_ptr.hpp>
+
 cShaderManager::cShader::cShader()
 {
 	this->ID = 0;
@@ -55,3 +57,178 @@ int cShaderManager::cShaderProgram::getUniformID_From_Name(std::string name)
 
 	return itUniform->second;
 }
+
+void cShaderManager::cShaderProgram::LoadActiveUniforms(void)
+{
+	this->vecUniforms.clear();
+	this->mapUniformName_to_UniformIndex.clear();
+
+	GLint numberOfUniforms = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &numberOfUniforms);
+
+	GLint maxNameLength = 0;
+	glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1, 0);
+
+	for (GLint uniformIndex = 0; uniformIndex != numberOfUniforms; uniformIndex++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum glType = 0;
+
+		glGetActiveUniform(this->ID, (GLuint)uniformIndex, (GLsizei)nameBuffer.size(), &nameLength, &arraySize, &glType, nameBuffer.data());
+
+		sUniformInfo uniformInfo;
+		uniformInfo.name = std::string(nameBuffer.data(), nameLength);
+		uniformInfo.location = glGetUniformLocation(this->ID, uniformInfo.name.c_str());
+		uniformInfo.glType = glType;
+		uniformInfo.arraySize = arraySize;
+
+		// Uniform block members have no location, they're set through their buffer
+		if (uniformInfo.location == -1)
+			continue;
+
+		unsigned int handleIndex = (unsigned int)this->vecUniforms.size();
+
+		this->vecUniforms.push_back(uniformInfo);
+
+		this->mapUniformName_to_UniformLocation[uniformInfo.name] = uniformInfo.location;
+		this->mapUniformName_to_UniformIndex[uniformInfo.name] = handleIndex;
+
+		// "lightIntensities[0]" can also be found as "lightIntensities"
+		const std::string firstElement = "[0]";
+
+		if (uniformInfo.name.size() > firstElement.size() &&
+			uniformInfo.name.compare(uniformInfo.name.size() - firstElement.size(), firstElement.size(), firstElement) == 0)
+		{
+			std::string arrayName = uniformInfo.name.substr(0, uniformInfo.name.size() - firstElement.size());
+
+			this->mapUniformName_to_UniformLocation[arrayName] = uniformInfo.location;
+			this->mapUniformName_to_UniformIndex[arrayName] = handleIndex;
+		}
+	}
+
+	return;
+}
+
+int cShaderManager::cShaderProgram::getUniformBlockSize(const std::string& blockName)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(this->ID, blockName.c_str());
+
+	if (blockIndex == GL_INVALID_INDEX)
+		return -1;
+
+	GLint blockSize = 0;
+	glGetActiveUniformBlockiv(this->ID, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+
+	return blockSize;
+}
+
+bool cShaderManager::cShaderProgram::getBufferVariableLayout(const std::string& variableName, int& offset, int& topLevelArrayStride)
+{
+	GLuint variableIndex = glGetProgramResourceIndex(this->ID, GL_BUFFER_VARIABLE, variableName.c_str());
+
+	if (variableIndex == GL_INVALID_INDEX)
+		return false;
+
+	const GLenum properties[2] = { GL_OFFSET, GL_TOP_LEVEL_ARRAY_STRIDE };
+	GLint values[2] = { -1, -1 };
+
+	glGetProgramResourceiv(this->ID, GL_BUFFER_VARIABLE, variableIndex, 2, properties, 2, NULL, values);
+
+	offset = values[0];
+	topLevelArrayStride = values[1];
+
+	return true;
+}
+
+bool cShaderManager::cShaderProgram::m_ResolveUniform(const std::string& name, eUniformType uniformType, unsigned int& index)
+{
+	index = sUniformHandle<UNIFORM_TYPE_FLOAT>::INVALID_HANDLE;
+
+	std::map< std::string, unsigned int>::iterator itUniform = this->mapUniformName_to_UniformIndex.find(name);
+
+	if (itUniform == this->mapUniformName_to_UniformIndex.end())
+		return false;
+
+	GLenum glType = this->vecUniforms[itUniform->second].glType;
+
+	bool bTypeMatches = false;
+
+	switch (uniformType)
+	{
+	case UNIFORM_TYPE_FLOAT:
+		bTypeMatches = (glType == GL_FLOAT);
+		break;
+
+	case UNIFORM_TYPE_INT:
+		bTypeMatches = (glType == GL_INT || glType == GL_SAMPLER_2D || glType == GL_SAMPLER_CUBE || glType == GL_SAMPLER_2D_ARRAY);
+		break;
+
+	case UNIFORM_TYPE_BOOL:
+		bTypeMatches = (glType == GL_BOOL || glType == GL_INT || glType == GL_FLOAT);
+		break;
+
+	case UNIFORM_TYPE_VEC3:
+		bTypeMatches = (glType == GL_FLOAT_VEC3);
+		break;
+
+	case UNIFORM_TYPE_VEC4:
+		bTypeMatches = (glType == GL_FLOAT_VEC4);
+		break;
+
+	case UNIFORM_TYPE_MAT4:
+		bTypeMatches = (glType == GL_FLOAT_MAT4);
+		break;
+	}
+
+	if (!bTypeMatches)
+		return false;
+
+	index = itUniform->second;
+
+	return true;
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_FLOAT> handle, float value)
+{
+	if (handle.isValid())
+		glUniform1f(this->vecUniforms[handle.index].location, value);
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_INT> handle, int value)
+{
+	if (handle.isValid())
+		glUniform1i(this->vecUniforms[handle.index].location, value);
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_BOOL> handle, bool value)
+{
+	if (!handle.isValid())
+		return;
+
+	// A float flag has to be set as a float, GLSL bools and ints take either
+	if (this->vecUniforms[handle.index].glType == GL_FLOAT)
+		glUniform1f(this->vecUniforms[handle.index].location, (value ? 1.0f : 0.0f));
+	else
+		glUniform1i(this->vecUniforms[handle.index].location, (value ? 1 : 0));
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_VEC3> handle, const glm::vec3& value)
+{
+	if (handle.isValid())
+		glUniform3f(this->vecUniforms[handle.index].location, value.x, value.y, value.z);
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_VEC4> handle, const glm::vec4& value)
+{
+	if (handle.isValid())
+		glUniform4f(this->vecUniforms[handle.index].location, value.x, value.y, value.z, value.w);
+}
+
+void cShaderManager::cShaderProgram::setUniform(sUniformHandle<UNIFORM_TYPE_MAT4> handle, const glm::mat4& value)
+{
+	if (handle.isValid())
+		glUniformMatrix4fv(this->vecUniforms[handle.index].location, 1, GL_FALSE, glm::value_ptr(value));
+}
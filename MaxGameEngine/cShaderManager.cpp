@@ -265,6 +265,9 @@ bool cShaderManager::createProgramFromFile(std::string friendlyName, cShader& ve
 
 	curProgram.friendlyName = friendlyName;
 
+	// Every uniform is looked up here, once, instead of while drawing
+	curProgram.LoadActiveUniforms();
+
 	this->m_ID_to_Shader[curProgram.ID] = curProgram;
 
 	this->m_name_to_ID[curProgram.friendlyName] = curProgram.ID;
@@ -5,6 +5,35 @@
 #include <vector>
 #include <map>
 
+#include <glm/glm.hpp>
+
+// C++ side type a uniform is set with (see cShaderProgram::setUniform)
+enum eUniformType
+{
+	UNIFORM_TYPE_FLOAT,
+	UNIFORM_TYPE_INT,		// Also samplers
+	UNIFORM_TYPE_BOOL,		// GLSL bool (or a float / int used as one)
+	UNIFORM_TYPE_VEC3,
+	UNIFORM_TYPE_VEC4,
+	UNIFORM_TYPE_MAT4
+};
+
+// Small integer handle of one of a program's active uniforms, resolved from its name
+//	once (cShaderProgram::getUniformHandle) so nothing is looked up by name while drawing.
+// The type is part of the handle, so a mat4 handle can only be set with a glm::mat4.
+template <eUniformType UNIFORM_TYPE>
+struct sUniformHandle
+{
+	static const unsigned int INVALID_HANDLE = ~0u;
+
+	sUniformHandle() : index(INVALID_HANDLE) {};
+
+	bool isValid(void) const { return this->index != INVALID_HANDLE; }
+
+	// Into cShaderProgram::vecUniforms
+	unsigned int index;
+};
+
 class cShaderManager
 {
 public:
@@ -38,10 +67,57 @@ public:
 		std::string friendlyName;
 
 
+		// Every active uniform of the program, filled once it's linked (LoadActiveUniforms).
+		//	Arrays are listed per element ("theLights[3].position"), basic type arrays by
+		//	their first element with and without the "[0]".
+		struct sUniformInfo
+		{
+			std::string name;
+			int location;
+			unsigned int glType;		// GL_FLOAT_MAT4 etc.
+			int arraySize;
+		};
+
+		std::vector< sUniformInfo > vecUniforms;
+
+		// Name to location of every active uniform (index into vecUniforms in the other map)
 		std::map< std::string, int> mapUniformName_to_UniformLocation;
+		std::map< std::string, unsigned int> mapUniformName_to_UniformIndex;
+
 		int getUniformID_From_Name(std::string name);
 		bool LoadUniformLocation(std::string variableName);
 
+		// Walks GL_ACTIVE_UNIFORMS (needs the program linked)
+		void LoadActiveUniforms(void);
+
+		// GL_UNIFORM_BLOCK_DATA_SIZE of a uniform block, -1 if the program has no such block
+		int getUniformBlockSize(const std::string& blockName);
+
+		// GL_OFFSET and GL_TOP_LEVEL_ARRAY_STRIDE of a shader storage block member
+		//	("theLights[0].position"), false if the program has no such member
+		bool getBufferVariableLayout(const std::string& variableName, int& offset, int& topLevelArrayStride);
+
+		// False (and an invalid handle) if the uniform isn't active or its GLSL type
+		//	can't be set as UNIFORM_TYPE
+		template <eUniformType UNIFORM_TYPE>
+		bool getUniformHandle(const std::string& name, sUniformHandle<UNIFORM_TYPE>& handle)
+		{
+			return this->m_ResolveUniform(name, UNIFORM_TYPE, handle.index);
+		}
+
+		// glUniform* of the handle's uniform (the program has to be in use).
+		//	Invalid handles are ignored, like location -1.
+		void setUniform(sUniformHandle<UNIFORM_TYPE_FLOAT> handle, float value);
+		void setUniform(sUniformHandle<UNIFORM_TYPE_INT> handle, int value);
+		void setUniform(sUniformHandle<UNIFORM_TYPE_BOOL> handle, bool value);
+		void setUniform(sUniformHandle<UNIFORM_TYPE_VEC3> handle, const glm::vec3& value);
+		void setUniform(sUniformHandle<UNIFORM_TYPE_VEC4> handle, const glm::vec4& value);
+		void setUniform(sUniformHandle<UNIFORM_TYPE_MAT4> handle, const glm::mat4& value);
+
+	private:
+
+		bool m_ResolveUniform(const std::string& name, eUniformType uniformType, unsigned int& index);
+
 	};
 
 	cShaderManager();
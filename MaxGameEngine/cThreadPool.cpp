@@ -0,0 +1,92 @@
+#include "cThreadPool.h"
+
+cThreadPool::cThreadPool(unsigned int numberOfThreads)
+{
+	this->m_numberOfBusyWorkers = 0;
+	this->m_bShuttingDown = false;
+
+	if (numberOfThreads == 0)
+	{
+		unsigned int numberOfCores = std::thread::hardware_concurrency();
+
+		numberOfThreads = (numberOfCores > 1) ? numberOfCores - 1 : 1;
+	}
+
+	for (unsigned int index = 0; index != numberOfThreads; index++)
+		this->m_vecWorkers.push_back(std::thread(&cThreadPool::m_WorkerLoop, this));
+}
+
+cThreadPool::~cThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(this->m_queueMutex);
+		this->m_bShuttingDown = true;
+	}
+
+	this->m_taskAdded.notify_all();
+
+	for (unsigned int index = 0; index != this->m_vecWorkers.size(); index++)
+		this->m_vecWorkers[index].join();
+}
+
+void cThreadPool::AddTask(std::function<void()> task)
+{
+	{
+		std::unique_lock<std::mutex> lock(this->m_queueMutex);
+		this->m_taskQueue.push_back(task);
+	}
+
+	this->m_taskAdded.notify_one();
+
+	return;
+}
+
+void cThreadPool::WaitForAllTasks(void)
+{
+	std::unique_lock<std::mutex> lock(this->m_queueMutex);
+
+	while (!this->m_taskQueue.empty() || this->m_numberOfBusyWorkers != 0)
+		this->m_allTasksDone.wait(lock);
+
+	return;
+}
+
+unsigned int cThreadPool::getNumberOfThreads(void) const
+{
+	return (unsigned int)this->m_vecWorkers.size();
+}
+
+void cThreadPool::m_WorkerLoop(void)
+{
+	while (true)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(this->m_queueMutex);
+
+			while (this->m_taskQueue.empty() && !this->m_bShuttingDown)
+				this->m_taskAdded.wait(lock);
+
+			// Queued tasks are still finished before shutting down
+			if (this->m_taskQueue.empty())
+				return;
+
+			task = this->m_taskQueue.front();
+			this->m_taskQueue.pop_front();
+
+			this->m_numberOfBusyWorkers++;
+		}
+
+		task();
+
+		{
+			std::unique_lock<std::mutex> lock(this->m_queueMutex);
+
+			this->m_numberOfBusyWorkers--;
+
+			if (this->m_taskQueue.empty() && this->m_numberOfBusyWorkers == 0)
+				this->m_allTasksDone.notify_all();
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#ifndef _cThreadPool_HG_
+#define _cThreadPool_HG_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads pulling tasks from one queue.
+// Tasks must not touch GL (the context only lives on the main thread).
+class cThreadPool
+{
+public:
+
+	// 0 = one thread per core, leaving one for the main thread
+	cThreadPool(unsigned int numberOfThreads = 0);
+	~cThreadPool();
+
+	void AddTask(std::function<void()> task);
+
+	// Blocks until the queue is empty and every worker is idle
+	void WaitForAllTasks(void);
+
+	unsigned int getNumberOfThreads(void) const;
+
+private:
+
+	// Not copyable (owns the threads)
+	cThreadPool(const cThreadPool&);
+	cThreadPool& operator=(const cThreadPool&);
+
+	void m_WorkerLoop(void);
+
+	std::vector<std::thread> m_vecWorkers;
+
+	std::deque< std::function<void()> > m_taskQueue;
+
+	std::mutex m_queueMutex;
+	std::condition_variable m_taskAdded;
+	std::condition_variable m_allTasksDone;
+
+	unsigned int m_numberOfBusyWorkers;
+	bool m_bShuttingDown;
+};
+
+#endif
@@ -0,0 +1,329 @@
+#include "cTransformHierarchy.h"
+
+#include <algorithm>
+#include <chrono>
+
+cTransformHierarchy::cTransformHierarchy()
+{
+	this->m_bLayoutDirty = false;
+	this->m_bRecomputeAll = false;
+}
+
+cTransformHierarchy::~cTransformHierarchy()
+{
+	for (unsigned int index = 0; index != this->m_vecMeshes.size(); index++)
+	{
+		this->m_vecMeshes[index]->m_pHierarchy = NULL;
+		this->m_vecMeshes[index]->m_pParent = NULL;
+	}
+}
+
+void cTransformHierarchy::AddMesh(cMesh* pMesh)
+{
+	if (pMesh == NULL || pMesh->m_pHierarchy != NULL)
+		return;
+
+	pMesh->m_pHierarchy = this;
+	pMesh->m_pParent = NULL;
+	pMesh->m_bWorldMatrixDirty = true;
+
+	this->m_vecMeshes.push_back(pMesh);
+
+	this->m_bLayoutDirty = true;
+
+	return;
+}
+
+void cTransformHierarchy::RemoveMesh(cMesh* pMesh)
+{
+	if (pMesh == NULL || pMesh->m_pHierarchy != this)
+		return;
+
+	this->setParent(pMesh, NULL);
+
+	for (unsigned int index = 0; index != pMesh->vec_pChildMeshes.size(); index++)
+	{
+		cMesh* pChild = pMesh->vec_pChildMeshes[index];
+
+		pChild->m_pParent = NULL;
+		pChild->m_bWorldMatrixDirty = true;
+	}
+
+	pMesh->vec_pChildMeshes.clear();
+
+	this->m_vecMeshes.erase(std::remove(this->m_vecMeshes.begin(), this->m_vecMeshes.end(), pMesh), this->m_vecMeshes.end());
+
+	// On its own from here, getWorldMatrix goes back to the local matrix
+	pMesh->m_pHierarchy = NULL;
+	pMesh->m_bWorldMatrixDirty = true;
+
+	this->m_bLayoutDirty = true;
+
+	return;
+}
+
+bool cTransformHierarchy::setParent(cMesh* pChild, cMesh* pParent)
+{
+	if (pChild == NULL || pChild->m_pHierarchy != this)
+		return false;
+
+	if (pParent != NULL)
+	{
+		if (pParent->m_pHierarchy != this)
+			return false;
+
+		// Would make a loop
+		for (cMesh* pAncestor = pParent; pAncestor != NULL; pAncestor = pAncestor->m_pParent)
+		{
+			if (pAncestor == pChild)
+				return false;
+		}
+	}
+
+	if (pChild->m_pParent == pParent)
+		return true;
+
+	if (pChild->m_pParent != NULL)
+	{
+		std::vector<cMesh*>& vecSiblings = pChild->m_pParent->vec_pChildMeshes;
+
+		vecSiblings.erase(std::remove(vecSiblings.begin(), vecSiblings.end(), pChild), vecSiblings.end());
+	}
+
+	pChild->m_pParent = pParent;
+
+	if (pParent != NULL)
+		pParent->vec_pChildMeshes.push_back(pChild);
+
+	this->m_bLayoutDirty = true;
+
+	return true;
+}
+
+void cTransformHierarchy::Update(cThreadPool* pThreadPool)
+{
+	std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+
+	if (this->m_bLayoutDirty)
+		this->m_Rebuild();
+
+	this->m_lastStats = sTransformHierarchyStats();
+	this->m_lastStats.numberOfMeshes = (unsigned int)this->m_vecNodes.size();
+	this->m_lastStats.numberOfSubtrees = (unsigned int)this->m_vecSubtrees.size();
+	this->m_lastStats.numberOfThreads = 1;
+
+	//------------------------Which subtrees to walk------------------------------------------
+
+	this->m_vecDirtySubtrees.clear();
+
+	unsigned int numberOfDirtyNodes = 0;
+
+	for (unsigned int subtree = 0; subtree != this->m_vecSubtrees.size(); subtree++)
+	{
+		if (this->m_vecSubtrees[subtree].bDirty)
+		{
+			this->m_vecDirtySubtrees.push_back(subtree);
+			numberOfDirtyNodes += this->m_vecSubtrees[subtree].numberOfNodes;
+		}
+	}
+
+	//------------------------Walk them------------------------------------------------------
+
+	if (pThreadPool != NULL && numberOfDirtyNodes >= 2 * MIN_MESHES_PER_TASK && this->m_vecDirtySubtrees.size() > 1)
+	{
+		unsigned int numberOfTasks = std::min(pThreadPool->getNumberOfThreads(), numberOfDirtyNodes / MIN_MESHES_PER_TASK);
+		unsigned int nodesPerTask = (numberOfDirtyNodes + numberOfTasks - 1) / numberOfTasks;
+
+		// Whole subtrees per task, about nodesPerTask meshes each
+		unsigned int firstDirty = 0;
+
+		this->m_lastStats.numberOfThreads = 0;
+
+		while (firstDirty != this->m_vecDirtySubtrees.size())
+		{
+			unsigned int lastDirty = firstDirty;
+			unsigned int taskNodes = 0;
+
+			while (lastDirty != this->m_vecDirtySubtrees.size() && taskNodes < nodesPerTask)
+			{
+				taskNodes += this->m_vecSubtrees[this->m_vecDirtySubtrees[lastDirty]].numberOfNodes;
+				lastDirty++;
+			}
+
+			pThreadPool->AddTask([this, firstDirty, lastDirty]()
+				{
+					for (unsigned int dirty = firstDirty; dirty != lastDirty; dirty++)
+						this->m_UpdateSubtree(this->m_vecDirtySubtrees[dirty]);
+				});
+
+			this->m_lastStats.numberOfThreads++;
+
+			firstDirty = lastDirty;
+		}
+
+		pThreadPool->WaitForAllTasks();
+	}
+	else
+	{
+		for (unsigned int dirty = 0; dirty != this->m_vecDirtySubtrees.size(); dirty++)
+			this->m_UpdateSubtree(this->m_vecDirtySubtrees[dirty]);
+	}
+
+	this->m_bRecomputeAll = false;
+
+	this->m_lastStats.numberOfDirtySubtrees = (unsigned int)this->m_vecDirtySubtrees.size();
+
+	for (unsigned int dirty = 0; dirty != this->m_vecDirtySubtrees.size(); dirty++)
+		this->m_lastStats.numberOfMatricesUpdated += this->m_vecSubtrees[this->m_vecDirtySubtrees[dirty]].numberOfMatricesUpdated;
+
+	this->m_lastStats.updateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - updateStart).count();
+
+	return;
+}
+
+void cTransformHierarchy::UpdateMesh(cMesh* pMesh)
+{
+	if (pMesh == NULL || pMesh->m_pHierarchy != this)
+		return;
+
+	// The node numbers are only valid after a rebuild. The other subtrees stay dirty
+	//	(and m_bRecomputeAll set) until the next Update.
+	if (this->m_bLayoutDirty)
+		this->m_Rebuild();
+
+	unsigned int subtree = this->m_vecNodes[pMesh->m_hierarchyNode].subtree;
+
+	if (this->m_vecSubtrees[subtree].bDirty)
+		this->m_UpdateSubtree(subtree);
+
+	return;
+}
+
+sTransformHierarchyStats cTransformHierarchy::getLastStats(void) const
+{
+	return this->m_lastStats;
+}
+
+void cTransformHierarchy::m_MarkNodeDirty(unsigned int node)
+{
+	// Everything is walked after a rebuild anyway
+	if (this->m_bLayoutDirty)
+		return;
+
+	this->m_vecSubtrees[this->m_vecNodes[node].subtree].bDirty = true;
+
+	return;
+}
+
+void cTransformHierarchy::m_Rebuild(void)
+{
+	this->m_vecNodes.clear();
+	this->m_vecSubtrees.clear();
+
+	for (unsigned int index = 0; index != this->m_vecMeshes.size(); index++)
+	{
+		cMesh* pRoot = this->m_vecMeshes[index];
+
+		if (pRoot->m_pParent != NULL)
+			continue;
+
+		sSubtree newSubtree;
+
+		newSubtree.firstNode = (unsigned int)this->m_vecNodes.size();
+		newSubtree.bDirty = true;
+		newSubtree.numberOfMatricesUpdated = 0;
+
+		unsigned int subtree = (unsigned int)this->m_vecSubtrees.size();
+
+		sTransformNode rootNode;
+
+		rootNode.pMesh = pRoot;
+		rootNode.parentNode = NO_PARENT;
+		rootNode.subtree = subtree;
+
+		this->m_vecNodes.push_back(rootNode);
+
+		// Breadth first, using the nodes added so far as the queue : depth sorted
+		for (unsigned int node = newSubtree.firstNode; node != this->m_vecNodes.size(); node++)
+		{
+			cMesh* pMesh = this->m_vecNodes[node].pMesh;
+
+			pMesh->m_hierarchyNode = node;
+
+			for (unsigned int child = 0; child != pMesh->vec_pChildMeshes.size(); child++)
+			{
+				sTransformNode childNode;
+
+				childNode.pMesh = pMesh->vec_pChildMeshes[child];
+				childNode.parentNode = node;
+				childNode.subtree = subtree;
+
+				this->m_vecNodes.push_back(childNode);
+			}
+		}
+
+		newSubtree.numberOfNodes = (unsigned int)this->m_vecNodes.size() - newSubtree.firstNode;
+
+		this->m_vecSubtrees.push_back(newSubtree);
+	}
+
+	this->m_vecNodeChanged.assign(this->m_vecNodes.size(), 0);
+
+	this->m_bLayoutDirty = false;
+	this->m_bRecomputeAll = true;
+
+	return;
+}
+
+void cTransformHierarchy::m_UpdateSubtree(unsigned int subtree)
+{
+	sSubtree& theSubtree = this->m_vecSubtrees[subtree];
+
+	unsigned int numberOfMatricesUpdated = 0;
+
+	for (unsigned int node = theSubtree.firstNode; node != theSubtree.firstNode + theSubtree.numberOfNodes; node++)
+	{
+		const sTransformNode& theNode = this->m_vecNodes[node];
+		cMesh* pMesh = theNode.pMesh;
+
+		// Not m_bLocalMatrixDirty, getLocalMatrix may have cleared that since the setter
+		bool bChanged = this->m_bRecomputeAll || pMesh->m_bWorldMatrixDirty;
+
+		// The parent is earlier in the array, already done
+		if (theNode.parentNode != NO_PARENT && this->m_vecNodeChanged[theNode.parentNode])
+			bChanged = true;
+
+		this->m_vecNodeChanged[node] = bChanged ? 1 : 0;
+
+		if (!bChanged)
+			continue;
+
+		pMesh->m_UpdateLocalMatrix();
+
+		pMesh->m_bWorldMatrixDirty = false;
+
+		if (theNode.parentNode == NO_PARENT)
+		{
+			pMesh->m_matWorld = pMesh->m_matLocal;
+			pMesh->m_matWorldNormal = pMesh->m_matLocalNormal;
+		}
+		else
+		{
+			const cMesh* pParent = this->m_vecNodes[theNode.parentNode].pMesh;
+
+			pMesh->m_matWorld = pParent->m_matWorld * pMesh->m_matLocal;
+
+			// (A * B)^-T = A^-T * B^-T
+			pMesh->m_matWorldNormal = pParent->m_matWorldNormal * pMesh->m_matLocalNormal;
+		}
+
+		pMesh->m_worldVersion++;
+
+		numberOfMatricesUpdated++;
+	}
+
+	theSubtree.bDirty = false;
+	theSubtree.numberOfMatricesUpdated = numberOfMatricesUpdated;
+
+	return;
+}
@@ -0,0 +1,104 @@
+#ifndef _cTransformHierarchy_HG_
+#define _cTransformHierarchy_HG_
+
+#include <vector>
+
+#include "cMesh.h"
+#include "cThreadPool.h"
+
+// What the last Update did
+struct sTransformHierarchyStats
+{
+	unsigned int numberOfMeshes = 0;
+	unsigned int numberOfSubtrees = 0;			// Roots, each with everything attached to it
+	unsigned int numberOfDirtySubtrees = 0;		// Had a mesh that moved, turned or was scaled
+	unsigned int numberOfMatricesUpdated = 0;
+	unsigned int numberOfThreads = 0;			// 1 = updated on the main thread
+
+	double updateTime = 0.0;					// Seconds, wall clock
+};
+
+// Parent / child links between meshes. A child's position, orientation and scale are relative
+//	to its parent, Update works out every mesh's world matrix (cMesh::getWorldMatrix).
+// The meshes are kept flattened, one root's subtree after the other, each subtree sorted by
+//	depth so a parent always comes before its children. A transform setter marks its
+//	subtree dirty and Update only walks those; a subtree that didn't change costs nothing.
+//	Subtrees don't share anything, so big updates are split across the thread pool.
+// Main thread only, apart from the tasks Update runs.
+class cTransformHierarchy
+{
+public:
+
+	// Dirty subtrees with fewer meshes than this in total are updated on the calling thread
+	static const unsigned int MIN_MESHES_PER_TASK = 1024;
+
+	cTransformHierarchy();
+	~cTransformHierarchy();
+
+	// As a root. A mesh can only be in one hierarchy.
+	void AddMesh(cMesh* pMesh);
+
+	// Its children become roots (keeping their local transforms)
+	void RemoveMesh(cMesh* pMesh);
+
+	// pParent = NULL makes pChild a root. pChild's transform is relative to pParent from then on.
+	//	False if either isn't in this hierarchy or pParent is pChild or one of its children.
+	bool setParent(cMesh* pChild, cMesh* pParent);
+
+	// Brings the world matrices of every dirty subtree up to date. pThreadPool can be NULL.
+	void Update(cThreadPool* pThreadPool);
+
+	// Only pMesh's subtree, for queries between frames. Doesn't touch getLastStats.
+	void UpdateMesh(cMesh* pMesh);
+
+	sTransformHierarchyStats getLastStats(void) const;
+
+private:
+
+	static const unsigned int NO_PARENT = ~0u;
+
+	struct sTransformNode
+	{
+		cMesh* pMesh;
+		unsigned int parentNode;		// NO_PARENT for the root
+		unsigned int subtree;
+	};
+
+	struct sSubtree
+	{
+		unsigned int firstNode;
+		unsigned int numberOfNodes;
+		bool bDirty;
+		unsigned int numberOfMatricesUpdated;		// By the last Update
+	};
+
+	// Not copyable (the meshes point back at it)
+	cTransformHierarchy(const cTransformHierarchy&);
+	cTransformHierarchy& operator=(const cTransformHierarchy&);
+
+	// cMesh's transform setters
+	friend class cMesh;
+	void m_MarkNodeDirty(unsigned int node);
+
+	// Flattens the meshes again after links changed
+	void m_Rebuild(void);
+
+	void m_UpdateSubtree(unsigned int subtree);
+
+	std::vector<cMesh*> m_vecMeshes;				// In the order they were added
+
+	std::vector<sTransformNode> m_vecNodes;
+	std::vector<sSubtree> m_vecSubtrees;
+
+	// Whether the node's world matrix changed in this Update (its children's have to as well)
+	std::vector<unsigned char> m_vecNodeChanged;
+
+	bool m_bLayoutDirty;
+	bool m_bRecomputeAll;				// After a rebuild, parents may have changed anywhere
+
+	std::vector<unsigned int> m_vecDirtySubtrees;
+
+	sTransformHierarchyStats m_lastStats;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "cUniformBufferRing.h"
+
+#include "../OpenGLCommon.h"
+
+cUniformBufferRing::cUniformBufferRing()
+{
+	this->m_entryStride = 0;
+	this->m_capacity = 0;
+	this->m_numberOfEntries = 0;
+	this->m_offsetAlignment = 256;
+	this->m_regionSize = 0;
+
+	this->m_target = GL_UNIFORM_BUFFER;
+
+	this->m_bPersistent = false;
+	this->m_pMapped = NULL;
+	this->m_currentRegion = 0;
+
+	for (unsigned int region = 0; region != REGIONS; region++)
+		this->m_regionFences[region] = NULL;
+}
+
+cUniformBufferRing::~cUniformBufferRing()
+{
+	this->Reset();
+}
+
+void cUniformBufferRing::Create(unsigned int entrySize, unsigned int numberOfEntries, bool bShaderStorage /*= false*/)
+{
+	this->Reset();
+
+	this->m_target = bShaderStorage ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+
+	GLint offsetAlignment = 256;
+	glGetIntegerv(bShaderStorage ? GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT : GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+
+	if (offsetAlignment < 1)
+		offsetAlignment = 256;
+
+	this->m_offsetAlignment = (unsigned int)offsetAlignment;
+
+	// An array only has to start aligned, its entries are packed
+	if (bShaderStorage)
+		this->m_entryStride = entrySize;
+	else
+		this->m_entryStride = ((entrySize + offsetAlignment - 1) / offsetAlignment) * offsetAlignment;
+	this->m_capacity = (numberOfEntries > 0) ? numberOfEntries : 1;
+
+	this->m_CreateBuffer();
+
+	return;
+}
+
+unsigned char* cUniformBufferRing::BeginFrame(unsigned int numberOfEntries)
+{
+	if (numberOfEntries > this->m_capacity)
+	{
+		while (this->m_capacity < numberOfEntries)
+			this->m_capacity *= 2;
+
+		// The old buffer's storage lives on until the GPU is done with it
+		this->m_CreateBuffer();
+	}
+
+	this->m_numberOfEntries = numberOfEntries;
+
+	if (!this->m_bPersistent)
+	{
+		this->m_vecStaging.resize((std::size_t)this->m_entryStride * numberOfEntries);
+		return this->m_vecStaging.data();
+	}
+
+	// Everything drawn since the last frame used the current region
+	if (this->m_regionFences[this->m_currentRegion] != NULL)
+		glDeleteSync((GLsync)this->m_regionFences[this->m_currentRegion]);
+
+	this->m_regionFences[this->m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	this->m_currentRegion = (this->m_currentRegion + 1) % REGIONS;
+
+	GLsync regionFence = (GLsync)this->m_regionFences[this->m_currentRegion];
+
+	if (regionFence != NULL)
+	{
+		GLenum waitResult = glClientWaitSync(regionFence, 0, 0);
+
+		GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+		while (waitResult == GL_TIMEOUT_EXPIRED)
+		{
+			waitResult = glClientWaitSync(regionFence, waitFlags, 1000000);		// 1 ms in nanoseconds
+			waitFlags = 0;
+		}
+
+		glDeleteSync(regionFence);
+
+		this->m_regionFences[this->m_currentRegion] = NULL;
+	}
+
+	return this->m_pMapped + (std::size_t)this->m_currentRegion * this->m_regionSize;
+}
+
+void cUniformBufferRing::EndFrame(void)
+{
+	if (this->m_bPersistent || this->m_numberOfEntries == 0)
+		return;
+
+	glBindBuffer(this->m_target, this->m_buffer.getID());
+
+	// Orphaned, so the draws of the previous frame keep their copy
+	glBufferData(this->m_target, (GLsizeiptr)this->m_regionSize, NULL, GL_STREAM_DRAW);
+
+	glBufferSubData(this->m_target, 0, (GLsizeiptr)this->m_entryStride * this->m_numberOfEntries, this->m_vecStaging.data());
+
+	glBindBuffer(this->m_target, 0);
+
+	return;
+}
+
+void cUniformBufferRing::BindFrame(unsigned int bindingPoint)
+{
+	// A zero sized range isn't allowed, bind one entry's worth when there's nothing
+	unsigned int numberOfEntries = (this->m_numberOfEntries > 0) ? this->m_numberOfEntries : 1;
+
+	std::size_t regionOffset = this->m_bPersistent ? (std::size_t)this->m_currentRegion * this->m_regionSize : 0;
+
+	glBindBufferRange(this->m_target, bindingPoint, this->m_buffer.getID(),
+		(GLintptr)regionOffset,
+		(GLsizeiptr)this->m_entryStride * numberOfEntries);
+
+	return;
+}
+
+unsigned int cUniformBufferRing::getEntryStride(void) const
+{
+	return this->m_entryStride;
+}
+
+void cUniformBufferRing::Reset(void)
+{
+	for (unsigned int region = 0; region != REGIONS; region++)
+	{
+		if (this->m_regionFences[region] != NULL)
+			glDeleteSync((GLsync)this->m_regionFences[region]);
+
+		this->m_regionFences[region] = NULL;
+	}
+
+	// Deleting the buffer unmaps it
+	this->m_pMapped = NULL;
+	this->m_bPersistent = false;
+	this->m_currentRegion = 0;
+
+	this->m_buffer.Reset();
+
+	return;
+}
+
+void cUniformBufferRing::m_CreateBuffer(void)
+{
+	for (unsigned int region = 0; region != REGIONS; region++)
+	{
+		if (this->m_regionFences[region] != NULL)
+			glDeleteSync((GLsync)this->m_regionFences[region]);
+
+		this->m_regionFences[region] = NULL;
+	}
+
+	this->m_pMapped = NULL;
+	this->m_currentRegion = 0;
+
+	this->m_buffer.Create();
+
+	glBindBuffer(this->m_target, this->m_buffer.getID());
+
+	// Each region has to start aligned for BindFrame
+	this->m_regionSize = this->m_entryStride * this->m_capacity;
+	this->m_regionSize = ((this->m_regionSize + this->m_offsetAlignment - 1) / this->m_offsetAlignment) * this->m_offsetAlignment;
+
+	GLsizeiptr regionBytes = (GLsizeiptr)this->m_regionSize;
+
+	this->m_bPersistent = false;
+
+	if (GLAD_GL_VERSION_4_4 && glBufferStorage != NULL)
+	{
+		const GLbitfield mapFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(this->m_target, regionBytes * REGIONS, NULL, mapFlags);
+
+		this->m_pMapped = (unsigned char*)glMapBufferRange(this->m_target, 0, regionBytes * REGIONS, mapFlags);
+
+		this->m_bPersistent = (this->m_pMapped != NULL);
+
+		// Immutable storage can't be orphaned, start over with a plain buffer
+		if (!this->m_bPersistent)
+		{
+			this->m_buffer.Create();
+			glBindBuffer(this->m_target, this->m_buffer.getID());
+		}
+	}
+
+	if (!this->m_bPersistent)
+		glBufferData(this->m_target, regionBytes, NULL, GL_STREAM_DRAW);
+
+	glBindBuffer(this->m_target, 0);
+
+	return;
+}
@@ -0,0 +1,69 @@
+#ifndef _cUniformBufferRing_HG_
+#define _cUniformBufferRing_HG_
+
+#include <vector>
+
+#include "cGLResource.h"
+
+// Per draw data for a whole frame in one buffer, bound all at once with BindFrame.
+// As a shader storage buffer (what the engine's Instances array uses) the entries are
+//	a tightly packed std430 array, the entry size a multiple of 16. As a uniform buffer
+//	they're padded to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+// With GL 4.4 the buffer holds REGIONS frames, persistently mapped; a frame writes
+//	its region directly and a fence after its draws keeps it from being overwritten
+//	while the GPU still reads it. Without 4.4 the entries are staged and the buffer
+//	is orphaned and uploaded once per frame.
+// Main thread only (GL calls).
+class cUniformBufferRing
+{
+public:
+
+	static const unsigned int REGIONS = 3;
+
+	cUniformBufferRing();
+	~cUniformBufferRing();
+
+	// entrySize is the block's size; numberOfEntries per frame to start with (it grows)
+	void Create(unsigned int entrySize, unsigned int numberOfEntries, bool bShaderStorage = false);
+
+	// Where this frame's numberOfEntries entries go (entry i at i * getEntryStride()).
+	//	Write only: it can be mapped GPU memory.
+	unsigned char* BeginFrame(unsigned int numberOfEntries);
+
+	// Uploads the staged entries (no-op when mapped)
+	void EndFrame(void);
+
+	// glBindBufferRange of all of this frame's entries
+	void BindFrame(unsigned int bindingPoint);
+
+	unsigned int getEntryStride(void) const;
+
+	void Reset(void);
+
+private:
+
+	cUniformBufferRing(const cUniformBufferRing&);
+	cUniformBufferRing& operator=(const cUniformBufferRing&);
+
+	// (Re)creates the buffer for m_capacity entries per region
+	void m_CreateBuffer(void);
+
+	unsigned int m_entryStride;
+	unsigned int m_capacity;			// Entries per region
+	unsigned int m_numberOfEntries;		// This frame's
+	unsigned int m_offsetAlignment;
+	unsigned int m_regionSize;			// Bytes, m_capacity entries rounded up to m_offsetAlignment
+
+	unsigned int m_target;				// GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+
+	cGLBuffer m_buffer;
+
+	bool m_bPersistent;
+	unsigned char* m_pMapped;
+	unsigned int m_currentRegion;
+	void* m_regionFences[REGIONS];		// GLsync
+
+	std::vector<unsigned char> m_vecStaging;
+};
+
+#endif
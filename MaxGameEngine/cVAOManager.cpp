@@ -1,4 +1,10 @@
 #include "cVAOManager.h"
+#include "cMappedFile.h"
+#include "cCookedMeshFile.h"
+#include "cPlyFileReader.h"
+#include "cVertexFormat.h"
+#include "cMeshOptimizer.h"
+#include "cMeshSimplifier.h"
 
 #include "../OpenGLCommon.h"
 
@@ -6,8 +12,18 @@
 #include <glm/vec4.hpp>
 
 #include <vector>
-#include <sstream>
-#include <fstream>
+#include <algorithm>
+#include <iostream>
+
+std::string cVAOManager::getLastError(bool bAndClear)
+{
+    std::string theLastError = this->m_lastError;
+
+    if (bAndClear)
+        this->m_lastError = "";
+
+    return theLastError;
+}
 
 void cVAOManager::setBasePath(std::string basePathWithoutSlash)
 {
@@ -15,194 +31,551 @@ void cVAOManager::setBasePath(std::string basePathWithoutSlash)
     return;
 }
 
+void cVAOManager::setVertexFormat(eVertexFormat vertexFormat)
+{
+    this->m_vertexFormat = vertexFormat;
+    return;
+}
+
+eVertexFormat cVAOManager::getVertexFormat(void)
+{
+    return this->m_vertexFormat;
+}
+
+void cVAOManager::setOptimizeMeshes(bool bOptimizeMeshes)
+{
+    this->m_bOptimizeMeshes = bOptimizeMeshes;
+    return;
+}
+
+void cVAOManager::setSplitLargeMeshes(bool bSplitLargeMeshes)
+{
+    this->m_bSplitLargeMeshes = bSplitLargeMeshes;
+    return;
+}
+
+void cVAOManager::setGenerateLODs(bool bGenerateLODs)
+{
+    this->m_bGenerateLODs = bGenerateLODs;
+    return;
+}
+
+cVAOManager::sSharedModel::sSharedModel()
+{
+    this->referenceCount = 0;
+    this->arenaAllocationID = cGeometryArena::INVALID_ALLOCATION;
+    this->bIsDynamic = false;
+}
+
 bool cVAOManager::LoadModelIntoVAO(std::string friendlyName, std::string fileName, sModelDrawInfo& drawInfo, unsigned int shaderProgramID, bool bIsDynamicBuffer)
 {
-    drawInfo.meshFileName = fileName;
+    // Already loaded by another model, hand back the same VAO
+    if (this->FindDrawInfoByModelName(fileName, drawInfo))
+        return true;
+
+    if (!this->ReadModelFile(fileName, drawInfo, this->m_lastError))
+        return false;
 
     drawInfo.friendlyName = friendlyName;
 
+    return this->UploadModelToVAO(fileName, drawInfo, shaderProgramID, bIsDynamicBuffer);
+}
+
+bool cVAOManager::ReadModelFile(std::string fileName, sModelDrawInfo& drawInfo, std::string& errorText)
+{
+    drawInfo.meshFileName = fileName;
+
+    drawInfo.friendlyName = fileName;
+
     std::string fileAndPath = this->m_basePathWithoutSlash + "/" + fileName;
 
-    if (!this->m_LoadTheFile_Ply_XYZ_N_RGBA(fileAndPath, drawInfo))
+    cCookedMeshFile theCookedFile;
+
+    unsigned int cookedFlags = 0;
+
+    if (this->m_bOptimizeMeshes)
+        cookedFlags |= cCookedMeshFile::COOKED_FLAG_OPTIMIZED;
+
+    if (this->m_bSplitLargeMeshes)
+        cookedFlags |= cCookedMeshFile::COOKED_FLAG_SPLIT_16BIT;
+
+    if (this->m_bGenerateLODs)
+        cookedFlags |= cCookedMeshFile::COOKED_FLAG_LODS;
+
+    // A cooked file that fails its checks is just cooked again from the source
+    bool bLoadedCookedFile = theCookedFile.Open(fileAndPath, cookedFlags) && theCookedFile.CopyInto(drawInfo);
+
+    if (!bLoadedCookedFile)
     {
-        return false;
-    };
+        if (!this->m_LoadTheFile_Ply(fileAndPath, drawInfo, errorText))
+            return false;
+
+        drawInfo.calcExtents();
+
+        // Slow-ish, but the result is cooked so it only happens once per file
+        if (this->m_bOptimizeMeshes)
+            cMeshOptimizer::Optimize(drawInfo);
+
+        // Simplified levels go after LOD 0 in the same index array
+        if (this->m_bGenerateLODs)
+            cMeshSimplifier::BuildLODChain(drawInfo);
+
+        if (this->m_bSplitLargeMeshes)
+            cMeshOptimizer::SplitFor16BitIndices(drawInfo);
+
+        // Not fatal, the mesh just gets parsed again next time
+        std::string cookError;
+
+        if (!cCookedMeshFile::Write(fileAndPath, drawInfo, cookedFlags, cookError))
+            std::cout << "Warning : " << cookError << std::endl;
+    }
+
+    cVertexFormat::PackVertices(this->m_vertexFormat, drawInfo);
+
+    cVertexFormat::PackIndices(this->m_bSplitLargeMeshes, drawInfo);
 
-    glGenVertexArrays(1, &(drawInfo.VAO_ID));
+    return true;
+}
+
+bool cVAOManager::UploadModelToVAO(std::string fileName, sModelDrawInfo& drawInfo, unsigned int shaderProgramID, bool bIsDynamicBuffer)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
+
+    // Already uploaded : drop the arrays that were just read and share the existing VAO
+    if (itModel != this->m_map_FileName_to_Model.end())
+    {
+        if (drawInfo.pVertices != itModel->second.drawInfo.pVertices)
+        {
+            delete[] drawInfo.pVertices;
+            delete[] drawInfo.pIndices;
+            delete[] drawInfo.pPackedVertices;
+            delete[] drawInfo.pPackedIndices;
+        }
+
+        drawInfo = itModel->second.drawInfo;
+        return true;
+    }
+
+    // Packed formats upload the packed copy, the float format is pVertices itself
+    const GLvoid* pVertexData = (drawInfo.pPackedVertices != NULL) ? (const GLvoid*)drawInfo.pPackedVertices : (const GLvoid*)drawInfo.pVertices;
+
+    // 16 bit meshes upload the packed copy
+    const GLvoid* pIndexData = (drawInfo.pPackedIndices != NULL) ? (const GLvoid*)drawInfo.pPackedIndices : (const GLvoid*)drawInfo.pIndices;
+
+    sSharedModel& newModel = this->m_map_FileName_to_Model[fileName];
+
+    //--------------------------Static models share the arena's buffers------------------------
+
+    if (this->m_bUseGeometryArena && !bIsDynamicBuffer)
+    {
+        newModel.arenaAllocationID = this->m_geometryArenas[drawInfo.vertexFormat].Allocate(drawInfo.vertexFormat, shaderProgramID,
+            pVertexData, drawInfo.numberOfVertices,
+            pIndexData, drawInfo.indexSize * drawInfo.numberOfIndices);
+
+        if (newModel.arenaAllocationID != cGeometryArena::INVALID_ALLOCATION)
+        {
+            delete[] drawInfo.pPackedVertices;
+            drawInfo.pPackedVertices = NULL;
+
+            delete[] drawInfo.pPackedIndices;
+            drawInfo.pPackedIndices = NULL;
+
+            newModel.drawInfo = drawInfo;
+
+            this->m_UpdateArenaDrawInfo();
+
+            drawInfo = newModel.drawInfo;
+
+            return true;
+        }
+
+        // Falls back to buffers of its own
+        std::cout << "Warning : " << fileName << " doesn't fit in the geometry arena" << std::endl;
+    }
+
+    //--------------------------Buffers of its own---------------------------------------------
+
+    newModel.vertexArray.Create();
+    drawInfo.VAO_ID = newModel.vertexArray.getID();
 
     glBindVertexArray(drawInfo.VAO_ID);
 
-    glGenBuffers(1, &(drawInfo.VertexBufferID));
+    if (bIsDynamicBuffer)
+    {
+        // Packs from pVertices itself (and keeps it for the updates)
+        newModel.bIsDynamic = true;
+        newModel.dynamicVertexBuffer.Create(this->m_dynamicBufferStrategy, drawInfo.vertexFormat, drawInfo.pVertices, drawInfo.numberOfVertices);
+
+        drawInfo.VertexBufferID = newModel.dynamicVertexBuffer.getBufferID();
+        drawInfo.VertexBuffer_Start_Index = 0;
+
+        glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
+    }
+    else
+    {
+        newModel.vertexBuffer.Create();
+        drawInfo.VertexBufferID = newModel.vertexBuffer.getID();
 
-    glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
+        glBindBuffer(GL_ARRAY_BUFFER, drawInfo.VertexBufferID);
 
-    glBufferData(GL_ARRAY_BUFFER,
-        sizeof(sVertex) * drawInfo.numberOfVertices,
-        (GLvoid*)drawInfo.pVertices,
-        (bIsDynamicBuffer ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW));
+        glBufferData(GL_ARRAY_BUFFER,
+            drawInfo.vertexStride * drawInfo.numberOfVertices,
+            pVertexData,
+            GL_STATIC_DRAW);
+    }
 
-    glGenBuffers(1, &(drawInfo.IndexBufferID));
+    newModel.indexBuffer.Create();
+    drawInfo.IndexBufferID = newModel.indexBuffer.getID();
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawInfo.IndexBufferID);
 
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-        sizeof(unsigned int) * drawInfo.numberOfIndices,
-        (GLvoid*)drawInfo.pIndices,
+        drawInfo.indexSize * drawInfo.numberOfIndices,
+        pIndexData,
         GL_STATIC_DRAW);
 
-    GLint vpos_location = glGetAttribLocation(shaderProgramID, "vPos");
-    GLint vcol_location = glGetAttribLocation(shaderProgramID, "vCol");
-    GLint vNormal_location = glGetAttribLocation(shaderProgramID, "vNormal");
-
-    glEnableVertexAttribArray(vpos_location);
-    glVertexAttribPointer(vpos_location, 4, GL_FLOAT, GL_FALSE, sizeof(sVertex), (void*)offsetof(sVertex, x));
-
-    glEnableVertexAttribArray(vcol_location);
-    glVertexAttribPointer(vcol_location, 4, GL_FLOAT, GL_FALSE, sizeof(sVertex), (void*)offsetof(sVertex, r));
-
-    glEnableVertexAttribArray(vNormal_location);
-    glVertexAttribPointer(vNormal_location, 4, GL_FLOAT, GL_FALSE, sizeof(sVertex), (void*)offsetof(sVertex, nx));
+    cVertexFormat::SetupAttributes(drawInfo.vertexFormat, shaderProgramID);
 
     glBindVertexArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    glDisableVertexAttribArray(vpos_location);
-    glDisableVertexAttribArray(vcol_location);
-    glDisableVertexAttribArray(vNormal_location);
+    delete[] drawInfo.pPackedVertices;
+    drawInfo.pPackedVertices = NULL;
+
+    delete[] drawInfo.pPackedIndices;
+    drawInfo.pPackedIndices = NULL;
 
-    this->m_map_ModelName_to_VAOID[drawInfo.friendlyName] = drawInfo;
+    newModel.drawInfo = drawInfo;
 
     return true;
 }
 
 bool cVAOManager::FindDrawInfoByModelName(std::string filename, sModelDrawInfo& drawInfo)
 {
-    std::map< std::string, sModelDrawInfo>::iterator itDrawInfo = this->m_map_ModelName_to_VAOID.find(filename);
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(filename);
 
-    if (itDrawInfo == this->m_map_ModelName_to_VAOID.end())
+    if (itModel == this->m_map_FileName_to_Model.end())
         return false;
 
-    drawInfo = itDrawInfo->second;
+    drawInfo = itModel->second.drawInfo;
     return true;
 }
 
-bool cVAOManager::m_LoadTheFile_Ply_XYZ_N_RGBA(std::string theFileName, sModelDrawInfo& drawInfo)
+sModelDrawInfo* cVAOManager::AcquireModel(std::string fileName, unsigned int shaderProgramID, bool bIsDynamicBuffer)
 {
-    std::ifstream theBunnyFile(theFileName.c_str());
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
 
-    if (!theBunnyFile.is_open())
-        return false;
+    if (itModel == this->m_map_FileName_to_Model.end())
+    {
+        sModelDrawInfo newDrawInfo;
+
+        if (!this->LoadModelIntoVAO(fileName, fileName, newDrawInfo, shaderProgramID, bIsDynamicBuffer))
+            return NULL;
+
+        itModel = this->m_map_FileName_to_Model.find(fileName);
+    }
+
+    itModel->second.referenceCount++;
+
+    // std::map nodes don't move, so this stays valid while the entry exists
+    return &(itModel->second.drawInfo);
+}
+
+void cVAOManager::ReleaseModel(std::string fileName)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
+
+    if (itModel == this->m_map_FileName_to_Model.end())
+        return;
+
+    if (itModel->second.referenceCount > 0)
+        itModel->second.referenceCount--;
+
+    if (itModel->second.referenceCount > 0)
+        return;
+
+    sModelDrawInfo& drawInfo = itModel->second.drawInfo;
+
+    delete[] drawInfo.pVertices;
+    delete[] drawInfo.pIndices;
+
+    // Arena space is reused by later models (CompactGeometryArenas packs the holes)
+    if (itModel->second.arenaAllocationID != cGeometryArena::INVALID_ALLOCATION)
+        this->m_geometryArenas[drawInfo.vertexFormat].Free(itModel->second.arenaAllocationID);
+
+    // The VAO and buffers of models outside the arena are deleted by the entry's cGLVertexArray / cGLBuffer / cDynamicVertexBuffer
+    this->m_map_FileName_to_Model.erase(itModel);
+
+    return;
+}
+
+unsigned int cVAOManager::getModelReferenceCount(std::string fileName)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
+
+    if (itModel == this->m_map_FileName_to_Model.end())
+        return 0;
+
+    return itModel->second.referenceCount;
+}
+
+void cVAOManager::setUseGeometryArena(bool bUseGeometryArena)
+{
+    this->m_bUseGeometryArena = bUseGeometryArena;
+    return;
+}
+
+unsigned int cVAOManager::CompactGeometryArenas(float minFragmentation, std::size_t minWastedBytes)
+{
+    unsigned int numberOfCompactions = 0;
+
+    for (unsigned int arenaIndex = 0; arenaIndex != 3; arenaIndex++)
+    {
+        if (this->m_geometryArenas[arenaIndex].CompactIfFragmented(minFragmentation, minWastedBytes))
+            numberOfCompactions++;
+    }
 
-    std::string temp;
+    if (numberOfCompactions != 0)
+        this->m_UpdateArenaDrawInfo();
+
+    return numberOfCompactions;
+}
 
-    while (theBunnyFile >> temp)
+sGeometryArenaStats cVAOManager::GetGeometryArenaStats(void)
+{
+    sGeometryArenaStats totalStats;
+
+    for (unsigned int arenaIndex = 0; arenaIndex != 3; arenaIndex++)
     {
-        if (temp == "vertex")
-            break;
-    };
+        sGeometryArenaStats arenaStats = this->m_geometryArenas[arenaIndex].getStats();
+
+        totalStats.numberOfAllocations += arenaStats.numberOfAllocations;
 
-    theBunnyFile >> drawInfo.numberOfVertices;
+        totalStats.vertexBytesCapacity += arenaStats.vertexBytesCapacity;
+        totalStats.vertexBytesUsed += arenaStats.vertexBytesUsed;
+        totalStats.largestFreeVertexBytes = std::max(totalStats.largestFreeVertexBytes, arenaStats.largestFreeVertexBytes);
+
+        totalStats.indexBytesCapacity += arenaStats.indexBytesCapacity;
+        totalStats.indexBytesUsed += arenaStats.indexBytesUsed;
+        totalStats.largestFreeIndexBytes = std::max(totalStats.largestFreeIndexBytes, arenaStats.largestFreeIndexBytes);
+
+        totalStats.vertexFragmentation = std::max(totalStats.vertexFragmentation, arenaStats.vertexFragmentation);
+        totalStats.indexFragmentation = std::max(totalStats.indexFragmentation, arenaStats.indexFragmentation);
+
+        totalStats.numberOfGrowths += arenaStats.numberOfGrowths;
+        totalStats.numberOfCompactions += arenaStats.numberOfCompactions;
+    }
+
+    return totalStats;
+}
 
-    while (theBunnyFile >> temp)
+void cVAOManager::m_UpdateArenaDrawInfo(void)
+{
+    for (std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.begin();
+        itModel != this->m_map_FileName_to_Model.end(); itModel++)
     {
-        if (temp == "face")
-            break;
-    };
+        if (itModel->second.arenaAllocationID == cGeometryArena::INVALID_ALLOCATION)
+            continue;
+
+        sModelDrawInfo& drawInfo = itModel->second.drawInfo;
+
+        const cGeometryArena& arena = this->m_geometryArenas[drawInfo.vertexFormat];
+
+        cGeometryArena::sAllocation allocation;
+
+        if (!arena.getAllocation(itModel->second.arenaAllocationID, allocation))
+            continue;
+
+        drawInfo.VAO_ID = arena.getVAO();
+        drawInfo.VertexBufferID = arena.getVertexBufferID();
+        drawInfo.IndexBufferID = arena.getIndexBufferID();
+
+        drawInfo.VertexBuffer_Start_Index = allocation.firstVertex;
+        drawInfo.IndexBuffer_Start_Index = allocation.firstIndexByte / drawInfo.indexSize;
+    }
+
+    return;
+}
+
+void cVAOManager::setDynamicBufferStrategy(eDynamicBufferStrategy dynamicBufferStrategy)
+{
+    this->m_dynamicBufferStrategy = dynamicBufferStrategy;
+    return;
+}
 
-    theBunnyFile >> drawInfo.numberOfTriangles;
+eDynamicBufferStrategy cVAOManager::getDynamicBufferStrategy(void)
+{
+    return this->m_dynamicBufferStrategy;
+}
 
-    drawInfo.numberOfIndices = drawInfo.numberOfTriangles * 3;
+bool cVAOManager::UpdateVAOBuffers(std::string fileName, sModelDrawInfo& updatedDrawInfo)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
 
-    while (theBunnyFile >> temp)
+    if (itModel == this->m_map_FileName_to_Model.end() || !itModel->second.bIsDynamic)
     {
-        if (temp == "end_header")
-            break;
-    };
+        this->m_lastError = fileName + " isn't loaded as a dynamic model";
+        return false;
+    }
 
-    struct sVertexPlyFile
+    if (updatedDrawInfo.pVertices == NULL || updatedDrawInfo.numberOfVertices != itModel->second.drawInfo.numberOfVertices)
     {
-        float x;
-        float y;
-        float z;
-        float nx, ny, nz;
-        float r, g, b, a;
-    };
+        this->m_lastError = "The updated vertices of " + fileName + " don't match the loaded number of vertices";
+        return false;
+    }
+
+    if (!this->UpdateVAOBufferRange(fileName, updatedDrawInfo.pVertices, 0, updatedDrawInfo.numberOfVertices))
+        return false;
+
+    updatedDrawInfo.VertexBuffer_Start_Index = itModel->second.drawInfo.VertexBuffer_Start_Index;
+
+    return true;
+}
+
+bool cVAOManager::UpdateVAOBufferRange(std::string fileName, const sVertex* pVertices, unsigned int firstVertex, unsigned int numberOfVertices)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
 
-    struct sTrianglePlyFile
+    if (itModel == this->m_map_FileName_to_Model.end() || !itModel->second.bIsDynamic)
     {
-        unsigned int v0, v1, v2;
-    };
+        this->m_lastError = fileName + " isn't loaded as a dynamic model";
+        return false;
+    }
 
-    sVertexPlyFile* pTheVerticesFile = new sVertexPlyFile[drawInfo.numberOfVertices];
+    sModelDrawInfo& drawInfo = itModel->second.drawInfo;
 
-    for (unsigned int index = 0; index != drawInfo.numberOfVertices; index++)
+    if (firstVertex > drawInfo.numberOfVertices || numberOfVertices > drawInfo.numberOfVertices - firstVertex)
     {
-        sVertexPlyFile tempVertex;
-        theBunnyFile >> tempVertex.x;
-        theBunnyFile >> tempVertex.y;
-        theBunnyFile >> tempVertex.z;
+        this->m_lastError = "Vertex range out of bounds for " + fileName;
+        return false;
+    }
+
+    if (pVertices != drawInfo.pVertices + firstVertex)
+        std::copy(pVertices, pVertices + numberOfVertices, drawInfo.pVertices + firstVertex);
+
+    // The ring moves the model to the copy that was just written
+    drawInfo.VertexBuffer_Start_Index = itModel->second.dynamicVertexBuffer.Update(drawInfo.pVertices, firstVertex, numberOfVertices);
+
+    return true;
+}
 
-        theBunnyFile >> tempVertex.nx;
-        theBunnyFile >> tempVertex.ny;
-        theBunnyFile >> tempVertex.nz;
+bool cVAOManager::GetDynamicBufferStats(std::string fileName, sDynamicBufferStats& dynamicBufferStats)
+{
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
 
-        theBunnyFile >> tempVertex.r;       tempVertex.r /= 255.0f;
-        theBunnyFile >> tempVertex.g;       tempVertex.g /= 255.0f;
-        theBunnyFile >> tempVertex.b;       tempVertex.b /= 255.0f;
-        theBunnyFile >> tempVertex.a;       tempVertex.a /= 255.0f;
+    if (itModel == this->m_map_FileName_to_Model.end() || !itModel->second.bIsDynamic)
+        return false;
 
+    dynamicBufferStats = itModel->second.dynamicVertexBuffer.getStats();
 
-        pTheVerticesFile[index] = tempVertex;
+    return true;
+}
+
+bool cVAOManager::KeepCPUGeometry(std::string fileName, bool bKeepGeometry)
+{
+    if (!bKeepGeometry)
+    {
+        this->m_set_KeepCPUGeometry.erase(fileName);
+        return true;
+    }
+
+    this->m_set_KeepCPUGeometry.insert(fileName);
+
+    std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.find(fileName);
+
+    if (itModel != this->m_map_FileName_to_Model.end() && itModel->second.drawInfo.pVertices == NULL)
+    {
+        this->m_lastError = "The geometry of " + fileName + " was already released";
+        return false;
     }
 
-    sTrianglePlyFile* pTheTriangles = new sTrianglePlyFile[drawInfo.numberOfTriangles];
+    return true;
+}
+
+std::size_t cVAOManager::ReleaseCPUGeometry(void)
+{
+    std::size_t bytesFreed = 0;
 
-    for (unsigned int index = 0; index != drawInfo.numberOfTriangles; index++)
+    for (std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.begin();
+        itModel != this->m_map_FileName_to_Model.end(); itModel++)
     {
-        sTrianglePlyFile tempTriangle;
+        if (this->m_set_KeepCPUGeometry.find(itModel->first) != this->m_set_KeepCPUGeometry.end())
+            continue;
+
+        // The dynamic buffer's updates are packed from pVertices
+        if (itModel->second.bIsDynamic)
+            continue;
+
+        sModelDrawInfo& drawInfo = itModel->second.drawInfo;
+
+        if (drawInfo.pVertices == NULL)
+            continue;
 
-        unsigned int discard;
-        theBunnyFile >> discard;
-        theBunnyFile >> tempTriangle.v0;
-        theBunnyFile >> tempTriangle.v1;
-        theBunnyFile >> tempTriangle.v2;
+        bytesFreed += sizeof(sVertex) * drawInfo.numberOfVertices + sizeof(unsigned int) * drawInfo.numberOfIndices;
 
-        pTheTriangles[index] = tempTriangle;
+        delete[] drawInfo.pVertices;
+        drawInfo.pVertices = NULL;
+
+        delete[] drawInfo.pIndices;
+        drawInfo.pIndices = NULL;
     }
 
-    drawInfo.pVertices = new sVertex[drawInfo.numberOfVertices];
-    for (unsigned int vertIndex = 0; vertIndex != drawInfo.numberOfVertices; vertIndex++)
+    return bytesFreed;
+}
+
+void cVAOManager::GetMemoryUsage(std::size_t& gpuBytes, std::size_t& cpuBytes, unsigned int& numberOfModels)
+{
+    gpuBytes = 0;
+    cpuBytes = 0;
+    numberOfModels = 0;
+
+    for (std::map< std::string, sSharedModel>::iterator itModel = this->m_map_FileName_to_Model.begin();
+        itModel != this->m_map_FileName_to_Model.end(); itModel++)
     {
-        drawInfo.pVertices[vertIndex].x = pTheVerticesFile[vertIndex].x;
-        drawInfo.pVertices[vertIndex].y = pTheVerticesFile[vertIndex].y;
-        drawInfo.pVertices[vertIndex].z = pTheVerticesFile[vertIndex].z;
-        drawInfo.pVertices[vertIndex].w = 1.0f;
+        const sModelDrawInfo& drawInfo = itModel->second.drawInfo;
+
+        gpuBytes += drawInfo.vertexStride * drawInfo.numberOfVertices + drawInfo.indexSize * drawInfo.numberOfIndices;
 
+        // The ring holds a copy of the vertices per region
+        if (itModel->second.bIsDynamic && itModel->second.dynamicVertexBuffer.getStrategy() == DYNAMIC_BUFFER_PERSISTENT_RING)
+            gpuBytes += drawInfo.vertexStride * drawInfo.numberOfVertices * (cDynamicVertexBuffer::REGIONS - 1);
 
-        drawInfo.pVertices[vertIndex].nx = pTheVerticesFile[vertIndex].nx;
-        drawInfo.pVertices[vertIndex].ny = pTheVerticesFile[vertIndex].ny;
-        drawInfo.pVertices[vertIndex].nz = pTheVerticesFile[vertIndex].nz;
-        drawInfo.pVertices[vertIndex].nw = 1.0f;
+        cpuBytes += sizeof(sSharedModel);
 
-        drawInfo.pVertices[vertIndex].r = pTheVerticesFile[vertIndex].r;
-        drawInfo.pVertices[vertIndex].g = pTheVerticesFile[vertIndex].g;
-        drawInfo.pVertices[vertIndex].b = pTheVerticesFile[vertIndex].b;
-        drawInfo.pVertices[vertIndex].a = pTheVerticesFile[vertIndex].a;
+        if (drawInfo.pVertices != NULL)
+            cpuBytes += sizeof(sVertex) * drawInfo.numberOfVertices + sizeof(unsigned int) * drawInfo.numberOfIndices;
+
+        numberOfModels++;
     }
 
-    drawInfo.pIndices = new unsigned int[drawInfo.numberOfIndices];
+    return;
+}
 
-    unsigned int elementIndex = 0;
+bool cVAOManager::m_LoadTheFile_Ply(std::string theFileName, sModelDrawInfo& drawInfo, std::string& errorText)
+{
+    // The whole file is mapped and parsed in place (no iostream extraction)
+    cMappedFile theMappedFile;
 
-    for (unsigned int triIndex = 0; triIndex != drawInfo.numberOfTriangles; triIndex++)
+    if (!theMappedFile.Open(theFileName))
     {
-        drawInfo.pIndices[elementIndex + 0] = pTheTriangles[triIndex].v0;
-        drawInfo.pIndices[elementIndex + 1] = pTheTriangles[triIndex].v1;
-        drawInfo.pIndices[elementIndex + 2] = pTheTriangles[triIndex].v2;
+        errorText = "Can't open the file : " + theFileName;
+        return false;
+    }
+
+    cPlyFileReader thePlyReader;
 
-        elementIndex += 3;
+    if (!thePlyReader.ParseHeader(theMappedFile.getData(), theMappedFile.getSize()))
+    {
+        errorText = "Invalid PLY header in : " + theFileName + " (" + thePlyReader.getLastError() + ")";
+        return false;
+    }
+
+    if (!thePlyReader.DecodeMesh(drawInfo))
+    {
+        errorText = "Can't decode : " + theFileName + " (" + thePlyReader.getLastError() + ")";
+        return false;
     }
 
     return true;
@@ -3,8 +3,13 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <cstddef>
 
 #include "sModelDrawInfo.h"
+#include "cGLResource.h"
+#include "cGeometryArena.h"
+#include "cDynamicVertexBuffer.h"
 
 class cVAOManager
 {
@@ -15,24 +20,162 @@ public:
 		unsigned int shaderProgramID,
 		bool bIsDynamicBuffer = false);
 
+	// LoadModelIntoVAO in two halves, so files can be decoded off the main thread :
+	// ReadModelFile fills drawInfo's arrays from the cooked file or the .ply. It doesn't
+	//	touch GL or change the manager, so it's safe to call from several threads at once.
+	bool ReadModelFile(std::string fileName, sModelDrawInfo& drawInfo, std::string& errorText);
+
+	// UploadModelToVAO creates the VAO and buffers from those arrays and registers the
+	//	file (main thread only, it needs the GL context)
+	bool UploadModelToVAO(std::string fileName, sModelDrawInfo& drawInfo,
+		unsigned int shaderProgramID,
+		bool bIsDynamicBuffer = false);
+
 	bool FindDrawInfoByModelName(std::string filename,
 		sModelDrawInfo& drawInfo);
 
+	//-------------------Shared Mesh Registry-----------------
+
+	// Every model using the same file shares one draw info (and one VAO / VBO / IBO).
+	// The file is loaded on the first acquire; the returned pointer stays valid until
+	//	the last reference is released.
+	// bIsDynamicBuffer only matters to the first acquire (the one that loads the file).
+	sModelDrawInfo* AcquireModel(std::string fileName, unsigned int shaderProgramID, bool bIsDynamicBuffer = false);
+
+	// Frees the GL buffers and the vertex / index arrays once nobody uses the file
+	void ReleaseModel(std::string fileName);
+
+	unsigned int getModelReferenceCount(std::string fileName);
+
+	//-------------------CPU Geometry-----------------
+
+	// Once a file is on the GPU its vertex / index arrays are only needed by code that
+	//	reads the triangles (plane physics, GetModelVertices). Files marked here keep them.
+	// Returns false if the arrays of an already loaded file were released earlier.
+	bool KeepCPUGeometry(std::string fileName, bool bKeepGeometry = true);
+
+	// Frees pVertices / pIndices of every loaded file not marked with KeepCPUGeometry
+	//	(they become NULL for every mesh sharing the file). Returns the bytes freed.
+	std::size_t ReleaseCPUGeometry(void);
+
+	// Totals over every loaded file (vertex + index data only)
+	void GetMemoryUsage(std::size_t& gpuBytes, std::size_t& cpuBytes, unsigned int& numberOfModels);
+
 	std::string getLastError(bool bAndClear = true);
 
 	void setBasePath(std::string basePathWithoutSlash);
 
-	/*bool UpdateVAOBuffers(std::string fileName,
-		sModelDrawInfo& updatedDrawInfo,
-		unsigned int shaderProgramID);*/
+	// Layout used for files loaded from now on (already loaded files keep theirs)
+	void setVertexFormat(eVertexFormat vertexFormat);
+
+	eVertexFormat getVertexFormat(void);
+
+	// Vertex cache / overdraw / vertex fetch reordering of files loaded from now on
+	//	(cMeshOptimizer). On by default.
+	void setOptimizeMeshes(bool bOptimizeMeshes);
+
+	// Meshes with more than 65536 vertices get 16 bit indices by being drawn in
+	//	pieces (sModelDrawInfo::vecSubMeshes). On by default; off keeps them 32 bit.
+	void setSplitLargeMeshes(bool bSplitLargeMeshes);
+
+	// Simplified levels of detail (cMeshSimplifier) for files loaded from now on,
+	//	in sModelDrawInfo::vecLODs. On by default.
+	void setGenerateLODs(bool bGenerateLODs);
+
+	//-------------------Geometry Arena-----------------
+
+	// Static (not dynamic) files loaded from now on go into the shared buffers of
+	//	their vertex format's cGeometryArena instead of buffers of their own. On by default.
+	void setUseGeometryArena(bool bUseGeometryArena);
+
+	// Packs the arenas whose free space is at least minFragmentation fragmented
+	//	(see sGeometryArenaStats) with at least minWastedBytes outside the largest
+	//	free block. Copies every mesh in the arena, so not something to call per unload.
+	//	Returns the number of arenas compacted.
+	unsigned int CompactGeometryArenas(float minFragmentation = 0.25f, std::size_t minWastedBytes = 1024 * 1024);
+
+	// All the arenas added together (fragmentation is the worst one's)
+	sGeometryArenaStats GetGeometryArenaStats(void);
+
+	//-------------------Dynamic Buffers-----------------
+
+	// How dynamic files loaded from now on update their vertex buffer. The default is
+	//	the persistent mapped ring (it falls back to orphaning below GL 4.4).
+	void setDynamicBufferStrategy(eDynamicBufferStrategy dynamicBufferStrategy);
+
+	eDynamicBufferStrategy getDynamicBufferStrategy(void);
+
+	// Copies updatedDrawInfo.pVertices (numberOfVertices must match, in the loaded
+	//	file's vertex order) over the dynamic file's vertices and uploads all of them.
+	// The indices and extents don't change. updatedDrawInfo gets the new VertexBuffer_Start_Index.
+	bool UpdateVAOBuffers(std::string fileName,
+		sModelDrawInfo& updatedDrawInfo);
+
+	// Uploads vertices [firstVertex, firstVertex + numberOfVertices) of the dynamic file.
+	//	pVertices holds just that range; if it points into the file's own pVertices (edited
+	//	in place through the shared sModelDrawInfo) nothing is copied.
+	bool UpdateVAOBufferRange(std::string fileName, const sVertex* pVertices,
+		unsigned int firstVertex, unsigned int numberOfVertices);
+
+	// Of a dynamic file, false if it isn't loaded or isn't dynamic
+	bool GetDynamicBufferStats(std::string fileName, sDynamicBufferStats& dynamicBufferStats);
 
 private:
 
-	bool m_LoadTheFile_Ply_XYZ_N_RGBA(std::string theFileName, sModelDrawInfo& drawInfo);
+	// Reads ascii or binary PLY files with any vertex property layout
+	bool m_LoadTheFile_Ply(std::string theFileName, sModelDrawInfo& drawInfo, std::string& errorText);
+
+	struct sSharedModel
+	{
+		sSharedModel();
+
+		sModelDrawInfo drawInfo;
+		unsigned int referenceCount;
+
+		// In m_geometryArenas[drawInfo.vertexFormat], or INVALID_ALLOCATION if the
+		//	model has its own buffers
+		unsigned int arenaAllocationID;
+
+		// Own the names stored in drawInfo (VAO_ID, VertexBufferID, IndexBufferID) of models
+		//	outside the arena, deleted when the entry is erased
+		cGLVertexArray vertexArray;
+		cGLBuffer vertexBuffer;
+		cGLBuffer indexBuffer;
+
+		// Loaded with bIsDynamicBuffer : the vertex buffer is dynamicVertexBuffer's and
+		//	pVertices is never released (it's what the updates are packed from)
+		bool bIsDynamic;
+		cDynamicVertexBuffer dynamicVertexBuffer;
+	};
 
-	std::map< std::string, sModelDrawInfo> m_map_ModelName_to_VAOID;
+	// Copies the arena offsets / buffer names into every arena model's drawInfo
+	//	(they change when an arena grows or is compacted)
+	void m_UpdateArenaDrawInfo(void);
+
+	// Keyed by file name (as passed in, without the base path)
+	std::map< std::string, sSharedModel> m_map_FileName_to_Model;
+
+	// Files whose CPU arrays survive ReleaseCPUGeometry (loaded or not)
+	std::set< std::string > m_set_KeepCPUGeometry;
 
 	std::string m_basePathWithoutSlash;
+
+	eVertexFormat m_vertexFormat = VERTEX_FORMAT_COMPACT;
+
+	bool m_bOptimizeMeshes = true;
+
+	bool m_bSplitLargeMeshes = true;
+
+	bool m_bGenerateLODs = true;
+
+	bool m_bUseGeometryArena = true;
+
+	eDynamicBufferStrategy m_dynamicBufferStrategy = DYNAMIC_BUFFER_PERSISTENT_RING;
+
+	// One per eVertexFormat
+	cGeometryArena m_geometryArenas[3];
+
+	std::string m_lastError;
 };
 
 #endif
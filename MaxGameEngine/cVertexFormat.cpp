@@ -0,0 +1,285 @@
+#include "cVertexFormat.h"
+
+#include "../OpenGLCommon.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+unsigned int cVertexFormat::getStride(eVertexFormat vertexFormat)
+{
+	switch (vertexFormat)
+	{
+	case VERTEX_FORMAT_COMPACT:
+		return sizeof(sVertex_Compact);
+
+	case VERTEX_FORMAT_COMPACT_HALF:
+		return sizeof(sVertex_CompactHalf);
+
+	default:
+		return sizeof(sVertex);
+	}
+}
+
+const char* cVertexFormat::getName(eVertexFormat vertexFormat)
+{
+	switch (vertexFormat)
+	{
+	case VERTEX_FORMAT_COMPACT:
+		return "Compact";
+
+	case VERTEX_FORMAT_COMPACT_HALF:
+		return "CompactHalf";
+
+	default:
+		return "Float";
+	}
+}
+
+static unsigned char PackColourChannel(float value)
+{
+	if (value <= 0.0f)
+		return 0;
+
+	if (value >= 1.0f)
+		return 255;
+
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+void cVertexFormat::PackVertices(eVertexFormat vertexFormat, sModelDrawInfo& drawInfo)
+{
+	drawInfo.vertexFormat = vertexFormat;
+	drawInfo.vertexStride = cVertexFormat::getStride(vertexFormat);
+
+	delete[] drawInfo.pPackedVertices;
+	drawInfo.pPackedVertices = NULL;
+
+	// The float layout is sVertex itself, pVertices gets uploaded as it is
+	if (vertexFormat == VERTEX_FORMAT_FLOAT || drawInfo.pVertices == NULL)
+		return;
+
+	drawInfo.pPackedVertices = new unsigned char[drawInfo.vertexStride * drawInfo.numberOfVertices];
+
+	cVertexFormat::PackVertexRange(vertexFormat, drawInfo.pVertices, drawInfo.numberOfVertices, drawInfo.pPackedVertices);
+
+	return;
+}
+
+void cVertexFormat::PackVertexRange(eVertexFormat vertexFormat, const sVertex* pVertices, unsigned int numberOfVertices, void* pDestination)
+{
+	if (vertexFormat == VERTEX_FORMAT_FLOAT)
+	{
+		memcpy(pDestination, pVertices, sizeof(sVertex) * numberOfVertices);
+		return;
+	}
+
+	for (unsigned int index = 0; index != numberOfVertices; index++)
+	{
+		const sVertex& vertex = pVertices[index];
+
+		glm::vec3 normal = glm::vec3(vertex.nx, vertex.ny, vertex.nz);
+
+		float normalLength = glm::length(normal);
+
+		if (normalLength > 0.0f)
+			normal /= normalLength;
+
+		unsigned int packedNormal = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+
+		if (vertexFormat == VERTEX_FORMAT_COMPACT)
+		{
+			sVertex_Compact* pPacked = reinterpret_cast<sVertex_Compact*>(pDestination) + index;
+
+			pPacked->x = vertex.x;
+			pPacked->y = vertex.y;
+			pPacked->z = vertex.z;
+			pPacked->normal = packedNormal;
+			pPacked->r = PackColourChannel(vertex.r);
+			pPacked->g = PackColourChannel(vertex.g);
+			pPacked->b = PackColourChannel(vertex.b);
+			pPacked->a = PackColourChannel(vertex.a);
+		}
+		else
+		{
+			sVertex_CompactHalf* pPacked = reinterpret_cast<sVertex_CompactHalf*>(pDestination) + index;
+
+			pPacked->x = glm::packHalf1x16(vertex.x);
+			pPacked->y = glm::packHalf1x16(vertex.y);
+			pPacked->z = glm::packHalf1x16(vertex.z);
+			pPacked->padding = 0;
+			pPacked->normal = packedNormal;
+			pPacked->r = PackColourChannel(vertex.r);
+			pPacked->g = PackColourChannel(vertex.g);
+			pPacked->b = PackColourChannel(vertex.b);
+			pPacked->a = PackColourChannel(vertex.a);
+		}
+	}
+
+	return;
+}
+
+void cVertexFormat::PackIndices(bool bAllowSubMeshes, sModelDrawInfo& drawInfo)
+{
+	drawInfo.indexType = INDEX_TYPE_UINT32;
+	drawInfo.indexSize = sizeof(unsigned int);
+	drawInfo.vecSubMeshes.clear();
+
+	for (unsigned int lodIndex = 0; lodIndex != drawInfo.vecLODs.size(); lodIndex++)
+	{
+		drawInfo.vecLODs[lodIndex].firstSubMesh = 0;
+		drawInfo.vecLODs[lodIndex].numberOfSubMeshes = 0;
+	}
+
+	delete[] drawInfo.pPackedIndices;
+	drawInfo.pPackedIndices = NULL;
+
+	if (drawInfo.pIndices == NULL || drawInfo.numberOfIndices == 0)
+		return;
+
+	if (drawInfo.numberOfVertices <= MAX_16BIT_VERTICES)
+	{
+		drawInfo.pPackedIndices = new unsigned short[drawInfo.numberOfIndices];
+
+		for (unsigned int index = 0; index != drawInfo.numberOfIndices; index++)
+			drawInfo.pPackedIndices[index] = (unsigned short)drawInfo.pIndices[index];
+
+		drawInfo.indexType = INDEX_TYPE_UINT16;
+		drawInfo.indexSize = sizeof(unsigned short);
+
+		return;
+	}
+
+	if (!bAllowSubMeshes)
+		return;
+
+	// Triangles are taken in order, a new sub mesh starts whenever the vertices used
+	//	so far plus the next triangle's no longer fit in a 65536 vertex window.
+	//	Works well on meshes in first-use vertex order (see cMeshOptimizer); badly
+	//	ordered ones need too many pieces and stay 32 bit.
+	// Each LOD starts a new sub mesh so it can be drawn on its own.
+	std::vector<sSubMesh> vecSubMeshes;
+
+	unsigned int nextLOD = 1;
+
+	unsigned int windowLowest = 0;
+	unsigned int windowHighest = 0;
+
+	sSubMesh currentSubMesh;
+	currentSubMesh.firstIndex = 0;
+	currentSubMesh.numberOfIndices = 0;
+	currentSubMesh.baseVertex = 0;
+
+	for (unsigned int index = 0; index + 2 < drawInfo.numberOfIndices; index += 3)
+	{
+		const unsigned int* pTriangle = &(drawInfo.pIndices[index]);
+
+		unsigned int lowestVertex = std::min(pTriangle[0], std::min(pTriangle[1], pTriangle[2]));
+		unsigned int highestVertex = std::max(pTriangle[0], std::max(pTriangle[1], pTriangle[2]));
+
+		bool bIsLODStart = (nextLOD < drawInfo.vecLODs.size() && index == drawInfo.vecLODs[nextLOD].firstIndex);
+
+		if (bIsLODStart)
+			nextLOD++;
+
+		if (currentSubMesh.numberOfIndices != 0 &&
+			(bIsLODStart || std::max(windowHighest, highestVertex) - std::min(windowLowest, lowestVertex) >= MAX_16BIT_VERTICES))
+		{
+			currentSubMesh.baseVertex = windowLowest;
+			vecSubMeshes.push_back(currentSubMesh);
+
+			currentSubMesh.firstIndex = index;
+			currentSubMesh.numberOfIndices = 0;
+		}
+
+		if (currentSubMesh.numberOfIndices == 0)
+		{
+			windowLowest = lowestVertex;
+			windowHighest = highestVertex;
+		}
+
+		windowLowest = std::min(windowLowest, lowestVertex);
+		windowHighest = std::max(windowHighest, highestVertex);
+
+		// A single triangle wider than the window, or far too many pieces
+		if (windowHighest - windowLowest >= MAX_16BIT_VERTICES || vecSubMeshes.size() >= MAX_SUB_MESHES)
+			return;
+
+		currentSubMesh.numberOfIndices += 3;
+	}
+
+	currentSubMesh.baseVertex = windowLowest;
+	vecSubMeshes.push_back(currentSubMesh);
+
+	drawInfo.pPackedIndices = new unsigned short[drawInfo.numberOfIndices];
+
+	for (unsigned int subMeshIndex = 0; subMeshIndex != vecSubMeshes.size(); subMeshIndex++)
+	{
+		const sSubMesh& subMesh = vecSubMeshes[subMeshIndex];
+
+		for (unsigned int index = subMesh.firstIndex; index != subMesh.firstIndex + subMesh.numberOfIndices; index++)
+			drawInfo.pPackedIndices[index] = (unsigned short)(drawInfo.pIndices[index] - subMesh.baseVertex);
+	}
+
+	for (unsigned int lodIndex = 0; lodIndex != drawInfo.vecLODs.size(); lodIndex++)
+	{
+		sMeshLOD& lod = drawInfo.vecLODs[lodIndex];
+
+		lod.firstSubMesh = (unsigned int)vecSubMeshes.size();
+
+		for (unsigned int subMeshIndex = 0; subMeshIndex != vecSubMeshes.size(); subMeshIndex++)
+		{
+			if (vecSubMeshes[subMeshIndex].firstIndex < lod.firstIndex ||
+				vecSubMeshes[subMeshIndex].firstIndex >= lod.firstIndex + lod.numberOfIndices)
+				continue;
+
+			lod.firstSubMesh = std::min(lod.firstSubMesh, subMeshIndex);
+			lod.numberOfSubMeshes++;
+		}
+	}
+
+	drawInfo.vecSubMeshes = vecSubMeshes;
+	drawInfo.indexType = INDEX_TYPE_UINT16;
+	drawInfo.indexSize = sizeof(unsigned short);
+
+	return;
+}
+
+void cVertexFormat::SetupAttributes(eVertexFormat vertexFormat, unsigned int shaderProgramID)
+{
+	GLint vpos_location = glGetAttribLocation(shaderProgramID, "vPos");
+	GLint vcol_location = glGetAttribLocation(shaderProgramID, "vCol");
+	GLint vNormal_location = glGetAttribLocation(shaderProgramID, "vNormal");
+
+	GLsizei stride = (GLsizei)cVertexFormat::getStride(vertexFormat);
+
+	glEnableVertexAttribArray(vpos_location);
+	glEnableVertexAttribArray(vcol_location);
+	glEnableVertexAttribArray(vNormal_location);
+
+	switch (vertexFormat)
+	{
+	case VERTEX_FORMAT_COMPACT:
+		glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(sVertex_Compact, x));
+		glVertexAttribPointer(vNormal_location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(sVertex_Compact, normal));
+		glVertexAttribPointer(vcol_location, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(sVertex_Compact, r));
+		break;
+
+	case VERTEX_FORMAT_COMPACT_HALF:
+		glVertexAttribPointer(vpos_location, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(sVertex_CompactHalf, x));
+		glVertexAttribPointer(vNormal_location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(sVertex_CompactHalf, normal));
+		glVertexAttribPointer(vcol_location, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(sVertex_CompactHalf, r));
+		break;
+
+	default:
+		glVertexAttribPointer(vpos_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(sVertex, x));
+		glVertexAttribPointer(vNormal_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(sVertex, nx));
+		glVertexAttribPointer(vcol_location, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(sVertex, r));
+		break;
+	}
+
+	return;
+}
@@ -0,0 +1,55 @@
+#ifndef _cVertexFormat_HG_
+#define _cVertexFormat_HG_
+
+#include "sModelDrawInfo.h"
+
+// GPU side vertex and index layouts. The loaders always produce sVertex and 32 bit
+//	indices (pVertices, pIndices); these are what actually goes into the buffers.
+
+// VERTEX_FORMAT_COMPACT : 20 bytes
+struct sVertex_Compact
+{
+	float x, y, z;
+	unsigned int normal;		// GL_INT_2_10_10_10_REV (x in the low bits)
+	unsigned char r, g, b, a;
+};
+
+// VERTEX_FORMAT_COMPACT_HALF : 16 bytes
+struct sVertex_CompactHalf
+{
+	unsigned short x, y, z;		// Half floats
+	unsigned short padding;
+	unsigned int normal;
+	unsigned char r, g, b, a;
+};
+
+class cVertexFormat
+{
+public:
+
+	static unsigned int getStride(eVertexFormat vertexFormat);
+
+	static const char* getName(eVertexFormat vertexFormat);
+
+	// Sets vertexFormat / vertexStride and, for the packed formats, fills
+	//	pPackedVertices from pVertices. No GL calls, so it's fine on a worker thread.
+	static void PackVertices(eVertexFormat vertexFormat, sModelDrawInfo& drawInfo);
+
+	// numberOfVertices of pVertices in vertexFormat's layout, written to pDestination
+	//	(a buffer or mapped GL memory of getStride * numberOfVertices bytes)
+	static void PackVertexRange(eVertexFormat vertexFormat, const sVertex* pVertices,
+		unsigned int numberOfVertices, void* pDestination);
+
+	// Meshes with up to 65536 vertices get a 16 bit index buffer (pPackedIndices).
+	// Bigger ones are split into 16 bit sub meshes if bAllowSubMeshes is set and it
+	//	takes no more than MAX_SUB_MESHES draws, otherwise they stay 32 bit.
+	static void PackIndices(bool bAllowSubMeshes, sModelDrawInfo& drawInfo);
+
+	static const unsigned int MAX_16BIT_VERTICES = 65536;
+	static const unsigned int MAX_SUB_MESHES = 64;
+
+	// glVertexAttribPointer calls for the bound VAO / vertex buffer
+	static void SetupAttributes(eVertexFormat vertexFormat, unsigned int shaderProgramID);
+};
+
+#endif
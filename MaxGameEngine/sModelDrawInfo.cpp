@@ -1,5 +1,9 @@
 #include "sModelDrawInfo.h"
 
+#include <cmath>
+
+#include "SSECommon.h"
+
 unsigned int sModelDrawInfo::m_nextUniqueID = sModelDrawInfo::FIRST_UNIQUE_ID;
 
 sModelDrawInfo::sModelDrawInfo()
@@ -18,30 +22,136 @@ sModelDrawInfo::sModelDrawInfo()
 	this->pVertices = 0;
 	this->pIndices = 0;
 
+	this->vertexFormat = VERTEX_FORMAT_FLOAT;
+	this->vertexStride = sizeof(sVertex);
+	this->pPackedVertices = 0;
+
+	this->indexType = INDEX_TYPE_UINT32;
+	this->indexSize = sizeof(unsigned int);
+	this->pPackedIndices = 0;
+
+	this->bIsOptimized = false;
+	this->cacheStatsBefore.ACMR = this->cacheStatsBefore.ATVR = 0.0f;
+	this->cacheStatsAfter = this->cacheStatsBefore;
+
 	this->maxExtents_XYZ = glm::vec3(0.0f);
 	this->minExtents_XYZ = glm::vec3(0.0f);
 	this->deltaExtents_XYZ = glm::vec3(0.0f);
 
 	this->maxExtent = 0.0f;
 
+	this->boundingSphereCentre = glm::vec3(0.0f);
+	this->boundingSphereRadius = 0.0f;
+
 	this->m_UniqueID = sModelDrawInfo::m_nextUniqueID;
 	sModelDrawInfo::m_nextUniqueID++;
 
 	return;
 }
 
-unsigned int sModelDrawInfo::getUniqueID(void)
+unsigned int sModelDrawInfo::getNumberOfLODs(void) const
+{
+	if (this->vecLODs.empty())
+		return 1;
+
+	return (unsigned int)this->vecLODs.size();
+}
+
+sMeshLOD sModelDrawInfo::getLOD(unsigned int lodIndex) const
+{
+	if (this->vecLODs.empty())
+	{
+		sMeshLOD wholeMesh;
+		wholeMesh.firstIndex = 0;
+		wholeMesh.numberOfIndices = this->numberOfIndices;
+		wholeMesh.error = 0.0f;
+		wholeMesh.firstSubMesh = 0;
+		wholeMesh.numberOfSubMeshes = (unsigned int)this->vecSubMeshes.size();
+
+		return wholeMesh;
+	}
+
+	if (lodIndex >= this->vecLODs.size())
+		lodIndex = (unsigned int)this->vecLODs.size() - 1;
+
+	return this->vecLODs[lodIndex];
+}
+
+unsigned int sModelDrawInfo::getUniqueID(void) const
 {
 	return this->m_UniqueID;
 }
 
+// Ritter's step: if the point is outside, move the sphere towards it just far enough
+//	that the old sphere and the point are both inside the new one
+void sModelDrawInfo::m_GrowSphere(glm::vec3& centre, float& radius, const glm::vec3& point)
+{
+	glm::vec3 toPoint = point - centre;
+
+	float distanceSquared = glm::dot(toPoint, toPoint);
+
+	if (distanceSquared <= radius * radius)
+	{
+		return;
+	}
+
+	float distance = sqrtf(distanceSquared);
+	float newRadius = (radius + distance) * 0.5f;
+
+	centre += toPoint * ((newRadius - radius) / distance);
+	radius = newRadius;
+
+	return;
+}
+
 void sModelDrawInfo::calcExtents(void)
 {
-	if (this->pVertices == NULL)
+	if (this->pVertices == NULL || this->numberOfVertices == 0)
 	{
 		return;
 	}
 
+	//-------------------Axis aligned box-----------------
+
+	// Which vertex is lowest / highest on each axis, for the sphere below
+	unsigned int minVertIndex[4] = { 0, 0, 0, 0 };
+	unsigned int maxVertIndex[4] = { 0, 0, 0, 0 };
+
+#if ENGINE_USE_SSE
+	// sVertex starts with x, y, z, w so a vertex is a single 4 float load
+	__m128 minXYZW = _mm_loadu_ps(&(this->pVertices[0].x));
+	__m128 maxXYZW = minXYZW;
+
+	__m128i minIndices = _mm_setzero_si128();
+	__m128i maxIndices = _mm_setzero_si128();
+
+	for (unsigned int vertIndex = 1; vertIndex < this->numberOfVertices; vertIndex++)
+	{
+		__m128 position = _mm_loadu_ps(&(this->pVertices[vertIndex].x));
+		__m128i currentIndex = _mm_set1_epi32((int)vertIndex);
+
+		__m128i lowerMask = _mm_castps_si128(_mm_cmplt_ps(position, minXYZW));
+		__m128i higherMask = _mm_castps_si128(_mm_cmpgt_ps(position, maxXYZW));
+
+		minIndices = _mm_or_si128(_mm_and_si128(lowerMask, currentIndex), _mm_andnot_si128(lowerMask, minIndices));
+		maxIndices = _mm_or_si128(_mm_and_si128(higherMask, currentIndex), _mm_andnot_si128(higherMask, maxIndices));
+
+		minXYZW = _mm_min_ps(minXYZW, position);
+		maxXYZW = _mm_max_ps(maxXYZW, position);
+	}
+
+	float minValues[4];
+	float maxValues[4];
+
+	_mm_storeu_ps(minValues, minXYZW);
+	_mm_storeu_ps(maxValues, maxXYZW);
+
+	_mm_storeu_si128((__m128i*)minVertIndex, minIndices);
+	_mm_storeu_si128((__m128i*)maxVertIndex, maxIndices);
+
+	this->minExtents_XYZ = glm::vec3(minValues[0], minValues[1], minValues[2]);
+	this->maxExtents_XYZ = glm::vec3(maxValues[0], maxValues[1], maxValues[2]);
+#else
 	sVertex* pCurrentVert = &(this->pVertices[0]);
 
 	this->minExtents_XYZ.x = pCurrentVert->x;
@@ -56,15 +166,16 @@ void sModelDrawInfo::calcExtents(void)
 	{
 		sVertex* pCurrentVert = &(this->pVertices[vertIndex]);
 
-		if (pCurrentVert->x < this->minExtents_XYZ.x) { this->minExtents_XYZ.x = pCurrentVert->x; }
-		if (pCurrentVert->y < this->minExtents_XYZ.y) { this->minExtents_XYZ.y = pCurrentVert->y; }
-		if (pCurrentVert->z < this->minExtents_XYZ.z) { this->minExtents_XYZ.z = pCurrentVert->z; }
+		if (pCurrentVert->x < this->minExtents_XYZ.x) { this->minExtents_XYZ.x = pCurrentVert->x; minVertIndex[0] = vertIndex; }
+		if (pCurrentVert->y < this->minExtents_XYZ.y) { this->minExtents_XYZ.y = pCurrentVert->y; minVertIndex[1] = vertIndex; }
+		if (pCurrentVert->z < this->minExtents_XYZ.z) { this->minExtents_XYZ.z = pCurrentVert->z; minVertIndex[2] = vertIndex; }
 
-		if (pCurrentVert->x > this->maxExtents_XYZ.x) { this->maxExtents_XYZ.x = pCurrentVert->x; }
-		if (pCurrentVert->y > this->maxExtents_XYZ.y) { this->maxExtents_XYZ.y = pCurrentVert->y; }
-		if (pCurrentVert->z > this->maxExtents_XYZ.z) { this->maxExtents_XYZ.z = pCurrentVert->z; }
+		if (pCurrentVert->x > this->maxExtents_XYZ.x) { this->maxExtents_XYZ.x = pCurrentVert->x; maxVertIndex[0] = vertIndex; }
+		if (pCurrentVert->y > this->maxExtents_XYZ.y) { this->maxExtents_XYZ.y = pCurrentVert->y; maxVertIndex[1] = vertIndex; }
+		if (pCurrentVert->z > this->maxExtents_XYZ.z) { this->maxExtents_XYZ.z = pCurrentVert->z; maxVertIndex[2] = vertIndex; }
 
 	}
+#endif
 
 	this->deltaExtents_XYZ.x = this->maxExtents_XYZ.x - this->minExtents_XYZ.x;
 	this->deltaExtents_XYZ.y = this->maxExtents_XYZ.y - this->minExtents_XYZ.y;
@@ -74,5 +185,135 @@ void sModelDrawInfo::calcExtents(void)
 	if (this->maxExtent < this->deltaExtents_XYZ.y) { this->maxExtent = this->deltaExtents_XYZ.y; }
 	if (this->maxExtent < this->deltaExtents_XYZ.z) { this->maxExtent = this->deltaExtents_XYZ.z; }
 
+	//-------------------Bounding sphere-----------------
+
+	// Ritter's sphere: start from the two axis extremes that are farthest apart, then grow
+	//	it to take in every vertex left outside. Usually within a few percent of the tightest
+	//	sphere, where one centred on the box can be much bigger for a lopsided mesh.
+	glm::vec3 sphereCentre = glm::vec3(0.0f);
+	float sphereRadiusSquared = -1.0f;
+
+	for (unsigned int axis = 0; axis != 3; axis++)
+	{
+		const sVertex& minVertex = this->pVertices[minVertIndex[axis]];
+		const sVertex& maxVertex = this->pVertices[maxVertIndex[axis]];
+
+		glm::vec3 minPoint = glm::vec3(minVertex.x, minVertex.y, minVertex.z);
+		glm::vec3 maxPoint = glm::vec3(maxVertex.x, maxVertex.y, maxVertex.z);
+
+		float halfSpanSquared = glm::dot(maxPoint - minPoint, maxPoint - minPoint) * 0.25f;
+
+		if (halfSpanSquared > sphereRadiusSquared)
+		{
+			sphereCentre = (minPoint + maxPoint) * 0.5f;
+			sphereRadiusSquared = halfSpanSquared;
+		}
+	}
+
+	float sphereRadius = sqrtf(sphereRadiusSquared);
+
+	// The same pass also finds the sphere around the box's centre, which is kept if it's smaller
+	glm::vec3 boxCentre = (this->minExtents_XYZ + this->maxExtents_XYZ) * 0.5f;
+
+	float boxRadiusSquared = 0.0f;
+
+	unsigned int vertIndex = 0;
+
+#if ENGINE_USE_SSE
+	// Four vertices at a time, transposed so each register holds one axis
+	__m128 boxCentreX = _mm_set1_ps(boxCentre.x);
+	__m128 boxCentreY = _mm_set1_ps(boxCentre.y);
+	__m128 boxCentreZ = _mm_set1_ps(boxCentre.z);
+
+	__m128 sphereCentreX = _mm_set1_ps(sphereCentre.x);
+	__m128 sphereCentreY = _mm_set1_ps(sphereCentre.y);
+	__m128 sphereCentreZ = _mm_set1_ps(sphereCentre.z);
+	__m128 sphereRadiiSquared = _mm_set1_ps(sphereRadiusSquared);
+
+	__m128 boxDistances = _mm_setzero_ps();
+
+	for (; vertIndex + 4 <= this->numberOfVertices; vertIndex += 4)
+	{
+		__m128 axisX = _mm_loadu_ps(&(this->pVertices[vertIndex + 0].x));
+		__m128 axisY = _mm_loadu_ps(&(this->pVertices[vertIndex + 1].x));
+		__m128 axisZ = _mm_loadu_ps(&(this->pVertices[vertIndex + 2].x));
+		__m128 axisW = _mm_loadu_ps(&(this->pVertices[vertIndex + 3].x));
+
+		_MM_TRANSPOSE4_PS(axisX, axisY, axisZ, axisW);
+
+		__m128 deltaX = _mm_sub_ps(axisX, boxCentreX);
+		__m128 deltaY = _mm_sub_ps(axisY, boxCentreY);
+		__m128 deltaZ = _mm_sub_ps(axisZ, boxCentreZ);
+
+		__m128 distances = _mm_add_ps(_mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY)), _mm_mul_ps(deltaZ, deltaZ));
+
+		boxDistances = _mm_max_ps(boxDistances, distances);
+
+		deltaX = _mm_sub_ps(axisX, sphereCentreX);
+		deltaY = _mm_sub_ps(axisY, sphereCentreY);
+		deltaZ = _mm_sub_ps(axisZ, sphereCentreZ);
+
+		distances = _mm_add_ps(_mm_add_ps(_mm_mul_ps(deltaX, deltaX), _mm_mul_ps(deltaY, deltaY)), _mm_mul_ps(deltaZ, deltaZ));
+
+		// Nearly always all inside; the few that aren't grow the sphere one at a time
+		int outsideMask = _mm_movemask_ps(_mm_cmpgt_ps(distances, sphereRadiiSquared));
+
+		if (outsideMask == 0)
+		{
+			continue;
+		}
+
+		for (unsigned int lane = 0; lane != 4; lane++)
+		{
+			if (outsideMask & (1 << lane))
+			{
+				const sVertex& vertex = this->pVertices[vertIndex + lane];
+
+				sModelDrawInfo::m_GrowSphere(sphereCentre, sphereRadius, glm::vec3(vertex.x, vertex.y, vertex.z));
+			}
+		}
+
+		sphereCentreX = _mm_set1_ps(sphereCentre.x);
+		sphereCentreY = _mm_set1_ps(sphereCentre.y);
+		sphereCentreZ = _mm_set1_ps(sphereCentre.z);
+		sphereRadiiSquared = _mm_set1_ps(sphereRadius * sphereRadius);
+	}
+
+	float distanceValues[4];
+
+	_mm_storeu_ps(distanceValues, boxDistances);
+
+	for (unsigned int lane = 0; lane != 4; lane++)
+	{
+		if (distanceValues[lane] > boxRadiusSquared) { boxRadiusSquared = distanceValues[lane]; }
+	}
+#endif
+
+	for (; vertIndex < this->numberOfVertices; vertIndex++)
+	{
+		const sVertex& vertex = this->pVertices[vertIndex];
+
+		glm::vec3 position = glm::vec3(vertex.x, vertex.y, vertex.z);
+
+		float distanceSquared = glm::dot(position - boxCentre, position - boxCentre);
+
+		if (distanceSquared > boxRadiusSquared) { boxRadiusSquared = distanceSquared; }
+
+		sModelDrawInfo::m_GrowSphere(sphereCentre, sphereRadius, position);
+	}
+
+	float boxRadius = sqrtf(boxRadiusSquared);
+
+	if (boxRadius <= sphereRadius)
+	{
+		this->boundingSphereCentre = boxCentre;
+		this->boundingSphereRadius = boxRadius;
+	}
+	else
+	{
+		this->boundingSphereCentre = sphereCentre;
+		this->boundingSphereRadius = sphereRadius;
+	}
+
 	return;
 }
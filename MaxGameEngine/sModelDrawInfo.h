@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <glm/vec3.hpp>
 #include <string>
+#include <vector>
 
 struct sVertex
 {
@@ -11,6 +12,48 @@ struct sVertex
 	float nx, ny, nz, nw;
 };
 
+// Layout of the vertex buffer on the GPU (see cVertexFormat)
+enum eVertexFormat
+{
+	VERTEX_FORMAT_FLOAT,			// sVertex as it is (48 bytes)
+	VERTEX_FORMAT_COMPACT,			// float3 position, 10:10:10:2 normal, RGBA8 colour (20 bytes)
+	VERTEX_FORMAT_COMPACT_HALF		// Half float position, 10:10:10:2 normal, RGBA8 colour (16 bytes)
+};
+
+// Type of the GPU index buffer (see cVertexFormat::PackIndices)
+enum eIndexType
+{
+	INDEX_TYPE_UINT32,
+	INDEX_TYPE_UINT16
+};
+
+// Range of a 16 bit index buffer drawn with glDrawElementsBaseVertex
+struct sSubMesh
+{
+	unsigned int firstIndex;		// Offset into the index buffer (in indices)
+	unsigned int numberOfIndices;
+	unsigned int baseVertex;		// Added to each of the sub mesh's indices
+};
+
+// One level of detail, a range of the index buffer (see cMeshSimplifier).
+//	Every level indexes into the same vertex buffer.
+struct sMeshLOD
+{
+	unsigned int firstIndex;
+	unsigned int numberOfIndices;
+	float error;					// How far the surface may have moved from LOD 0 (model units)
+
+	unsigned int firstSubMesh;		// Its pieces in vecSubMeshes (if the mesh has any)
+	unsigned int numberOfSubMeshes;
+};
+
+// Post-transform vertex cache efficiency from a simulated FIFO cache (see cMeshOptimizer)
+struct sVertexCacheStats
+{
+	float ACMR;		// Average cache misses per triangle (0.5 is about the best, 3.0 the worst)
+	float ATVR;		// Average cache misses per vertex (1.0 is the best)
+};
+
 struct sModelDrawInfo
 {
 	sModelDrawInfo();
@@ -35,16 +78,56 @@ struct sModelDrawInfo
 
 	sVertex* pVertices;
 
+	eVertexFormat vertexFormat;
+	unsigned int vertexStride;
+
+	// pVertices in vertexFormat's layout, only kept until it's uploaded
+	unsigned char* pPackedVertices;
+
+	// pIndices is always 32 bit, this is what went into the index buffer
+	eIndexType indexType;
+	unsigned int indexSize;
+
+	// Only used by 16 bit meshes with more than 65536 vertices,
+	//	empty means one draw of the whole index buffer
+	std::vector<sSubMesh> vecSubMeshes;
+
+	// pIndices as 16 bit (relative to the sub mesh's base vertex), only kept until it's uploaded
+	unsigned short* pPackedIndices;
+
+	// LOD 0 is the mesh as loaded, the simplified levels' indices follow it in pIndices.
+	//	numberOfTriangles is LOD 0's. Empty means LOD 0 only (the whole index buffer).
+	std::vector<sMeshLOD> vecLODs;
+
+	unsigned int getNumberOfLODs(void) const;
+
+	// Clamped to the last level
+	sMeshLOD getLOD(unsigned int lodIndex) const;
+
+	// Index / vertex order was reordered by cMeshOptimizer when loaded
+	bool bIsOptimized;
+	sVertexCacheStats cacheStatsBefore;
+	sVertexCacheStats cacheStatsAfter;
+
 	glm::vec3 maxExtents_XYZ;
 	glm::vec3 minExtents_XYZ;
 	glm::vec3 deltaExtents_XYZ;
 
+	// Model space, contains every vertex. Ritter's sphere, or the one around the box's
+	//	centre when that's smaller (so never more than half the box's diagonal)
+	glm::vec3 boundingSphereCentre;
+	float boundingSphereRadius;
+
+	// Box, maxExtent and bounding sphere from pVertices (SSE when available).
+	//	Done once when the file is cooked, cooked files load them as they are.
 	void calcExtents(void);
-	unsigned int getUniqueID(void);
+	unsigned int getUniqueID(void) const;
 
 private:
 
 	unsigned int m_UniqueID;
 	static const unsigned int FIRST_UNIQUE_ID = 1;
 	static unsigned int m_nextUniqueID;
+
+	static void m_GrowSphere(glm::vec3& centre, float& radius, const glm::vec3& point);
 };
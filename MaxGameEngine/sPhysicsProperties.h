@@ -40,6 +40,9 @@ struct sPhysicsProperties
 	std::string modelName;
 	std::string physicsMeshType;
 
+	// Handle of the model it belongs to (cControlGameEngine)
+	unsigned int modelHandle = ~0u;
+
 	
 	sSpherePhysicsProperties* sphereProps = NULL;
 
@@ -0,0 +1,62 @@
+#ifndef _sShaderBlocks_HG_
+#define _sShaderBlocks_HG_
+
+#include <glm/glm.hpp>
+
+// C++ side of the std140 uniform block and the std430 storage buffers in vertexShader01.glsl /
+//	fragmentShader01.glsl. Only 4 component vectors and mat4 members, so neither layout adds
+//	padding and sizeof is the block size (cControlGameEngine::InitializeShader checks it
+//	against the linked program).
+
+// layout(binding = N) of each uniform block
+static const unsigned int UNIFORM_BINDING_PER_FRAME = 0;
+
+// layout(binding = N) of each shader storage block
+static const unsigned int STORAGE_BINDING_LIGHTS = 0;
+static const unsigned int STORAGE_BINDING_CLUSTERS = 1;			// (offset, count) per cluster, see cLightClusterGrid
+static const unsigned int STORAGE_BINDING_CLUSTER_LIGHTS = 2;	// Light indices the offsets point into
+static const unsigned int STORAGE_BINDING_INSTANCES = 3;
+
+// "PerFrame", written once per frame
+struct sPerFrameBlock
+{
+	glm::mat4 matView;
+	glm::mat4 matProjection;
+	glm::vec4 eyeLocation;
+
+	// Light clusters (cLightClusterGrid::FillPerFrameBlock)
+	glm::vec4 clusterDepthParams;	// x = near plane, y = slices / log(far / near)
+	glm::vec4 clusterTileSize;		// xy = pixels per tile
+	glm::ivec4 clusterCounts;		// xyz = clusters across, up, deep
+};
+
+// One of "Lights"' theLights (see cLight)
+struct sLightBlockEntry
+{
+	glm::vec4 position;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+	glm::vec4 atten;		// w = cLight::radius (the shader doesn't read it)
+	glm::vec4 direction;
+	glm::vec4 param1;
+	glm::vec4 param2;
+};
+
+// Start of the "Lights" storage block, followed by lightCount.x sLightBlockEntry
+//	(only the lights that are on, see cLightManager::UpdateLightBuffer)
+struct sLightBufferHeader
+{
+	glm::ivec4 lightCount;			// x = number of lights in theLights the shader uses
+};
+
+// One of "Instances"' instances, one per drawn mesh in the instance ring (cUniformBufferRing).
+//	A draw's meshes are next to each other, starting at the "instanceBase" uniform.
+struct sPerObjectBlock
+{
+	glm::mat4 matModel;
+	glm::mat4 matModel_IT;			// Inverse transpose of the model matrix
+	glm::vec4 manualColourRGBA;
+	glm::vec4 objectFlags;			// x = do not light, y = use manualColourRGBA (0 or 1)
+};
+
+#endif